@@ -2,5 +2,8 @@ export declare enum PlaybackEvent {
     Loaded = 0,
     Playing = 1,
     Finished = 2,
-    Error = 3
+    Error = 3,
+    Underrun = 4,
+    TrackChanged = 5,
+    Seeked = 6
 }
@@ -7,5 +7,8 @@ var PlaybackEvent;
     PlaybackEvent[PlaybackEvent["Playing"] = 1] = "Playing";
     PlaybackEvent[PlaybackEvent["Finished"] = 2] = "Finished";
     PlaybackEvent[PlaybackEvent["Error"] = 3] = "Error";
+    PlaybackEvent[PlaybackEvent["Underrun"] = 4] = "Underrun";
+    PlaybackEvent[PlaybackEvent["TrackChanged"] = 5] = "TrackChanged";
+    PlaybackEvent[PlaybackEvent["Seeked"] = 6] = "Seeked";
 })(PlaybackEvent = exports.PlaybackEvent || (exports.PlaybackEvent = {}));
 //# sourceMappingURL=PlaybackEvent.js.map
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "Benchmarks.h"
+
+#include <cstdint>
+#include <iostream>
+
+using namespace CasperTech::bench;
+
+static uint32_t failures = 0;
+
+void CasperTech::bench::recordFailure()
+{
+    failures++;
+}
+
+const char* CasperTech::bench::verdict(bool ok, const char* failed)
+{
+    if (ok)
+    {
+        return "ok";
+    }
+    recordFailure();
+    return failed;
+}
+
+// Usage: node_audio_bench [--list] [filter...]
+// With no filter every benchmark runs, otherwise only those whose name contains
+// one of the filters. Exits with 1 if any benchmark's checks failed.
+int main(int argc, char** argv)
+{
+    std::vector<Benchmark> benchmarks;
+    for(auto& b: ringBufferBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: pipelineBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: underrunBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: gainBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: readAheadBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: mixerBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: trackSwitchBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: clipCacheBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: inputBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: seekBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: clockBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: rateBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: commandBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: openBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+    for(auto& b: probeBenchmarks())
+    {
+        benchmarks.push_back(std::move(b));
+    }
+
+    std::vector<std::string> filters;
+    bool list = false;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--list")
+        {
+            list = true;
+        }
+        else
+        {
+            filters.push_back(arg);
+        }
+    }
+
+    for(const auto& b: benchmarks)
+    {
+        if (list)
+        {
+            std::cout << b.name << " - " << b.description << std::endl;
+            continue;
+        }
+        bool selected = filters.empty();
+        for(const auto& f: filters)
+        {
+            if (b.name.find(f) != std::string::npos)
+            {
+                selected = true;
+                break;
+            }
+        }
+        if (!selected)
+        {
+            continue;
+        }
+        std::cout << "== " << b.name << std::endl;
+        b.run();
+        std::cout << std::endl;
+    }
+    if (failures != 0)
+    {
+        std::cout << failures << " check(s) FAILED" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    struct Benchmark
+    {
+        std::string name;
+        std::string description;
+        std::function<void()> run;
+    };
+
+    // Marks the run as failed, so node_audio_bench exits non-zero once every
+    // selected benchmark has run
+    void recordFailure();
+    // "ok", or failed after recording a failure, for the end of a result line
+    const char* verdict(bool ok, const char* failed = "FAILED");
+
+    std::vector<Benchmark> ringBufferBenchmarks();
+    std::vector<Benchmark> pipelineBenchmarks();
+    std::vector<Benchmark> underrunBenchmarks();
+    std::vector<Benchmark> gainBenchmarks();
+    std::vector<Benchmark> readAheadBenchmarks();
+    std::vector<Benchmark> mixerBenchmarks();
+    std::vector<Benchmark> trackSwitchBenchmarks();
+    std::vector<Benchmark> clipCacheBenchmarks();
+    std::vector<Benchmark> inputBenchmarks();
+    std::vector<Benchmark> seekBenchmarks();
+    std::vector<Benchmark> clockBenchmarks();
+    std::vector<Benchmark> rateBenchmarks();
+    std::vector<Benchmark> commandBenchmarks();
+    std::vector<Benchmark> openBenchmarks();
+    std::vector<Benchmark> probeBenchmarks();
+}
@@ -0,0 +1,258 @@
+#include "Benchmarks.h"
+#include "FirstSampleProbe.h"
+#include "MediaFixtures.h"
+
+#include <implementation/ClipCache.h>
+#include <implementation/ClipSource.h>
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/SampleRateConverter.h>
+#include <implementation/VolumeFilter.h>
+#include <exceptions/AudioException.h>
+#include <exceptions/CommandException.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t clipLoads = 50;
+
+    // The persistent chain a player keeps between loads
+    struct ClipChain
+    {
+        std::shared_ptr<FirstSampleProbe<NullRenderer>> renderer = std::make_shared<FirstSampleProbe<NullRenderer>>(ClockMode::Unpaced);
+        std::shared_ptr<SampleRateConverter> resampler = std::make_shared<SampleRateConverter>();
+        std::shared_ptr<VolumeFilter> volume = std::make_shared<VolumeFilter>();
+        std::shared_ptr<ITrackSource> source;
+    };
+
+    // Loads path as AudioPlayerImpl does, through the cache when it's given one, and
+    // returns the time from the start of the load to the first sample reaching the
+    // renderer, or a negative value if nothing arrived
+    static double loadToFirstSample(ClipChain& chain, const std::string& path, ClipCache* cache)
+    {
+        const int64_t start = probeNowNs();
+        if (chain.source)
+        {
+            chain.source->disconnectSink();
+        }
+        chain.renderer->flush();
+        chain.renderer->firstSampleNs = 0;
+
+        std::string key;
+        std::shared_ptr<const PcmClip> clip;
+        if (cache)
+        {
+            key = ClipCache::keyFor(path);
+            clip = cache->find(key);
+        }
+        if (!clip)
+        {
+            auto file = std::make_shared<FFSource>();
+            file->load(path);
+            chain.source = file;
+            if (cache)
+            {
+                clip = ClipSource::decode(file, chain.renderer, cache->getBudget());
+                if (clip)
+                {
+                    cache->insert(key, clip);
+                }
+            }
+        }
+        if (clip)
+        {
+            chain.source = std::make_shared<ClipSource>(clip, path);
+            chain.volume->connectSink(chain.renderer);
+        }
+        else
+        {
+            chain.resampler->connectSink(chain.renderer);
+            chain.volume->connectSink(chain.resampler);
+        }
+        chain.source->connectSink(chain.volume);
+
+        FFFrame frame;
+        int result = 1;
+        while(chain.renderer->firstSampleNs == 0 && (result > 0 || result == -11))
+        {
+            result = chain.source->getPacket(&frame);
+        }
+        if (chain.renderer->firstSampleNs == 0)
+        {
+            return -1.0;
+        }
+        return static_cast<double>(chain.renderer->firstSampleNs - start) / 1e6;
+    }
+
+    struct ReplayTimes
+    {
+        double firstMs = 0.0;
+        double meanMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static bool replay(const std::string& path, ClipCache* cache, ReplayTimes& times)
+    {
+        ClipChain chain;
+        double totalMs = 0.0;
+        for(uint32_t i = 0; i <= clipLoads; i++)
+        {
+            const double ms = loadToFirstSample(chain, path, cache);
+            if (ms < 0.0)
+            {
+                return false;
+            }
+            if (i == 0)
+            {
+                // Includes decoding the clip in full when caching
+                times.firstMs = ms;
+                continue;
+            }
+            totalMs += ms;
+            times.maxMs = std::max(times.maxMs, ms);
+        }
+        times.meanMs = totalMs / clipLoads;
+        chain.source->disconnectSink();
+        chain.volume->disconnectSink();
+        chain.resampler->disconnectSink();
+        return true;
+    }
+
+    static void compareReplay(const MediaFixture& fixture)
+    {
+        const std::string path = synthesizeFixture(fixture, 1.0);
+        std::cout << std::left << std::setw(22) << fixture.name;
+        if (path.empty())
+        {
+            std::cout << " skipped, no encoder" << std::endl;
+            return;
+        }
+
+        ReplayTimes uncached;
+        ReplayTimes cached;
+        try
+        {
+            ClipCache cache;
+            if (!replay(path, nullptr, uncached) || !replay(path, &cache, cached))
+            {
+                std::cout << " decode failed" << std::endl;
+                std::filesystem::remove(path);
+                return;
+            }
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+            std::filesystem::remove(path);
+            return;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " failed: " << e.message() << std::endl;
+            std::filesystem::remove(path);
+            return;
+        }
+        std::filesystem::remove(path);
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << " load to first sample, file " << std::setw(7) << uncached.meanMs << "ms"
+                  << "  cached " << std::setw(6) << cached.meanMs << "ms"
+                  << " (max " << cached.maxMs << "ms, first load " << cached.firstMs << "ms)"
+                  << "  " << std::setprecision(0) << uncached.meanMs / cached.meanMs << "x" << std::endl;
+    }
+
+    // More clips than the budget holds, played round robin, so each load evicts
+    // the clip played longest ago and misses; then a set that fits, which hits
+    static void evictionCounters()
+    {
+        const MediaFixture fixture = { "wav-s16-48k-mono", "wav", "pcm_s16le", 48000, 1 };
+        const std::string path = synthesizeFixture(fixture, 1.0);
+        if (path.empty())
+        {
+            std::cout << "eviction skipped, no encoder" << std::endl;
+            return;
+        }
+        std::vector<std::string> paths;
+        for(int i = 0; i < 4; i++)
+        {
+            auto copy = path + "." + std::to_string(i) + ".wav";
+            std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+            paths.push_back(copy);
+        }
+
+        ClipCache cache;
+        ClipChain chain;
+        loadToFirstSample(chain, paths[0], &cache);
+        cache.setBudget(3 * cache.getStats().bytes);
+        for(int round = 0; round < 3; round++)
+        {
+            for(const auto& p: paths)
+            {
+                loadToFirstSample(chain, p, &cache);
+            }
+        }
+        const ClipCacheStats thrashing = cache.getStats();
+        for(int round = 0; round < 3; round++)
+        {
+            for(size_t i = 0; i < 3; i++)
+            {
+                loadToFirstSample(chain, paths[i], &cache);
+            }
+        }
+        const ClipCacheStats fitting = cache.getStats();
+        chain.source->disconnectSink();
+        chain.volume->disconnectSink();
+        chain.resampler->disconnectSink();
+
+        for(const auto& p: paths)
+        {
+            std::filesystem::remove(p);
+        }
+        std::filesystem::remove(path);
+
+        std::cout << "4 clips, room for 3:  hits " << thrashing.hits << " misses " << thrashing.misses
+                  << " evictions " << thrashing.evictions << " entries " << thrashing.entries
+                  << " bytes " << thrashing.bytes << "/" << thrashing.budgetBytes << std::endl;
+        std::cout << "then 3 of them again: hits " << fitting.hits - thrashing.hits
+                  << " misses " << fitting.misses - thrashing.misses
+                  << " evictions " << fitting.evictions - thrashing.evictions << std::endl;
+    }
+
+    std::vector<Benchmark> clipCacheBenchmarks()
+    {
+        return {
+            {
+                "cache/clip-replay",
+                "Load to first sample for a 1s clip loaded repeatedly, from the file vs the decoded clip cache",
+                []
+                {
+                    const MediaFixture fixtures[] = {
+                        { "wav-s16-44k-stereo", "wav", "pcm_s16le", 44100, 2 },
+                        { "mp3-44k-stereo", "mp3", "libmp3lame", 44100, 2, 192000 },
+                        { "ogg-vorbis-48k-stereo", "ogg", "libvorbis", 48000, 2, 160000 },
+                        { "m4a-aac-44k-stereo", "m4a", "aac", 44100, 2, 128000 },
+                    };
+                    for(const auto& fixture: fixtures)
+                    {
+                        compareReplay(fixture);
+                    }
+                }
+            },
+            {
+                "cache/clip-eviction",
+                "Hit, miss and eviction counters for clips played round robin within and beyond the budget",
+                []
+                {
+                    evictionCounters();
+                }
+            }
+        };
+    }
+}
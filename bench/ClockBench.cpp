@@ -0,0 +1,205 @@
+#include "Benchmarks.h"
+
+#include <implementation/MixerRenderer.h>
+#include <implementation/OutputMixer.h>
+#include <implementation/PipelineStats.h>
+#include <interfaces/IAudioSource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t clockSampleRate = 48000;
+    static constexpr uint32_t clockBlockFrames = 512;
+    static constexpr uint32_t clockSeeks = 12;
+    static constexpr uint64_t clockReads = 1000000;
+
+    // Writes each frame's own position in the track into it, low 16 bits on the
+    // left and the rest on the right, so the output says exactly what's playing.
+    // Floats hold both halves exactly, and a voice at unity gain copies them as is.
+    class CountingSource: public IAudioSource
+    {
+        public:
+            std::string getName() const override
+            {
+                return "CountingSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { clockSampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void pump()
+            {
+                _block.resize(clockBlockFrames * 2);
+                for(uint32_t i = 0; i < clockBlockFrames; i++)
+                {
+                    _block[i * 2] = static_cast<float>(next & 0xffff);
+                    _block[i * 2 + 1] = static_cast<float>(next >> 16);
+                    next++;
+                }
+                _sink->audio(reinterpret_cast<const uint8_t*>(_block.data()), nullptr, clockBlockFrames);
+            }
+
+            // The track position of the next frame pumped
+            uint64_t next = 0;
+
+        private:
+            std::vector<float> _block;
+    };
+
+    static uint64_t decodeFrame(const float* frame)
+    {
+        return static_cast<uint64_t>(frame[0]) | (static_cast<uint64_t>(frame[1]) << 16);
+    }
+
+    struct ClockRun
+    {
+        double meanErrorMs = 0.0;
+        double worstErrorMs = 0.0;
+        uint64_t checks = 0;
+        uint32_t seeks = 0;
+        double readNs = 0.0;
+    };
+
+    // Plays a counting track through a voice on a headless mixer rendered in real
+    // time, seeking it now and then as the player does. Half way through each
+    // callback period the playback clock is checked against the frame the output
+    // says is playing, and meanwhile another thread times reading it.
+    static ClockRun runClock()
+    {
+        auto stats = std::make_shared<PipelineStats>();
+        auto mixer = OutputMixer::headless(clockSampleRate, 2);
+        auto renderer = std::make_shared<MixerRenderer>(mixer);
+        auto source = std::make_shared<CountingSource>();
+        // Clear of 0, which would read the same as silence
+        source->next = clockSampleRate;
+        stats->clock.setStartMs(1000);
+        source->connectSink(renderer);
+        renderer->setStats(stats);
+
+        std::atomic<bool> done{ false };
+        std::atomic<int64_t> seekToMs{ -1 };
+        std::thread producer([&]
+        {
+            while(!done)
+            {
+                const int64_t ms = seekToMs.exchange(-1);
+                if (ms >= 0)
+                {
+                    source->next = static_cast<uint64_t>(ms) * clockSampleRate / 1000;
+                    stats->clock.setStartMs(static_cast<uint64_t>(ms));
+                    renderer->flush();
+                }
+                source->pump();
+            }
+        });
+
+        ClockRun run;
+        std::atomic<bool> rendering{ true };
+        std::thread output([&]
+        {
+            const uint32_t frames = mixer->getBufferFrames();
+            std::vector<float> out(frames * 2);
+            const auto period = std::chrono::nanoseconds(static_cast<int64_t>(frames) * 1000000000 / clockSampleRate);
+            auto next = std::chrono::steady_clock::now();
+            while(rendering)
+            {
+                mixer->render(out.data(), frames, false);
+                const auto rendered = std::chrono::steady_clock::now();
+                const uint64_t first = decodeFrame(out.data());
+                const uint64_t last = decodeFrame(out.data() + (frames - 1) * 2);
+                std::this_thread::sleep_until(rendered + period / 2);
+                // Only blocks played straight through from one point in the track
+                if (first != 0 && last == first + frames - 1)
+                {
+                    const auto elapsed = std::chrono::steady_clock::now() - rendered;
+                    const double playing = static_cast<double>(first) * 1000.0 / clockSampleRate
+                            + std::min(std::chrono::duration<double, std::milli>(elapsed).count(),
+                                       static_cast<double>(frames) * 1000.0 / clockSampleRate);
+                    const double error = std::abs(stats->clock.positionMs() - playing);
+                    run.meanErrorMs += error;
+                    run.worstErrorMs = std::max(run.worstErrorMs, error);
+                    run.checks++;
+                }
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        });
+
+        std::atomic<bool> reading{ true };
+        std::thread reader([&]
+        {
+            // Waits for playback, then reads back to back as many players' UIs would
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            [[maybe_unused]] volatile double position = 0.0;
+            const auto start = std::chrono::steady_clock::now();
+            for(uint64_t i = 0; i < clockReads && reading; i++)
+            {
+                position = stats->clock.positionMs();
+            }
+            run.readNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / clockReads;
+        });
+
+        std::mt19937 random(17);
+        std::uniform_int_distribution<int64_t> targets(1000, 600000);
+        for(uint32_t i = 0; i < clockSeeks; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(400));
+            seekToMs = targets(random);
+            run.seeks++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+
+        reading = false;
+        reader.join();
+        // The producer may be waiting on the ring for room
+        done = true;
+        producer.join();
+        rendering = false;
+        output.join();
+        source->disconnectSink();
+
+        run.meanErrorMs /= static_cast<double>(std::max<uint64_t>(run.checks, 1));
+        return run;
+    }
+
+    std::vector<Benchmark> clockBenchmarks()
+    {
+        return {
+            {
+                "clock/position",
+                "Playback position against what a real-time headless mixer is playing, across seeks, and the cost of reading it",
+                []
+                {
+                    const ClockRun run = runClock();
+                    std::cout << std::fixed << std::setprecision(3)
+                              << "off by " << run.meanErrorMs << "ms on average, " << run.worstErrorMs << "ms at worst"
+                              << " over " << run.checks << " checks and " << run.seeks << " seeks"
+                              << std::setprecision(1)
+                              << "; reading it takes " << run.readNs << "ns" << std::endl;
+                }
+            }
+        };
+    }
+}
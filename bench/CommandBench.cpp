@@ -0,0 +1,405 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+
+#include <implementation/AudioPlayerImpl.h>
+#include <implementation/StreamReader.h>
+#include <interfaces/IAudioPlayerEventReceiver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t commandPlayers = 50;
+    // Players loading from a stream that takes a while to deliver, as over a slow
+    // network. The rest change their volume as fast as their commands complete.
+    static constexpr uint32_t commandSlowLoaders = 4;
+    // libuv's default threadpool size
+    static constexpr uint32_t commandPoolThreads = 4;
+    static constexpr std::chrono::milliseconds commandLoadStall{ 250 };
+    static constexpr std::chrono::milliseconds commandRunTime{ 2000 };
+    // fs calls from the rest of the application, which share the threadpool
+    static constexpr std::chrono::milliseconds commandFsInterval{ 2 };
+    static constexpr size_t commandFsBytes = 64 * 1024;
+
+    // A fixed set of threads taking tasks in turn. One thread stands in for the JS
+    // thread, commandPoolThreads for the libuv threadpool.
+    class TaskQueue
+    {
+        public:
+            explicit TaskQueue(uint32_t threads)
+            {
+                for(uint32_t i = 0; i < threads; i++)
+                {
+                    _threads.emplace_back([this]{ run(); });
+                }
+            }
+
+            // Runs whatever is still queued first
+            ~TaskQueue()
+            {
+                {
+                    std::unique_lock<std::mutex> lk(_mutex);
+                    _stopping = true;
+                }
+                _wake.notify_all();
+                for(auto& thread: _threads)
+                {
+                    thread.join();
+                }
+            }
+
+            void post(std::function<void()> task)
+            {
+                {
+                    std::unique_lock<std::mutex> lk(_mutex);
+                    _tasks.push_back(std::move(task));
+                }
+                _wake.notify_one();
+            }
+
+        private:
+            void run()
+            {
+                for(;;)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lk(_mutex);
+                        _wake.wait(lk, [this]{ return _stopping || !_tasks.empty(); });
+                        if (_tasks.empty())
+                        {
+                            return;
+                        }
+                        task = std::move(_tasks.front());
+                        _tasks.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _wake;
+            std::deque<std::function<void()>> _tasks;
+            bool _stopping = false;
+            std::vector<std::thread> _threads;
+    };
+
+    class NullEventReceiver: public IAudioPlayerEventReceiver
+    {
+        public:
+            void onPlayerEvent(const std::shared_ptr<PlayerEvent>& event) override
+            {
+
+            }
+    };
+
+    // Holds back each stream's bytes until its stall is over
+    class StalledStreams
+    {
+        public:
+            explicit StalledStreams(std::vector<uint8_t> bytes)
+                : _bytes(std::move(bytes))
+                , _thread([this]{ run(); })
+            {
+
+            }
+
+            ~StalledStreams()
+            {
+                {
+                    std::unique_lock<std::mutex> lk(_mutex);
+                    _stopping = true;
+                }
+                _wake.notify_all();
+                _thread.join();
+            }
+
+            std::shared_ptr<StreamReader> open()
+            {
+                auto reader = std::make_shared<StreamReader>(_bytes.size(), []{});
+                {
+                    std::unique_lock<std::mutex> lk(_mutex);
+                    _stalled.emplace_back(std::chrono::steady_clock::now() + commandLoadStall, reader);
+                }
+                _wake.notify_all();
+                return reader;
+            }
+
+        private:
+            void run()
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                while(!_stopping || !_stalled.empty())
+                {
+                    if (_stalled.empty())
+                    {
+                        _wake.wait(lk);
+                        continue;
+                    }
+                    const auto [due, reader] = _stalled.front();
+                    if (std::chrono::steady_clock::now() < due)
+                    {
+                        _wake.wait_until(lk, due);
+                        continue;
+                    }
+                    _stalled.pop_front();
+                    lk.unlock();
+                    reader->write(_bytes.data(), _bytes.size());
+                    reader->end();
+                    lk.lock();
+                }
+            }
+
+            std::vector<uint8_t> _bytes;
+            std::mutex _mutex;
+            std::condition_variable _wake;
+            std::deque<std::pair<std::chrono::steady_clock::time_point, std::shared_ptr<StreamReader>>> _stalled;
+            bool _stopping = false;
+            std::thread _thread;
+    };
+
+    enum class CompletionModel
+    {
+        // A threadpool task queues the command and waits for it to complete
+        ParkedWorker,
+        // The JS thread queues the command and the control thread posts the result back
+        CompletionQueue,
+    };
+
+    struct CommandRun
+    {
+        uint64_t volumeCommands = 0;
+        uint64_t loads = 0;
+        std::vector<double> fsLatencyMs;
+    };
+
+    class CommandScenario
+    {
+        public:
+            CommandScenario(CompletionModel model, const std::vector<uint8_t>& streamBytes, std::string fsPath)
+                : _model(model)
+                , _streams(streamBytes)
+                , _fsPath(std::move(fsPath))
+            {
+                PlayerOptions options;
+                options.renderer.type = RendererType::Null;
+                options.renderer.clockMode = ClockMode::Unpaced;
+                for(uint32_t i = 0; i < commandPlayers; i++)
+                {
+                    _players.push_back(std::make_unique<AudioPlayerImpl>(&_receiver, options));
+                }
+            }
+
+            CommandRun run()
+            {
+                const auto start = std::chrono::steady_clock::now();
+                _chains = commandPlayers;
+                _loop.post([this]
+                {
+                    for(uint32_t i = 0; i < commandPlayers; i++)
+                    {
+                        next(i);
+                    }
+                });
+
+                std::thread fsLoad([this]{ issueFsJobs(); });
+                std::this_thread::sleep_until(start + commandRunTime);
+                _running = false;
+                fsLoad.join();
+                {
+                    std::unique_lock<std::mutex> lk(_doneMutex);
+                    _done.wait(lk, [this]{ return _chains == 0; });
+                }
+
+                CommandRun run;
+                run.volumeCommands = _volumeCommands;
+                run.loads = _loads;
+                std::unique_lock<std::mutex> lk(_fsMutex);
+                run.fsLatencyMs = _fsLatencyMs;
+                return run;
+            }
+
+        private:
+            // On the JS thread: player's next command, until the run is over
+            void next(uint32_t player)
+            {
+                if (!_running)
+                {
+                    std::unique_lock<std::mutex> lk(_doneMutex);
+                    if (--_chains == 0)
+                    {
+                        _done.notify_all();
+                    }
+                    return;
+                }
+                AudioPlayerImpl* audioPlayer = _players[player].get();
+                if (player < commandSlowLoaders)
+                {
+                    issue([this, audioPlayer](const ResultCallback& callback)
+                    {
+                        audioPlayer->load(_streams.open(), "stream", callback);
+                    }, [this, player]
+                    {
+                        _loads++;
+                        next(player);
+                    });
+                    return;
+                }
+                const float volume = (_volumeCommands % 2) == 0 ? 0.5f : 1.0f;
+                issue([audioPlayer, volume](const ResultCallback& callback)
+                {
+                    audioPlayer->setVolume(volume, 0, VolumeCurve::Linear, callback);
+                }, [this, player]
+                {
+                    _volumeCommands++;
+                    next(player);
+                });
+            }
+
+            // On the JS thread. then runs on the JS thread once the command is done,
+            // as the continuation of an awaited promise would.
+            void issue(const std::function<void(const ResultCallback& callback)>& command, const std::function<void()>& then)
+            {
+                if (_model == CompletionModel::ParkedWorker)
+                {
+                    _pool.post([this, command, then]
+                    {
+                        std::mutex waitMutex;
+                        std::condition_variable waitCondition;
+                        bool completed = false;
+                        std::unique_lock<std::mutex> lk(waitMutex);
+                        command([&](CommandResult result, const std::string& errorMessage)
+                        {
+                            std::unique_lock<std::mutex> completedLock(waitMutex);
+                            completed = true;
+                            waitCondition.notify_all();
+                        });
+                        waitCondition.wait(lk, [&]{ return completed; });
+                        _loop.post(then);
+                    });
+                    return;
+                }
+                command([this, then](CommandResult result, const std::string& errorMessage)
+                {
+                    _loop.post(then);
+                });
+            }
+
+            void issueFsJobs()
+            {
+                while(_running)
+                {
+                    const auto posted = std::chrono::steady_clock::now();
+                    _pool.post([this, posted]
+                    {
+                        std::vector<char> buffer(commandFsBytes);
+                        std::ifstream in(_fsPath, std::ios::binary);
+                        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - posted).count();
+                        std::unique_lock<std::mutex> lk(_fsMutex);
+                        _fsLatencyMs.push_back(ms);
+                    });
+                    std::this_thread::sleep_for(commandFsInterval);
+                }
+            }
+
+            CompletionModel _model;
+            NullEventReceiver _receiver;
+            StalledStreams _streams;
+            std::string _fsPath;
+            std::vector<std::unique_ptr<AudioPlayerImpl>> _players;
+
+            std::atomic<bool> _running{ true };
+            std::atomic<uint64_t> _volumeCommands{ 0 };
+            std::atomic<uint64_t> _loads{ 0 };
+            std::mutex _doneMutex;
+            std::condition_variable _done;
+            uint32_t _chains = 0;
+            std::mutex _fsMutex;
+            std::vector<double> _fsLatencyMs;
+
+            // Declared last, so they are drained and joined before the rest goes
+            TaskQueue _pool{ commandPoolThreads };
+            TaskQueue _loop{ 1 };
+    };
+
+    static double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())))];
+    }
+
+    std::vector<Benchmark> commandBenchmarks()
+    {
+        return {
+            {
+                "commands/completion",
+                "50 players' commands with 4 loads stalled on their input and fs calls on a 4 thread pool: commands parking a pool thread until done vs completions posted back from the control thread",
+                []
+                {
+                    const std::string fixturePath = synthesizeFixture(standardFixtures()[0], 2.0);
+                    if (fixturePath.empty())
+                    {
+                        std::cout << "skipped, no encoder" << std::endl;
+                        return;
+                    }
+                    std::vector<uint8_t> streamBytes;
+                    {
+                        std::ifstream in(fixturePath, std::ios::binary);
+                        streamBytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                    }
+                    std::filesystem::remove(fixturePath);
+
+                    const std::string fsPath = (std::filesystem::temp_directory_path() / "node_audio_command_bench.bin").string();
+                    {
+                        std::ofstream out(fsPath, std::ios::binary);
+                        const std::vector<char> zeros(commandFsBytes, 0);
+                        out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+                    }
+
+                    const std::pair<const char*, CompletionModel> models[] = {
+                        { "parked worker", CompletionModel::ParkedWorker },
+                        { "completion queue", CompletionModel::CompletionQueue },
+                    };
+                    const double seconds = std::chrono::duration<double>(commandRunTime).count();
+                    for(const auto& [name, model]: models)
+                    {
+                        CommandRun run;
+                        {
+                            CommandScenario scenario(model, streamBytes, fsPath);
+                            run = scenario.run();
+                        }
+                        std::cout << std::left << std::setw(18) << name << std::right
+                                  << std::fixed << std::setprecision(0)
+                                  << std::setw(9) << static_cast<double>(run.volumeCommands) / seconds << " commands/s"
+                                  << std::setw(4) << run.loads << " loads"
+                                  << std::setprecision(2)
+                                  << "  fs p50 " << std::setw(7) << percentile(run.fsLatencyMs, 0.5) << "ms"
+                                  << " p99 " << std::setw(7) << percentile(run.fsLatencyMs, 0.99) << "ms"
+                                  << " max " << std::setw(7) << percentile(run.fsLatencyMs, 1.0) << "ms"
+                                  << " (" << run.fsLatencyMs.size() << " calls)"
+                                  << std::endl;
+                    }
+                    std::filesystem::remove(fsPath);
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <structs/RingSpans.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace CasperTech::bench
+{
+    inline int64_t probeNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Notes when the first audio of a track reaches the renderer, by either path
+    template<typename Renderer>
+    class FirstSampleProbe: public Renderer
+    {
+        public:
+            using Renderer::Renderer;
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                mark();
+                Renderer::audio(buffer, planarChannel, sampleCount);
+            }
+
+            bool reserve(uint64_t sampleCount, RingSpans& spans) override
+            {
+                mark();
+                return Renderer::reserve(sampleCount, spans);
+            }
+
+            int64_t firstSampleNs = 0;
+
+        private:
+            void mark()
+            {
+                if (firstSampleNs == 0)
+                {
+                    firstSampleNs = probeNowNs();
+                }
+            }
+    };
+}
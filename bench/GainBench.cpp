@@ -0,0 +1,286 @@
+#include "Benchmarks.h"
+
+#include <implementation/GainKernel.h>
+#include <implementation/VolumeFilter.h>
+#include <exceptions/AudioException.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t gainChannels = 2;
+    static constexpr uint64_t gainBlockFrames = 1152;
+
+    // Offers exactly one format so the VolumeFilter under test has to use it
+    class FixedFormatSource: public IAudioSource
+    {
+        public:
+            explicit FixedFormatSource(SampleFormatFlags format)
+                : _format(format)
+            {
+
+            }
+
+            std::string getName() const override
+            {
+                return "FixedFormatSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return _format;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { 48000 };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return gainChannels;
+            }
+
+        private:
+            SampleFormatFlags _format;
+    };
+
+    // Accepts anything and keeps a copy of the last block when asked to
+    class CaptureSink: public IAudioSink
+    {
+        public:
+            std::string getName() const override
+            {
+                return "CaptureSink";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::S16 | SampleFormatFlags::S16_Planar
+                       | SampleFormatFlags::S32 | SampleFormatFlags::S32_Planar
+                       | SampleFormatFlags::FLT | SampleFormatFlags::FLT_Planar
+                       | SampleFormatFlags::DBL | SampleFormatFlags::DBL_Planar;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { 48000 };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return gainChannels;
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                if (!capture)
+                {
+                    return;
+                }
+                const size_t planeBytes = planarChannel != nullptr ? bytes / 2 : bytes;
+                captured.assign(buffer, buffer + planeBytes);
+                if (planarChannel != nullptr)
+                {
+                    captured.insert(captured.end(), planarChannel, planarChannel + planeBytes);
+                }
+            }
+
+            void onEos() override
+            {
+
+            }
+
+            bool capture = false;
+            size_t bytes = 0;
+            std::vector<uint8_t> captured;
+    };
+
+    struct GainFormat
+    {
+        const char* name;
+        SampleFormatFlags format;
+        size_t sampleSize;
+    };
+
+    // Interprets a captured block as the given format so kernel and graph output can
+    // be compared in the format's own units (LSBs for integers)
+    static double sampleAt(const GainFormat& f, const std::vector<uint8_t>& data, size_t i)
+    {
+        switch(f.sampleSize)
+        {
+            case 2:
+            {
+                int16_t v;
+                std::memcpy(&v, &data[i * 2], 2);
+                return v;
+            }
+            case 4:
+            {
+                if (f.format == SampleFormatFlags::FLT || f.format == SampleFormatFlags::FLT_Planar)
+                {
+                    float v;
+                    std::memcpy(&v, &data[i * 4], 4);
+                    return v;
+                }
+                int32_t v;
+                std::memcpy(&v, &data[i * 4], 4);
+                return v;
+            }
+            default:
+            {
+                double v;
+                std::memcpy(&v, &data[i * 8], 8);
+                return v;
+            }
+        }
+    }
+
+    static std::vector<uint8_t> makeSignal(const GainFormat& f, size_t samples)
+    {
+        std::vector<uint8_t> data(samples * f.sampleSize);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        for(size_t i = 0; i < samples; i++)
+        {
+            const double v = dist(rng);
+            if (f.sampleSize == 2)
+            {
+                auto s = static_cast<int16_t>(v * 32767.0);
+                std::memcpy(&data[i * 2], &s, 2);
+            }
+            else if (f.format == SampleFormatFlags::FLT || f.format == SampleFormatFlags::FLT_Planar)
+            {
+                auto s = static_cast<float>(v);
+                std::memcpy(&data[i * 4], &s, 4);
+            }
+            else if (f.sampleSize == 4)
+            {
+                auto s = static_cast<int32_t>(v * 2147483647.0);
+                std::memcpy(&data[i * 4], &s, 4);
+            }
+            else
+            {
+                std::memcpy(&data[i * 8], &v, 8);
+            }
+        }
+        return data;
+    }
+
+    struct GainRun
+    {
+        double nsPerSample = 0.0;
+        std::vector<uint8_t> output;
+    };
+
+    static GainRun runVolumeFilter(const GainFormat& f, bool nativeGain, uint32_t rampMs = 0)
+    {
+        const uint32_t blocks = 2000;
+        const size_t samples = gainBlockFrames * gainChannels;
+        const bool planar = GainKernel::isPlanar(f.format);
+        const std::vector<uint8_t> signal = makeSignal(f, samples);
+
+        auto source = std::make_shared<FixedFormatSource>(f.format);
+        auto volume = std::make_shared<VolumeFilter>(nativeGain);
+        auto sink = std::make_shared<CaptureSink>();
+        sink->bytes = signal.size();
+        volume->connectSink(sink);
+        source->connectSink(volume);
+        volume->setVolume(0.5f, rampMs);
+
+        std::vector<uint8_t> block(signal.size());
+        const size_t planeBytes = planar ? block.size() / 2 : block.size();
+        int64_t ns = 0;
+        for(uint32_t i = 0; i <= blocks; i++)
+        {
+            // The native path scales in place, so every block starts from the same input
+            std::memcpy(block.data(), signal.data(), block.size());
+            sink->capture = i == blocks;
+            const auto start = std::chrono::steady_clock::now();
+            volume->audio(block.data(), planar ? block.data() + planeBytes : nullptr, gainBlockFrames);
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        source->disconnectSink();
+        volume->disconnectSink();
+
+        GainRun run;
+        run.nsPerSample = static_cast<double>(ns) / static_cast<double>(samples * (blocks + 1));
+        run.output = std::move(sink->captured);
+        return run;
+    }
+
+    static void compareGain(const GainFormat& f)
+    {
+        GainRun graph;
+        GainRun native;
+        GainRun ramp;
+        try
+        {
+            graph = runVolumeFilter(f, false);
+            native = runVolumeFilter(f, true);
+            // Long enough that every block is mid ramp
+            ramp = runVolumeFilter(f, true, 600000);
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << std::left << std::setw(6) << f.name << " failed: " << e.message() << std::endl;
+            return;
+        }
+
+        double maxDiff = 0.0;
+        const size_t samples = std::min(graph.output.size(), native.output.size()) / f.sampleSize;
+        for(size_t i = 0; i < samples; i++)
+        {
+            maxDiff = std::max(maxDiff, std::abs(sampleAt(f, graph.output, i) - sampleAt(f, native.output, i)));
+        }
+
+        std::ostringstream diff;
+        diff << std::setprecision(3) << maxDiff;
+        std::cout << std::left << std::setw(6) << f.name
+                  << std::fixed << std::setprecision(2)
+                  << " ns/sample graph " << std::setw(7) << graph.nsPerSample
+                  << " native " << std::setw(6) << native.nsPerSample
+                  << " ramping " << std::setw(6) << ramp.nsPerSample
+                  << " " << std::setprecision(1) << std::setw(6) << graph.nsPerSample / native.nsPerSample << "x"
+                  << "  max diff " << diff.str()
+                  << std::endl;
+    }
+
+    std::vector<Benchmark> gainBenchmarks()
+    {
+        return {
+            {
+                "volume/gain-kernel",
+                "VolumeFilter at 0.5 gain, native kernel (steady and ramping) vs libavfilter volume graph, per format",
+                []
+                {
+                    std::cout << "kernel " << GainKernel::instructionSet() << std::endl;
+                    const GainFormat formats[] = {
+                        { "s16", SampleFormatFlags::S16, 2 },
+                        { "s16p", SampleFormatFlags::S16_Planar, 2 },
+                        { "s32", SampleFormatFlags::S32, 4 },
+                        { "s32p", SampleFormatFlags::S32_Planar, 4 },
+                        { "flt", SampleFormatFlags::FLT, 4 },
+                        { "fltp", SampleFormatFlags::FLT_Planar, 4 },
+                        { "dbl", SampleFormatFlags::DBL, 8 },
+                        { "dblp", SampleFormatFlags::DBL_Planar, 8 },
+                    };
+                    for(const auto& f: formats)
+                    {
+                        compareGain(f);
+                    }
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,391 @@
+#include "Benchmarks.h"
+#include "FirstSampleProbe.h"
+#include "MediaFixtures.h"
+
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/MemoryReader.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/SampleRateConverter.h>
+#include <implementation/StreamReader.h>
+#include <exceptions/AudioException.h>
+#include <exceptions/CommandException.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t inputLoads = 20;
+
+    // Opens and decodes source to the end through a converter into an unpaced
+    // null renderer, as a player would
+    static bool decodeAll(const std::shared_ptr<FFSource>& source)
+    {
+        auto resampler = std::make_shared<SampleRateConverter>();
+        auto renderer = std::make_shared<NullRenderer>(ClockMode::Unpaced);
+        resampler->connectSink(renderer);
+        source->connectSink(resampler);
+        FFFrame frame;
+        int result;
+        do
+        {
+            result = source->getPacket(&frame);
+        } while(result > 0 || result == -11);
+        source->disconnectSink();
+        resampler->disconnectSink();
+        return result == 0;
+    }
+
+    // An asset already in memory, as loaded from a bundle or database: staged
+    // through a temp file as load() requires, vs read in place by loadBuffer()
+    static void compareInput(const MediaFixture& fixture)
+    {
+        const std::string path = synthesizeFixture(fixture, 5.0);
+        std::cout << std::left << std::setw(22) << fixture.name;
+        if (path.empty())
+        {
+            std::cout << " skipped, no encoder" << std::endl;
+            return;
+        }
+        std::vector<uint8_t> asset;
+        {
+            std::ifstream in(path, std::ios::binary);
+            asset.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::filesystem::remove(path);
+        const std::string staged = path + ".staged";
+
+        double fileMs = 0.0;
+        double memoryMs = 0.0;
+        try
+        {
+            for(uint32_t i = 0; i < inputLoads; i++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                {
+                    std::ofstream out(staged, std::ios::binary);
+                    out.write(reinterpret_cast<const char*>(asset.data()), static_cast<std::streamsize>(asset.size()));
+                }
+                auto file = std::make_shared<FFSource>();
+                file->load(staged);
+                if (!decodeAll(file))
+                {
+                    std::cout << " decode failed" << std::endl;
+                    return;
+                }
+                fileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                start = std::chrono::steady_clock::now();
+                // Not owned, as a pinned Buffer isn't
+                std::shared_ptr<const uint8_t> data(asset.data(), [](const uint8_t*){});
+                auto memory = std::make_shared<FFSource>();
+                memory->load(std::make_shared<MemoryReader>(data, asset.size()), fixture.name);
+                if (!decodeAll(memory))
+                {
+                    std::cout << " decode failed" << std::endl;
+                    return;
+                }
+                memoryMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+            std::filesystem::remove(staged);
+            return;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " failed: " << e.message() << std::endl;
+            std::filesystem::remove(staged);
+            return;
+        }
+        std::filesystem::remove(staged);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << " " << std::setw(8) << asset.size() / 1024 << "KB"
+                  << "  load and decode, via temp file " << std::setw(7) << fileMs / inputLoads << "ms"
+                  << "  in place " << std::setw(7) << memoryMs / inputLoads << "ms" << std::endl;
+    }
+
+    static std::vector<uint8_t> readFixture(const MediaFixture& fixture, double seconds)
+    {
+        const std::string path = synthesizeFixture(fixture, seconds);
+        if (path.empty())
+        {
+            return {};
+        }
+        std::vector<uint8_t> asset;
+        {
+            std::ifstream in(path, std::ios::binary);
+            asset.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::filesystem::remove(path);
+        return asset;
+    }
+
+    // Sends asset into reader in 16KB pieces at bytesPerSecond (0 for as fast as
+    // it's taken), waiting for drain whenever a write is cut short, as the JS
+    // AudioInputStream does
+    class StreamProducer
+    {
+        public:
+            StreamProducer(const std::vector<uint8_t>& asset, uint64_t bytesPerSecond)
+                : _asset(asset)
+                , _bytesPerSecond(bytesPerSecond)
+            {
+
+            }
+
+            void run(StreamReader& reader)
+            {
+                const size_t chunk = 16 * 1024;
+                const auto start = std::chrono::steady_clock::now();
+                size_t sent = 0;
+                while(sent < _asset.size() && !stopped)
+                {
+                    const size_t n = std::min(chunk, _asset.size() - sent);
+                    if (_bytesPerSecond > 0)
+                    {
+                        std::this_thread::sleep_until(start + std::chrono::microseconds((sent + n) * 1000000 / _bytesPerSecond));
+                    }
+                    size_t offset = 0;
+                    while(offset < n && !stopped)
+                    {
+                        offset += reader.write(_asset.data() + sent + offset, n - offset);
+                        peakBuffered = std::max<uint64_t>(peakBuffered, reader.buffered());
+                        if (offset < n)
+                        {
+                            std::unique_lock<std::mutex> lk(_drainMutex);
+                            _drainWait.wait_for(lk, std::chrono::milliseconds(100), [this]
+                            {
+                                return _drained || stopped;
+                            });
+                            _drained = false;
+                        }
+                    }
+                    sent += n;
+                }
+                reader.end();
+            }
+
+            void onDrain()
+            {
+                drains++;
+                {
+                    std::unique_lock<std::mutex> lk(_drainMutex);
+                    _drained = true;
+                }
+                _drainWait.notify_one();
+            }
+
+            std::atomic<bool> stopped{ false };
+            std::atomic<uint64_t> drains{ 0 };
+            std::atomic<uint64_t> peakBuffered{ 0 };
+
+        private:
+            const std::vector<uint8_t>& _asset;
+            uint64_t _bytesPerSecond;
+            std::mutex _drainMutex;
+            std::condition_variable _drainWait;
+            bool _drained = false;
+    };
+
+    // A 60s track arriving at 1MB/s. Buffering it whole first, as we had to before,
+    // waits for the download; streaming starts once the demuxer can open it.
+    static void streamStart(const MediaFixture& fixture)
+    {
+        const uint64_t bytesPerSecond = 1024 * 1024;
+        std::cout << std::left << std::setw(22) << fixture.name;
+        const std::vector<uint8_t> asset = readFixture(fixture, 60.0);
+        if (asset.empty())
+        {
+            std::cout << " skipped, no encoder" << std::endl;
+            return;
+        }
+
+        StreamProducer producer(asset, bytesPerSecond);
+        auto reader = std::make_shared<StreamReader>(256 * 1024, [&producer]
+        {
+            producer.onDrain();
+        });
+        const int64_t start = probeNowNs();
+        std::thread feeder([&]
+        {
+            producer.run(*reader);
+        });
+
+        try
+        {
+            auto source = std::make_shared<FFSource>();
+            auto resampler = std::make_shared<SampleRateConverter>();
+            auto renderer = std::make_shared<FirstSampleProbe<NullRenderer>>(ClockMode::Unpaced);
+            source->load(reader, fixture.name);
+            const double openMs = static_cast<double>(probeNowNs() - start) / 1e6;
+            resampler->connectSink(renderer);
+            source->connectSink(resampler);
+            FFFrame frame;
+            int result = 1;
+            while(renderer->firstSampleNs == 0 && (result > 0 || result == -11))
+            {
+                result = source->getPacket(&frame);
+            }
+            const double firstMs = static_cast<double>(renderer->firstSampleNs - start) / 1e6;
+
+            // Read the rest, which is as long as buffering it whole would have taken
+            while(result > 0 || result == -11)
+            {
+                result = source->getPacket(&frame);
+            }
+            feeder.join();
+            const double downloadMs = static_cast<double>(probeNowNs() - start) / 1e6;
+            source->disconnectSink();
+            resampler->disconnectSink();
+
+            std::cout << std::fixed << std::setprecision(1)
+                      << " " << std::setw(6) << asset.size() / 1024 << "KB"
+                      << "  first sample streamed " << std::setw(6) << firstMs << "ms"
+                      << " (open " << openMs << "ms)"
+                      << "  after download " << std::setw(7) << downloadMs << "ms"
+                      << "  drains " << producer.drains << std::endl;
+            return;
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " failed: " << e.message() << std::endl;
+        }
+        producer.stopped = true;
+        reader->interrupt();
+        if (feeder.joinable())
+        {
+            feeder.join();
+        }
+    }
+
+    // A producer with everything to hand, feeding a real time player for two
+    // seconds. Backpressure should hold the native buffer at its capacity and
+    // pace the producer to playback, and stopping should interrupt the reader.
+    static void streamBackpressure()
+    {
+        const MediaFixture fixture = { "mp3-44k-stereo", "mp3", "libmp3lame", 44100, 2, 192000 };
+        const std::vector<uint8_t> asset = readFixture(fixture, 60.0);
+        if (asset.empty())
+        {
+            std::cout << "skipped, no encoder" << std::endl;
+            return;
+        }
+
+        const size_t capacity = 64 * 1024;
+        StreamProducer producer(asset, 0);
+        auto reader = std::make_shared<StreamReader>(capacity, [&producer]
+        {
+            producer.onDrain();
+        });
+        std::thread feeder([&]
+        {
+            producer.run(*reader);
+        });
+
+        int result = 0;
+        try
+        {
+            auto source = std::make_shared<FFSource>();
+            auto resampler = std::make_shared<SampleRateConverter>();
+            auto renderer = std::make_shared<NullRenderer>(ClockMode::RealTime);
+            source->load(reader, fixture.name);
+            resampler->connectSink(renderer);
+            source->connectSink(resampler);
+
+            std::thread stopper([&]
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(2));
+                producer.stopped = true;
+                source->interrupt();
+            });
+            FFFrame frame;
+            do
+            {
+                result = source->getPacket(&frame);
+            } while(result > 0 || result == -11);
+            stopper.join();
+            source->disconnectSink();
+            resampler->disconnectSink();
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << "load failed: " << e.message() << std::endl;
+            producer.stopped = true;
+            reader->interrupt();
+        }
+        feeder.join();
+
+        const bool bounded = producer.peakBuffered <= reader->capacity();
+        std::cout << "64KB buffer, 2s real time playback: peak buffered " << producer.peakBuffered / 1024 << "KB"
+                  << " of " << reader->capacity() / 1024 << "KB, drains " << producer.drains
+                  << ", stopped with " << (result == AVERROR_EXIT ? "AVERROR_EXIT" : FFSource::getError(result))
+                  << "  " << verdict(bounded && result == AVERROR_EXIT) << std::endl;
+    }
+
+    std::vector<Benchmark> inputBenchmarks()
+    {
+        return {
+            {
+                "input/load-buffer",
+                "Loading and decoding a 5s asset held in memory, staged through a temp file vs read in place",
+                []
+                {
+                    const MediaFixture fixtures[] = {
+                        { "wav-s16-44k-stereo", "wav", "pcm_s16le", 44100, 2 },
+                        { "flac-44k-stereo", "flac", "flac", 44100, 2 },
+                        { "mp3-44k-stereo", "mp3", "libmp3lame", 44100, 2, 192000 },
+                        { "m4a-aac-44k-stereo", "m4a", "aac", 44100, 2, 128000 },
+                    };
+                    for(const auto& fixture: fixtures)
+                    {
+                        compareInput(fixture);
+                    }
+                }
+            },
+            {
+                "input/stream-start",
+                "Time to first sample for a 60s track arriving at 1MB/s, streamed vs buffered whole",
+                []
+                {
+                    const MediaFixture fixtures[] = {
+                        { "mp3-44k-stereo", "mp3", "libmp3lame", 44100, 2, 192000 },
+                        { "ogg-vorbis-48k-stereo", "ogg", "libvorbis", 48000, 2, 160000 },
+                        { "flac-44k-stereo", "flac", "flac", 44100, 2 },
+                    };
+                    for(const auto& fixture: fixtures)
+                    {
+                        streamStart(fixture);
+                    }
+                }
+            },
+            {
+                "input/stream-backpressure",
+                "Buffer occupancy and drains with a producer far ahead of real time playback",
+                []
+                {
+                    streamBackpressure();
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,199 @@
+#include "MediaFixtures.h"
+
+#include <cmath>
+#include <filesystem>
+
+extern "C" {
+    #include <libavcodec/avcodec.h>
+    #include <libavformat/avformat.h>
+    #include <libavutil/channel_layout.h>
+    #include <libavutil/samplefmt.h>
+}
+
+namespace CasperTech::bench
+{
+    static constexpr double pi = 3.14159265358979323846;
+
+    std::vector<MediaFixture> standardFixtures()
+    {
+        return {
+            { "wav-s16-44k-stereo", "wav", "pcm_s16le", 44100, 2 },
+            { "wav-s16-48k-mono", "wav", "pcm_s16le", 48000, 1 },
+            { "wav-f32-96k-stereo", "wav", "pcm_f32le", 96000, 2 },
+            { "flac-44k-stereo", "flac", "flac", 44100, 2 },
+            { "mp3-44k-stereo", "mp3", "libmp3lame", 44100, 2, 192000 },
+            { "ogg-vorbis-48k-stereo", "ogg", "libvorbis", 48000, 2, 160000 },
+            { "opus-48k-stereo", "opus", "libopus", 48000, 2, 96000 },
+            { "m4a-aac-44k-stereo", "m4a", "aac", 44100, 2, 128000 },
+            { "m4a-aac-22k-mono", "m4a", "aac", 22050, 1, 64000 },
+        };
+    }
+
+    static void writeSample(AVFrame* frame, AVSampleFormat fmt, int channel, int index, int channels, double value)
+    {
+        const bool planar = av_sample_fmt_is_planar(fmt) != 0;
+        const int bps = av_get_bytes_per_sample(fmt);
+        uint8_t* plane = frame->extended_data[planar ? channel : 0];
+        uint8_t* p = plane + (planar ? index : index * channels + channel) * bps;
+        switch(av_get_packed_sample_fmt(fmt))
+        {
+            case AV_SAMPLE_FMT_U8:
+                *p = static_cast<uint8_t>(128 + value * 127);
+                break;
+            case AV_SAMPLE_FMT_S16:
+                *reinterpret_cast<int16_t*>(p) = static_cast<int16_t>(value * 32767);
+                break;
+            case AV_SAMPLE_FMT_S32:
+                *reinterpret_cast<int32_t*>(p) = static_cast<int32_t>(value * 2147483647.0);
+                break;
+            case AV_SAMPLE_FMT_FLT:
+                *reinterpret_cast<float*>(p) = static_cast<float>(value);
+                break;
+            case AV_SAMPLE_FMT_DBL:
+                *reinterpret_cast<double*>(p) = value;
+                break;
+            default:
+                break;
+        }
+    }
+
+    static bool drain(AVCodecContext* ctx, AVFormatContext* fmtCtx, AVStream* stream, AVPacket* pkt)
+    {
+        int ret = 0;
+        while((ret = avcodec_receive_packet(ctx, pkt)) >= 0)
+        {
+            av_packet_rescale_ts(pkt, ctx->time_base, stream->time_base);
+            pkt->stream_index = stream->index;
+            if (av_interleaved_write_frame(fmtCtx, pkt) < 0)
+            {
+                return false;
+            }
+        }
+        return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+    }
+
+    static bool encode(const MediaFixture& fixture, const AVCodec* codec, const std::string& path, double seconds)
+    {
+        AVFormatContext* fmtCtx = nullptr;
+        if (avformat_alloc_output_context2(&fmtCtx, nullptr, nullptr, path.c_str()) < 0 || fmtCtx == nullptr)
+        {
+            return false;
+        }
+
+        bool ok = false;
+        AVCodecContext* ctx = avcodec_alloc_context3(codec);
+        AVFrame* frame = av_frame_alloc();
+        AVPacket* pkt = av_packet_alloc();
+        AVStream* stream = avformat_new_stream(fmtCtx, nullptr);
+        do
+        {
+            ctx->sample_fmt = codec->sample_fmts != nullptr ? codec->sample_fmts[0] : AV_SAMPLE_FMT_S16;
+            ctx->sample_rate = static_cast<int>(fixture.sampleRate);
+            ctx->channels = fixture.channels;
+            ctx->channel_layout = av_get_default_channel_layout(fixture.channels);
+            ctx->bit_rate = fixture.bitRate;
+            if (fixture.vbrQuality >= 0)
+            {
+                ctx->flags |= AV_CODEC_FLAG_QSCALE;
+                ctx->global_quality = FF_QP2LAMBDA * fixture.vbrQuality;
+            }
+            ctx->time_base = AVRational{ 1, ctx->sample_rate };
+            ctx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+            if (fmtCtx->oformat->flags & AVFMT_GLOBALHEADER)
+            {
+                ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            }
+            if (avcodec_open2(ctx, codec, nullptr) < 0
+                || avcodec_parameters_from_context(stream->codecpar, ctx) < 0)
+            {
+                break;
+            }
+            stream->time_base = ctx->time_base;
+
+            if (!(fmtCtx->oformat->flags & AVFMT_NOFILE) && avio_open(&fmtCtx->pb, path.c_str(), AVIO_FLAG_WRITE) < 0)
+            {
+                break;
+            }
+            AVDictionary* muxerOptions = nullptr;
+            if (!fixture.seekTable)
+            {
+                av_dict_set(&muxerOptions, "write_xing", "0", 0);
+            }
+            const int written = avformat_write_header(fmtCtx, &muxerOptions);
+            av_dict_free(&muxerOptions);
+            if (written < 0)
+            {
+                break;
+            }
+
+            const int frameSize = ctx->frame_size > 0 ? ctx->frame_size : 1024;
+            const auto totalSamples = static_cast<int64_t>(seconds * fixture.sampleRate);
+            bool failed = false;
+            for(int64_t pos = 0; pos < totalSamples && !failed; pos += frameSize)
+            {
+                frame->nb_samples = frameSize;
+                frame->format = ctx->sample_fmt;
+                frame->channel_layout = ctx->channel_layout;
+                frame->channels = ctx->channels;
+                frame->sample_rate = ctx->sample_rate;
+                if (av_frame_get_buffer(frame, 0) < 0)
+                {
+                    failed = true;
+                    break;
+                }
+                for(int i = 0; i < frameSize; i++)
+                {
+                    // 220Hz to 880Hz sweep, which keeps lossy encoders honest
+                    const double t = static_cast<double>(pos + i) / fixture.sampleRate;
+                    const double freq = 220.0 + 660.0 * t / seconds;
+                    const double value = 0.5 * std::sin(2.0 * pi * freq * t);
+                    for(int c = 0; c < fixture.channels; c++)
+                    {
+                        writeSample(frame, ctx->sample_fmt, c, i, fixture.channels, value);
+                    }
+                }
+                frame->pts = pos;
+                failed = avcodec_send_frame(ctx, frame) < 0 || !drain(ctx, fmtCtx, stream, pkt);
+                av_frame_unref(frame);
+            }
+            if (failed)
+            {
+                break;
+            }
+            avcodec_send_frame(ctx, nullptr);
+            if (!drain(ctx, fmtCtx, stream, pkt))
+            {
+                break;
+            }
+            ok = av_write_trailer(fmtCtx) >= 0;
+        }
+        while(false);
+
+        if (!(fmtCtx->oformat->flags & AVFMT_NOFILE))
+        {
+            avio_closep(&fmtCtx->pb);
+        }
+        av_packet_free(&pkt);
+        av_frame_free(&frame);
+        avcodec_free_context(&ctx);
+        avformat_free_context(fmtCtx);
+        return ok;
+    }
+
+    std::string synthesizeFixture(const MediaFixture& fixture, double seconds)
+    {
+        const AVCodec* codec = avcodec_find_encoder_by_name(fixture.encoder.c_str());
+        if (codec == nullptr)
+        {
+            return "";
+        }
+
+        auto path = (std::filesystem::temp_directory_path() / ("node_audio_bench_" + fixture.name + "." + fixture.extension)).string();
+        if (!encode(fixture, codec, path, seconds))
+        {
+            std::filesystem::remove(path);
+            return "";
+        }
+        return path;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    struct MediaFixture
+    {
+        std::string name;
+        std::string extension;
+        std::string encoder;
+        uint32_t sampleRate;
+        uint8_t channels;
+        int64_t bitRate = 0;
+        // Encoder quality for variable bit rate, in place of bitRate. -1 for constant
+        int vbrQuality = -1;
+        // Whether an MP3 gets a Xing header, whose table of contents the demuxer
+        // seeks by
+        bool seekTable = true;
+    };
+
+    // A spread of the containers, codecs, sample formats, rates and channel counts
+    // we see in production.
+    std::vector<MediaFixture> standardFixtures();
+
+    // Encodes seconds of a sine sweep with the fixture's settings into the system
+    // temp directory and returns the path. Returns an empty string if this FFmpeg
+    // build lacks the encoder or muxer, so callers can skip the case.
+    std::string synthesizeFixture(const MediaFixture& fixture, double seconds);
+}
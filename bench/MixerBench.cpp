@@ -0,0 +1,304 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+#include "ProcessStats.h"
+
+#include <exceptions/AudioException.h>
+#include <implementation/AudioPlayerImpl.h>
+#include <implementation/MixerRenderer.h>
+#include <implementation/OutputMixer.h>
+#include <implementation/RtAudioRenderer.h>
+#include <interfaces/IAudioPlayerEventReceiver.h>
+#include <interfaces/IAudioSource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t mixerSampleRate = 48000;
+    static constexpr uint8_t mixerChannels = 2;
+
+    // Negotiates 48kHz stereo float with a voice, as SampleRateConverter would
+    class MixSource: public IAudioSource
+    {
+        public:
+            std::string getName() const override
+            {
+                return "MixSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { mixerSampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return mixerChannels;
+            }
+    };
+
+    struct Voice
+    {
+        std::shared_ptr<MixSource> source;
+        std::shared_ptr<MixerRenderer> renderer;
+    };
+
+    static Voice makeVoice(const std::shared_ptr<OutputMixer>& mixer, float gain)
+    {
+        Voice voice{ std::make_shared<MixSource>(), std::make_shared<MixerRenderer>(mixer) };
+        voice.source->connectSink(voice.renderer);
+        voice.renderer->setVolume(gain);
+        return voice;
+    }
+
+    struct MixRun
+    {
+        double cpuPercent = 0.0;
+        double renderNs = 0.0;
+        uint64_t threads = 0;
+    };
+
+    // Stands in for a device: every buffer period the voices' players top up their
+    // rings and the mixer renders one callback's worth
+    static void driveMixer(const std::shared_ptr<OutputMixer>& mixer, const std::vector<Voice>& voices,
+                           std::chrono::steady_clock::time_point until, int64_t& renderNs, uint64_t& renders)
+    {
+        const uint32_t frames = mixer->getBufferFrames();
+        const std::vector<float> block(frames * mixerChannels, 0.25f);
+        std::vector<float> out(frames * mixerChannels);
+        const auto period = std::chrono::microseconds(static_cast<int64_t>(frames) * 1000000 / mixerSampleRate);
+        auto next = std::chrono::steady_clock::now();
+        while(next < until)
+        {
+            for(const auto& voice: voices)
+            {
+                voice.renderer->audio(reinterpret_cast<const uint8_t*>(block.data()), nullptr, frames);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            mixer->render(out.data(), frames, false);
+            renderNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            renders++;
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    // players voices on one shared mixer, or one mixer and stream thread each as
+    // separate RtAudio streams would have
+    static MixRun runPlayers(uint32_t players, bool shared)
+    {
+        const auto duration = std::chrono::seconds(1);
+        const uint32_t streams = shared ? 1 : players;
+        std::vector<std::shared_ptr<OutputMixer>> mixers;
+        std::vector<std::vector<Voice>> voices(streams);
+        for(uint32_t i = 0; i < streams; i++)
+        {
+            mixers.push_back(OutputMixer::headless(mixerSampleRate, mixerChannels));
+        }
+        for(uint32_t i = 0; i < players; i++)
+        {
+            // Every voice at its own gain, so none can take the unity path
+            const float gain = 0.1f + 0.8f * static_cast<float>(i) / static_cast<float>(players);
+            voices[shared ? 0 : i].push_back(makeVoice(mixers[shared ? 0 : i], gain));
+        }
+
+        std::atomic<int64_t> renderNs{ 0 };
+        std::atomic<uint64_t> renders{ 0 };
+        std::atomic<uint64_t> running{ 0 };
+        std::atomic<uint64_t> peakThreads{ 0 };
+        const auto until = std::chrono::steady_clock::now() + duration;
+        const uint64_t cpuStart = processCpuNs();
+        std::vector<std::thread> threads;
+        for(uint32_t i = 0; i < streams; i++)
+        {
+            threads.emplace_back([&, i]
+            {
+                int64_t ns = 0;
+                uint64_t count = 0;
+                if (++running == streams)
+                {
+                    peakThreads = threadCount();
+                }
+                driveMixer(mixers[i], voices[i], until, ns, count);
+                renderNs += ns;
+                renders += count;
+            });
+        }
+        for(auto& t: threads)
+        {
+            t.join();
+        }
+        const uint64_t cpuNs = processCpuNs() - cpuStart;
+
+        MixRun run;
+        run.cpuPercent = 100.0 * static_cast<double>(cpuNs) / static_cast<double>(std::chrono::nanoseconds(duration).count());
+        run.renderNs = static_cast<double>(renderNs) / static_cast<double>(std::max<uint64_t>(renders, 1));
+        run.threads = peakThreads;
+        for(uint32_t i = 0; i < streams; i++)
+        {
+            for(auto& voice: voices[i])
+            {
+                voice.source->disconnectSink();
+            }
+        }
+        return run;
+    }
+
+    static void compareVoices(uint32_t players)
+    {
+        const MixRun separate = runPlayers(players, false);
+        const MixRun mixed = runPlayers(players, true);
+        std::cout << std::left << std::setw(3) << players << " players"
+                  << std::fixed << std::setprecision(1)
+                  << "  separate streams: cpu " << std::setw(5) << separate.cpuPercent << "%"
+                  << " threads " << std::setw(4) << separate.threads
+                  << "  shared mixer: cpu " << std::setw(5) << mixed.cpuPercent << "%"
+                  << " threads " << std::setw(4) << mixed.threads
+                  << " render " << std::setprecision(0) << mixed.renderNs << "ns/callback"
+                  << std::endl;
+    }
+
+    class QuietReceiver: public IAudioPlayerEventReceiver
+    {
+        public:
+            void onPlayerEvent(const std::shared_ptr<PlayerEvent>& event) override
+            {
+
+            }
+    };
+
+    // Issues command and waits for the player to resolve it
+    static bool runCommand(const std::function<void(const ResultCallback& callback)>& command)
+    {
+        std::promise<CommandResult> done;
+        auto result = done.get_future();
+        command([&done](CommandResult commandResult, const std::string& errorMessage)
+        {
+            done.set_value(commandResult);
+        });
+        return result.get() == CommandResult::Success;
+    }
+
+    // players real players, each with a renderer of type, all playing path. Fails if
+    // any of them couldn't open its output or the file.
+    static bool runRealPlayers(uint32_t players, RendererType type, const std::string& path, MixRun& run)
+    {
+        const auto settle = std::chrono::milliseconds(250);
+        const auto duration = std::chrono::seconds(2);
+        QuietReceiver receiver;
+        PlayerOptions options;
+        options.renderer.type = type;
+
+        std::vector<std::unique_ptr<AudioPlayerImpl>> instances;
+        bool ok = true;
+        try
+        {
+            for(uint32_t i = 0; i < players && ok; i++)
+            {
+                instances.push_back(std::make_unique<AudioPlayerImpl>(&receiver, options));
+                AudioPlayerImpl* player = instances.back().get();
+                const float volume = 0.1f + 0.8f * static_cast<float>(i) / static_cast<float>(players);
+                ok = runCommand([&](const ResultCallback& callback){ player->load(path, callback); })
+                     && runCommand([&](const ResultCallback& callback){ player->setVolume(volume, 0, VolumeCurve::Linear, callback); })
+                     && runCommand([&](const ResultCallback& callback){ player->play(callback); });
+            }
+        }
+        catch(AudioException&)
+        {
+            ok = false;
+        }
+
+        if (ok)
+        {
+            std::this_thread::sleep_for(settle);
+            const uint64_t cpuStart = processCpuNs();
+            run.threads = threadCount();
+            std::this_thread::sleep_for(duration);
+            const uint64_t cpuNs = processCpuNs() - cpuStart;
+            run.cpuPercent = 100.0 * static_cast<double>(cpuNs) / static_cast<double>(std::chrono::nanoseconds(duration).count());
+        }
+
+        for(auto& player: instances)
+        {
+            runCommand([&](const ResultCallback& callback){ player->stop(callback); });
+        }
+        return ok;
+    }
+
+    static void comparePlayers(uint32_t players, const std::string& path)
+    {
+        MixRun separate;
+        MixRun mixed;
+        std::cout << std::left << std::setw(3) << players << " players" << std::fixed << std::setprecision(1);
+        if (!runRealPlayers(players, RendererType::RtAudio, path, separate))
+        {
+            std::cout << "  couldn't open a stream for every player" << std::endl;
+            return;
+        }
+        if (!runRealPlayers(players, RendererType::Mixer, path, mixed))
+        {
+            std::cout << "  couldn't open the mixer" << std::endl;
+            return;
+        }
+        std::cout << "  own streams: cpu " << std::setw(5) << separate.cpuPercent << "%"
+                  << " threads " << std::setw(4) << separate.threads
+                  << "  mixer: cpu " << std::setw(5) << mixed.cpuPercent << "%"
+                  << " threads " << std::setw(4) << mixed.threads
+                  << std::endl;
+    }
+
+    std::vector<Benchmark> mixerBenchmarks()
+    {
+        return {
+            {
+                "mixer/voices",
+                "Process CPU and threads for N voices on one headless mixer vs a mixer and thread each",
+                []
+                {
+                    for(uint32_t players: { 1u, 4u, 16u, 64u })
+                    {
+                        compareVoices(players);
+                    }
+                }
+            },
+            {
+                "mixer/players",
+                "Process CPU and threads for N players on the output device, RendererType::Mixer vs a stream each",
+                []
+                {
+                    if (RtAudioRenderer().getDevices().empty())
+                    {
+                        std::cout << "skipped, no output device" << std::endl;
+                        return;
+                    }
+                    // Already at the mixer's usual rate, so neither side resamples
+                    const std::string path = synthesizeFixture({ "wav-s16-48k-stereo", "wav", "pcm_s16le", 48000, 2 }, 10.0);
+                    if (path.empty())
+                    {
+                        std::cout << "skipped, missing an encoder in this FFmpeg build" << std::endl;
+                        return;
+                    }
+                    for(uint32_t players: { 1u, 4u, 16u })
+                    {
+                        comparePlayers(players, path);
+                    }
+                    std::filesystem::remove(path);
+                }
+            }
+        };
+    }
+}
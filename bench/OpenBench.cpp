@@ -0,0 +1,147 @@
+#include "Benchmarks.h"
+#include "FirstSampleProbe.h"
+#include "MediaFixtures.h"
+
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/SampleRateConverter.h>
+#include <exceptions/AudioException.h>
+#include <exceptions/CommandException.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t openLoads = 20;
+    // Long enough that probing the default 5s of a file is a fraction of it
+    static constexpr double openFixtureSeconds = 30.0;
+
+    // Opens path with options and plays it into a fresh chain until the first
+    // sample reaches the renderer. Returns the time that took, or a negative
+    // value if nothing arrived.
+    static double openToFirstSample(const std::string& path, const OpenOptions& options)
+    {
+        auto renderer = std::make_shared<FirstSampleProbe<NullRenderer>>(ClockMode::Unpaced);
+        auto resampler = std::make_shared<SampleRateConverter>();
+        resampler->connectSink(renderer);
+
+        const int64_t start = probeNowNs();
+        auto source = std::make_shared<FFSource>();
+        source->setOpenOptions(options);
+        // As the player loads it
+        source->setLazyDecoder(options.skipStreamInfo);
+        source->load(path);
+        source->connectSink(resampler);
+        FFFrame frame;
+        int result = 1;
+        while(renderer->firstSampleNs == 0 && (result > 0 || result == -11))
+        {
+            result = source->getPacket(&frame);
+        }
+        source->disconnectSink();
+        resampler->disconnectSink();
+        if (renderer->firstSampleNs == 0)
+        {
+            return -1.0;
+        }
+        return static_cast<double>(renderer->firstSampleNs - start) / 1e6;
+    }
+
+    // Mean and worst over openLoads, after one load to warm the page cache
+    static bool timeOpens(const std::string& path, const OpenOptions& options, double& meanMs, double& maxMs)
+    {
+        if (openToFirstSample(path, options) < 0.0)
+        {
+            return false;
+        }
+        double totalMs = 0.0;
+        maxMs = 0.0;
+        for(uint32_t i = 0; i < openLoads; i++)
+        {
+            const double ms = openToFirstSample(path, options);
+            if (ms < 0.0)
+            {
+                return false;
+            }
+            totalMs += ms;
+            maxMs = std::max(maxMs, ms);
+        }
+        meanMs = totalMs / openLoads;
+        return true;
+    }
+
+    static void compareOpen(const MediaFixture& fixture, const OpenOptions& fast)
+    {
+        const std::string path = synthesizeFixture(fixture, openFixtureSeconds);
+        std::cout << std::left << std::setw(22) << fixture.name << std::right;
+        if (path.empty())
+        {
+            std::cout << " skipped, no encoder" << std::endl;
+            return;
+        }
+
+        double defaultMeanMs = 0.0;
+        double defaultMaxMs = 0.0;
+        double fastMeanMs = 0.0;
+        double fastMaxMs = 0.0;
+        try
+        {
+            if (!timeOpens(path, OpenOptions{}, defaultMeanMs, defaultMaxMs) || !timeOpens(path, fast, fastMeanMs, fastMaxMs))
+            {
+                std::cout << " decode failed" << std::endl;
+                std::filesystem::remove(path);
+                return;
+            }
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+            std::filesystem::remove(path);
+            return;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " failed: " << e.message() << std::endl;
+            std::filesystem::remove(path);
+            return;
+        }
+        std::filesystem::remove(path);
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << " load to first sample, default " << std::setw(7) << defaultMeanMs << "ms (max " << std::setw(7) << defaultMaxMs << "ms)"
+                  << "  fast open " << std::setw(7) << fastMeanMs << "ms (max " << std::setw(7) << fastMaxMs << "ms)"
+                  << "  " << std::setprecision(1) << defaultMeanMs / fastMeanMs << "x" << std::endl;
+    }
+
+    std::vector<Benchmark> openBenchmarks()
+    {
+        return {
+            {
+                "open/first-sample",
+                "Time from load to the first sample at the renderer for 30s files, FFmpeg's default probing vs bounded probing, skipped stream info and the format taken from the extension",
+                []
+                {
+                    OpenOptions fast;
+                    fast.probeSize = 32 * 1024;
+                    fast.analyzeDurationMs = 100;
+                    fast.skipStreamInfo = true;
+                    fast.formatFromExtension = true;
+
+                    std::vector<MediaFixture> fixtures = standardFixtures();
+                    // Raw ADTS, which has no header to skip probing with
+                    fixtures.push_back({ "aac-adts-44k-stereo", "aac", "aac", 44100, 2, 128000 });
+                    for(const auto& fixture: fixtures)
+                    {
+                        compareOpen(fixture, fast);
+                    }
+                }
+            }
+        };
+    }
+}
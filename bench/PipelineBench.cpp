@@ -0,0 +1,283 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+#include "ProcessStats.h"
+
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/ReadAheadBuffer.h>
+#include <implementation/SampleRateConverter.h>
+#include <implementation/VolumeFilter.h>
+#include <exceptions/AudioException.h>
+#include <exceptions/CommandException.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace CasperTech::bench
+{
+    static constexpr double fixtureSeconds = 30.0;
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Each stage is wrapped so its audio() call is timed. The stages call each other,
+    // so these are inclusive times; a stage's own cost is its time minus the next's.
+    class TimedVolumeFilter: public VolumeFilter
+    {
+        public:
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const int64_t start = nowNs();
+                VolumeFilter::audio(buffer, planarChannel, sampleCount);
+                ns += nowNs() - start;
+                samples += sampleCount;
+            }
+
+            int64_t ns = 0;
+            uint64_t samples = 0;
+    };
+
+    class TimedSampleRateConverter: public SampleRateConverter
+    {
+        public:
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const int64_t start = nowNs();
+                SampleRateConverter::audio(buffer, planarChannel, sampleCount);
+                ns += nowNs() - start;
+            }
+
+            int64_t ns = 0;
+    };
+
+    // Stands in for a typical device: 48kHz float only, so every fixture exercises
+    // format conversion and most exercise rate conversion.
+    class DeviceLikeSink: public NullRenderer
+    {
+        public:
+            DeviceLikeSink()
+                : NullRenderer(ClockMode::Unpaced)
+            {
+
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { 48000 };
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const int64_t start = nowNs();
+                NullRenderer::audio(buffer, planarChannel, sampleCount);
+                ns += nowNs() - start;
+            }
+
+            int64_t ns = 0;
+    };
+
+    // Counts the allocations made by the thread the read-ahead queue feeds, which
+    // runs this and every stage after it, once the first warmupBlocks are through
+    class AllocCountingVolumeFilter: public VolumeFilter
+    {
+        public:
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const uint64_t before = threadAllocationCount();
+                VolumeFilter::audio(buffer, planarChannel, sampleCount);
+                if (++blocks > warmupBlocks)
+                {
+                    allocations += threadAllocationCount() - before;
+                }
+            }
+
+            static constexpr uint64_t warmupBlocks = 100;
+            uint64_t blocks = 0;
+            uint64_t allocations = 0;
+    };
+
+    static void runFixture(const MediaFixture& fixture)
+    {
+        const std::string path = synthesizeFixture(fixture, fixtureSeconds);
+        std::cout << std::left << std::setw(24) << fixture.name;
+        if (path.empty())
+        {
+            std::cout << " skipped, no " << fixture.encoder << " encoder in this FFmpeg build" << std::endl;
+            return;
+        }
+
+        auto sink = std::make_shared<DeviceLikeSink>();
+        auto resampler = std::make_shared<TimedSampleRateConverter>();
+        auto volume = std::make_shared<TimedVolumeFilter>();
+        auto source = std::make_shared<FFSource>();
+        try
+        {
+            source->load(path);
+            resampler->connectSink(sink);
+            volume->connectSink(resampler);
+            source->connectSink(volume);
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+            return;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " pipeline failed: " << e.message() << std::endl;
+            return;
+        }
+        volume->setVolume(0.5f);
+
+        FFFrame frame;
+        const uint64_t allocsBefore = allocationCount();
+        const int64_t start = nowNs();
+        int result = 1;
+        while(result > 0 || result == -11)
+        {
+            result = source->getPacket(&frame);
+        }
+        const int64_t totalNs = nowNs() - start;
+        const uint64_t allocs = allocationCount() - allocsBefore;
+
+        source->disconnectSink();
+        volume->disconnectSink();
+        resampler->disconnectSink();
+        std::filesystem::remove(path);
+
+        if (result < 0 || volume->samples == 0)
+        {
+            std::cout << " decode failed: " << FFSource::getError(result) << std::endl;
+            return;
+        }
+
+        const auto samples = static_cast<double>(volume->samples);
+        const double audioSeconds = samples / fixture.sampleRate;
+        auto perSample = [samples](int64_t ns)
+        {
+            return static_cast<double>(ns) / samples;
+        };
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << " rtf " << std::setw(7) << audioSeconds / (static_cast<double>(totalNs) / 1e9) << "x"
+                  << "  ns/sample decode " << std::setw(6) << perSample(totalNs - volume->ns)
+                  << " volume " << std::setw(6) << perSample(volume->ns - resampler->ns)
+                  << " resample " << std::setw(6) << perSample(resampler->ns - sink->ns)
+                  << " sink " << std::setw(5) << perSample(sink->ns)
+                  << "  allocs/s " << std::setw(7) << static_cast<double>(allocs) / audioSeconds
+                  << std::endl;
+    }
+
+    // Playback after warm-up should not touch the heap past the decoder. What
+    // libavformat and libavcodec allocate per packet is reported separately.
+    static void runSteadyState(const MediaFixture& fixture)
+    {
+        const std::string path = synthesizeFixture(fixture, fixtureSeconds);
+        std::cout << std::left << std::setw(24) << fixture.name;
+        if (path.empty())
+        {
+            std::cout << " skipped, no " << fixture.encoder << " encoder in this FFmpeg build" << std::endl;
+            return;
+        }
+
+        auto sink = std::make_shared<DeviceLikeSink>();
+        auto resampler = std::make_shared<SampleRateConverter>();
+        auto volume = std::make_shared<AllocCountingVolumeFilter>();
+        auto readAhead = std::make_shared<ReadAheadBuffer>(500);
+        auto source = std::make_shared<FFSource>();
+        try
+        {
+            source->load(path);
+            resampler->connectSink(sink);
+            volume->connectSink(resampler);
+            readAhead->connectSink(volume);
+            source->connectSink(readAhead);
+        }
+        catch(const CommandException& e)
+        {
+            std::cout << " load failed: " << e.message() << std::endl;
+            return;
+        }
+        catch(const AudioException& e)
+        {
+            std::cout << " pipeline failed: " << e.message() << std::endl;
+            return;
+        }
+        // Mid ramp for the whole run, the most work the volume stage can do
+        volume->setVolume(0.5f, 600000);
+
+        FFFrame frame;
+        uint64_t packets = 0;
+        uint64_t decodeAllocs = 0;
+        int result = 1;
+        while(result > 0 || result == -11)
+        {
+            const uint64_t before = threadAllocationCount();
+            result = source->getPacket(&frame);
+            if (++packets > AllocCountingVolumeFilter::warmupBlocks)
+            {
+                decodeAllocs += threadAllocationCount() - before;
+            }
+        }
+        readAhead->waitUntilDrained();
+        readAhead->shutdown();
+
+        source->disconnectSink();
+        readAhead->disconnectSink();
+        volume->disconnectSink();
+        resampler->disconnectSink();
+        std::filesystem::remove(path);
+
+        if (result < 0 || volume->blocks <= AllocCountingVolumeFilter::warmupBlocks)
+        {
+            std::cout << " decode failed: " << FFSource::getError(result) << std::endl;
+            return;
+        }
+
+        const uint64_t steadyPackets = packets - AllocCountingVolumeFilter::warmupBlocks;
+        std::cout << std::fixed << std::setprecision(1)
+                  << " decoder allocs/packet " << std::setw(5) << static_cast<double>(decodeAllocs) / static_cast<double>(steadyPackets)
+                  << "  pipeline allocs " << std::setw(5) << volume->allocations
+                  << " in " << volume->blocks - AllocCountingVolumeFilter::warmupBlocks << " blocks"
+                  << "  " << verdict(volume->allocations == 0) << std::endl;
+    }
+
+    std::vector<Benchmark> pipelineBenchmarks()
+    {
+        return {
+            {
+                "pipeline/decode-chain",
+                "FFSource -> VolumeFilter -> SampleRateConverter -> discarding sink, unpaced, per input format",
+                []
+                {
+                    for(const auto& fixture: standardFixtures())
+                    {
+                        runFixture(fixture);
+                    }
+                    std::cout << "peak rss " << peakRssBytes() / (1024 * 1024) << " MB" << std::endl;
+                }
+            },
+            {
+                "pipeline/steady-state-allocs",
+                "Heap allocations after warm-up, FFSource -> ReadAheadBuffer -> VolumeFilter -> SampleRateConverter -> discarding sink",
+                []
+                {
+                    for(const auto& fixture: standardFixtures())
+                    {
+                        runSteadyState(fixture);
+                    }
+                }
+            }
+        };
+    }
+}
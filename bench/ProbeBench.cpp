@@ -0,0 +1,113 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+
+#include <implementation/MediaProbe.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    // Copies of each fixture, standing in for a library
+    static constexpr uint32_t probeCopies = 60;
+    static constexpr double probeFixtureSeconds = 10.0;
+    // What the runs are extrapolated to
+    static constexpr double probeLibraryFiles = 100000.0;
+
+    struct ProbeRun
+    {
+        double seconds = 0.0;
+        size_t failed = 0;
+    };
+
+    static ProbeRun timeProbe(const std::vector<std::string>& paths, const ProbeOptions& options)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<MediaInfo> results = MediaProbe::probe(paths, options);
+        ProbeRun run;
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for(const MediaInfo& info: results)
+        {
+            if (!info.error.empty())
+            {
+                run.failed++;
+            }
+        }
+        return run;
+    }
+
+    static void reportProbe(const char* name, size_t files, const ProbeRun& run)
+    {
+        const double filesPerSecond = static_cast<double>(files) / run.seconds;
+        std::cout << std::left << std::setw(26) << name << std::right
+                  << std::fixed << std::setprecision(0)
+                  << std::setw(9) << filesPerSecond << " files/s"
+                  << std::setprecision(1)
+                  << "  100k files in " << std::setw(7) << probeLibraryFiles / filesPerSecond << "s";
+        if (run.failed != 0)
+        {
+            std::cout << "  (" << run.failed << " failed)";
+        }
+        std::cout << std::endl;
+    }
+
+    std::vector<Benchmark> probeBenchmarks()
+    {
+        return {
+            {
+                "probe/library",
+                "MediaProbe over copies of the standard fixtures: one thread vs the pool with nothing cached, then the pool answering from the on-disk cache",
+                []
+                {
+                    std::error_code ec;
+                    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "node_audio_probe_bench";
+                    std::filesystem::remove_all(dir, ec);
+                    std::filesystem::create_directories(dir, ec);
+
+                    std::vector<std::string> paths;
+                    for(const auto& fixture: standardFixtures())
+                    {
+                        const std::string path = synthesizeFixture(fixture, probeFixtureSeconds);
+                        if (path.empty())
+                        {
+                            continue;
+                        }
+                        for(uint32_t i = 0; i < probeCopies; i++)
+                        {
+                            const std::filesystem::path copy = dir / (fixture.name + "-" + std::to_string(i) + "." + fixture.extension);
+                            std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, ec);
+                            paths.push_back(copy.string());
+                        }
+                        std::filesystem::remove(path, ec);
+                    }
+                    if (paths.empty())
+                    {
+                        std::cout << "skipped, no encoder" << std::endl;
+                        return;
+                    }
+
+                    // Once through first, so every run reads from the page cache
+                    ProbeOptions single;
+                    single.threads = 1;
+                    timeProbe(paths, single);
+
+                    ProbeOptions pooled;
+                    pooled.cacheFile = (dir / "probe.cache").string();
+                    std::cout << paths.size() << " files, " << std::max(1u, std::thread::hardware_concurrency()) << " threads in the pool" << std::endl;
+                    reportProbe("1 thread", paths.size(), timeProbe(paths, single));
+                    reportProbe("pool, cold cache", paths.size(), timeProbe(paths, pooled));
+                    reportProbe("pool, warm cache", paths.size(), timeProbe(paths, pooled));
+
+                    std::filesystem::remove_all(dir, ec);
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,199 @@
+#include "ProcessStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#endif
+
+static std::atomic<uint64_t> allocations{0};
+// Plain data, so reading it never needs to allocate from inside the allocator
+static thread_local uint64_t threadAllocations = 0;
+
+#if defined(__GLIBC__)
+// Interpose the C allocator so allocations made by FFmpeg are counted too. glibc
+// still exports its own implementations under these names.
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+
+    void* malloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        threadAllocations++;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        threadAllocations++;
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        threadAllocations++;
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        threadAllocations++;
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        return memalign(alignment, size);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size)
+    {
+        void* p = memalign(alignment, size);
+        if (p == nullptr)
+        {
+            return 12; // ENOMEM
+        }
+        *ptr = p;
+        return 0;
+    }
+
+    void free(void* ptr)
+    {
+        __libc_free(ptr);
+    }
+}
+
+void* operator new(size_t size)
+{
+    // malloc above does the counting
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+#else
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    threadAllocations++;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+#endif
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace CasperTech::bench
+{
+    uint64_t allocationCount()
+    {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t threadAllocationCount()
+    {
+        return threadAllocations;
+    }
+
+    uint64_t peakRssBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        struct rusage usage = {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    uint64_t processCpuNs()
+    {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        {
+            return 0;
+        }
+        auto ticks = [](const FILETIME& t)
+        {
+            return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+        };
+        // FILETIME counts 100ns intervals
+        return (ticks(kernel) + ticks(user)) * 100;
+#else
+        struct rusage usage = {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+        auto ns = [](const timeval& t)
+        {
+            return static_cast<uint64_t>(t.tv_sec) * 1000000000 + static_cast<uint64_t>(t.tv_usec) * 1000;
+        };
+        return ns(usage.ru_utime) + ns(usage.ru_stime);
+#endif
+    }
+
+    uint64_t threadCount()
+    {
+#if defined(__linux__)
+        DIR* dir = opendir("/proc/self/task");
+        if (dir == nullptr)
+        {
+            return 0;
+        }
+        uint64_t count = 0;
+        while(struct dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+            {
+                count++;
+            }
+        }
+        closedir(dir);
+        return count;
+#else
+        return 0;
+#endif
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CasperTech::bench
+{
+    // Number of heap allocations made by the process so far. Counts operator new
+    // everywhere, and on glibc also malloc/calloc/realloc/memalign so allocations
+    // made inside FFmpeg are included.
+    uint64_t allocationCount();
+
+    // As allocationCount, but only those made by the calling thread
+    uint64_t threadAllocationCount();
+
+    // Peak resident set size of the process in bytes, or 0 if unknown
+    uint64_t peakRssBytes();
+
+    // User plus system CPU time used by every thread of the process so far
+    uint64_t processCpuNs();
+
+    // Threads currently running in the process, or 0 if unknown
+    uint64_t threadCount();
+}
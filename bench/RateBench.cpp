@@ -0,0 +1,290 @@
+#include "Benchmarks.h"
+
+#include <implementation/RateFilter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t rateSampleRate = 48000;
+    static constexpr uint32_t rateChannels = 2;
+    // 20ms, so a second of the test signal is a whole number of blocks
+    static constexpr uint64_t rateBlockFrames = 960;
+    static constexpr uint32_t rateSeconds = 60;
+    static constexpr double rateToneHz = 220.0;
+    // Taken from the middle of the output to measure its pitch
+    static constexpr size_t ratePitchFrames = 4096;
+    // Tones for the varispeed check at 2x: the first lands at 10kHz and should come
+    // through whole, the second would land at 30kHz, above the output's Nyquist,
+    // and anything of it left is aliasing
+    static constexpr double ratePassHz = 5000.0;
+    static constexpr double rateAliasHz = 15000.0;
+    // Most of the second tone allowed through, relative to the input
+    static constexpr double rateMaxAliasDb = -50.0;
+
+    class RateToneSource: public IAudioSource
+    {
+        public:
+            std::string getName() const override
+            {
+                return "RateToneSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { rateSampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return rateChannels;
+            }
+    };
+
+    // Counts what comes out, keeping a stretch from the middle to measure
+    class RateSink: public IAudioSink
+    {
+        public:
+            explicit RateSink(uint64_t captureFrom)
+                : _captureFrom(captureFrom)
+            {
+
+            }
+
+            std::string getName() const override
+            {
+                return "RateSink";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { rateSampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return rateChannels;
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const auto* samples = reinterpret_cast<const float*>(buffer);
+                for(uint64_t i = 0; i < sampleCount; i++)
+                {
+                    const uint64_t frame = frames + i;
+                    if (frame >= _captureFrom && captured.size() < ratePitchFrames)
+                    {
+                        captured.push_back(samples[i * rateChannels]);
+                    }
+                }
+                frames += sampleCount;
+            }
+
+            void onEos() override
+            {
+
+            }
+
+            uint64_t frames = 0;
+            std::vector<float> captured;
+
+        private:
+            uint64_t _captureFrom;
+    };
+
+    // A held vowel: a 220Hz fundamental with a few harmonics, swelling four times a
+    // second like syllables. A second of it loops seamlessly.
+    static std::vector<float> makeVowel()
+    {
+        const double pi = std::acos(-1.0);
+        std::vector<float> signal(static_cast<size_t>(rateSampleRate) * rateChannels);
+        for(uint32_t i = 0; i < rateSampleRate; i++)
+        {
+            const double t = static_cast<double>(i) / rateSampleRate;
+            const double envelope = 0.6 + 0.4 * std::sin(2.0 * pi * 4.0 * t);
+            const double v = envelope * (0.5 * std::sin(2.0 * pi * rateToneHz * t)
+                                         + 0.25 * std::sin(2.0 * pi * rateToneHz * 2.0 * t)
+                                         + 0.12 * std::sin(2.0 * pi * rateToneHz * 3.0 * t));
+            for(uint32_t c = 0; c < rateChannels; c++)
+            {
+                signal[i * rateChannels + c] = static_cast<float>(v);
+            }
+        }
+        return signal;
+    }
+
+    // A second of a sine at hz, which loops seamlessly for a whole number of Hz
+    static std::vector<float> makeTone(double hz)
+    {
+        const double pi = std::acos(-1.0);
+        std::vector<float> signal(static_cast<size_t>(rateSampleRate) * rateChannels);
+        for(uint32_t i = 0; i < rateSampleRate; i++)
+        {
+            const auto v = static_cast<float>(0.5 * std::sin(2.0 * pi * hz * static_cast<double>(i) / rateSampleRate));
+            for(uint32_t c = 0; c < rateChannels; c++)
+            {
+                signal[i * rateChannels + c] = v;
+            }
+        }
+        return signal;
+    }
+
+    static double rms(const std::vector<float>& x)
+    {
+        double sum = 0.0;
+        for(const float v: x)
+        {
+            sum += static_cast<double>(v) * v;
+        }
+        return x.empty() ? 0.0 : std::sqrt(sum / static_cast<double>(x.size()));
+    }
+
+    // Fundamental of a stretch of mono audio, from the strongest normalised
+    // autocorrelation between 50Hz and 1kHz, refined between lags
+    static double measurePitch(const std::vector<float>& x)
+    {
+        const size_t minLag = rateSampleRate / 1000;
+        const size_t maxLag = rateSampleRate / 50;
+        if (x.size() < maxLag * 2)
+        {
+            return 0.0;
+        }
+        const size_t window = x.size() - maxLag - 1;
+        std::vector<double> scores(maxLag + 2, 0.0);
+        for(size_t lag = minLag; lag <= maxLag + 1; lag++)
+        {
+            double dot = 0.0;
+            double energyA = 0.0;
+            double energyB = 0.0;
+            for(size_t i = 0; i < window; i++)
+            {
+                dot += static_cast<double>(x[i]) * x[i + lag];
+                energyA += static_cast<double>(x[i]) * x[i];
+                energyB += static_cast<double>(x[i + lag]) * x[i + lag];
+            }
+            scores[lag] = dot / std::sqrt(std::max(energyA * energyB, 1e-12));
+        }
+        // The first peak close to the best, so a multiple of the period isn't
+        // taken for it
+        const double best = *std::max_element(scores.begin() + static_cast<std::ptrdiff_t>(minLag), scores.begin() + static_cast<std::ptrdiff_t>(maxLag));
+        size_t lag = minLag + 1;
+        for(; lag < maxLag; lag++)
+        {
+            if (scores[lag] > 0.9 * best && scores[lag] >= scores[lag - 1] && scores[lag] >= scores[lag + 1])
+            {
+                break;
+            }
+        }
+        const double a = scores[lag - 1];
+        const double b = scores[lag];
+        const double c = scores[lag + 1];
+        const double denominator = a - 2.0 * b + c;
+        const double shift = denominator != 0.0 ? 0.5 * (a - c) / denominator : 0.0;
+        return rateSampleRate / (static_cast<double>(lag) + shift);
+    }
+
+    struct RateRun
+    {
+        double ns = 0.0;
+        uint64_t inFrames = 0;
+        uint64_t outFrames = 0;
+        double pitchHz = 0.0;
+        // Level of the captured stretch against the 0.5 amplitude input
+        double levelDb = 0.0;
+    };
+
+    static RateRun runRate(const std::vector<float>& signal, double rate, PlaybackRateMode mode)
+    {
+        const uint64_t inFrames = static_cast<uint64_t>(rateSampleRate) * rateSeconds;
+        auto source = std::make_shared<RateToneSource>();
+        auto filter = std::make_shared<RateFilter>();
+        auto sink = std::make_shared<RateSink>(static_cast<uint64_t>(static_cast<double>(inFrames) / rate / 2.0));
+        filter->connectSink(sink);
+        source->connectSink(filter);
+        filter->setRate(rate, mode);
+
+        int64_t ns = 0;
+        for(uint64_t frame = 0; frame < inFrames; frame += rateBlockFrames)
+        {
+            const float* block = signal.data() + (frame % rateSampleRate) * rateChannels;
+            const auto start = std::chrono::steady_clock::now();
+            filter->audio(reinterpret_cast<const uint8_t*>(block), nullptr, rateBlockFrames);
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        filter->onEos();
+        source->disconnectSink();
+        filter->disconnectSink();
+
+        RateRun run;
+        run.ns = static_cast<double>(ns);
+        run.inFrames = inFrames;
+        run.outFrames = sink->frames;
+        run.pitchHz = measurePitch(sink->captured);
+        run.levelDb = 20.0 * std::log10(std::max(rms(sink->captured), 1e-9) / (0.5 / std::sqrt(2.0)));
+        return run;
+    }
+
+    std::vector<Benchmark> rateBenchmarks()
+    {
+        return {
+            {
+                "rate/stretch",
+                "RateFilter on 60s of stereo 48kHz float at 0.5x-2x, varispeed and time-stretch: cost on one core, output length and pitch, and varispeed aliasing at 2x",
+                []
+                {
+                    const std::vector<float> vowel = makeVowel();
+                    const double rates[] = { 0.5, 0.75, 1.0, 1.25, 1.5, 2.0 };
+                    const std::pair<const char*, PlaybackRateMode> modes[] = {
+                        { "varispeed", PlaybackRateMode::Varispeed },
+                        { "timestretch", PlaybackRateMode::TimeStretch },
+                    };
+                    std::cout << "input pitch " << rateToneHz << "Hz" << std::endl;
+                    for(const auto& [name, mode]: modes)
+                    {
+                        for(const double rate: rates)
+                        {
+                            const RateRun run = runRate(vowel, rate, mode);
+                            const double outSeconds = static_cast<double>(run.outFrames) / rateSampleRate;
+                            const double expected = static_cast<double>(run.inFrames) / rate / rateSampleRate;
+                            std::cout << std::left << std::setw(12) << name << std::right
+                                      << std::fixed << std::setprecision(2)
+                                      << rate << "x"
+                                      << " out " << std::setw(6) << outSeconds << "s"
+                                      << " (expected " << std::setw(6) << expected << "s)"
+                                      << " pitch " << std::setprecision(1) << std::setw(5) << run.pitchHz << "Hz"
+                                      << std::setprecision(2)
+                                      << " " << std::setw(6) << run.ns / static_cast<double>(run.outFrames) << " ns/frame"
+                                      << " " << std::setprecision(0) << std::setw(6) << outSeconds * 1e9 / run.ns << "x real time"
+                                      << std::setprecision(2)
+                                      << " (" << run.ns / (outSeconds * 1e9) * 100.0 << "% of a core)"
+                                      << std::endl;
+                        }
+                    }
+
+                    const RateRun pass = runRate(makeTone(ratePassHz), 2.0, PlaybackRateMode::Varispeed);
+                    const RateRun alias = runRate(makeTone(rateAliasHz), 2.0, PlaybackRateMode::Varispeed);
+                    std::cout << "varispeed 2x" << std::fixed << std::setprecision(1)
+                              << "  " << ratePassHz / 1000.0 << "kHz tone " << std::setw(6) << pass.levelDb << "dB"
+                              << "  " << rateAliasHz / 1000.0 << "kHz tone (aliasing) " << std::setw(6) << alias.levelDb << "dB"
+                              << "  " << verdict(alias.levelDb < rateMaxAliasDb && pass.levelDb > -1.0) << std::endl;
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,139 @@
+#include "Benchmarks.h"
+
+#include <implementation/NullRenderer.h>
+#include <implementation/PipelineStats.h>
+#include <implementation/ReadAheadBuffer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t readAheadSampleRate = 48000;
+
+    // Stands in for a decoder reading from slow storage: 10ms blocks of 48kHz stereo
+    // float as fast as they're accepted, going quiet for stallMs every stallEvery blocks
+    class StallingSource: public IAudioSource
+    {
+        public:
+            std::string getName() const override
+            {
+                return "StallingSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { readAheadSampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void run(uint32_t blocks, uint32_t stallEvery, uint32_t stallMs)
+            {
+                const uint64_t blockSamples = readAheadSampleRate / 100;
+                std::vector<uint8_t> block(blockSamples * 2 * sizeof(float));
+                for(uint32_t i = 1; i <= blocks; i++)
+                {
+                    _sink->audio(block.data(), nullptr, blockSamples);
+                    if (i % stallEvery == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+                    }
+                }
+            }
+    };
+
+    // The same stalls with and without a read-ahead queue between the source and a
+    // real time NullRenderer. Without one every stall longer than the renderer's 50ms
+    // buffer is an underrun; with one the queue should cover them all.
+    static void stallingDecoder(uint32_t readAheadMs, uint64_t expected)
+    {
+        const uint32_t blocks = 300;
+        const uint32_t stallEvery = 50;
+        const uint32_t stallMs = 150;
+
+        auto stats = std::make_shared<PipelineStats>();
+        auto source = std::make_shared<StallingSource>();
+        auto renderer = std::make_shared<NullRenderer>(ClockMode::RealTime);
+        std::shared_ptr<ReadAheadBuffer> readAhead;
+        renderer->setStats(stats);
+        if (readAheadMs > 0)
+        {
+            readAhead = std::make_shared<ReadAheadBuffer>(readAheadMs);
+            readAhead->connectSink(renderer);
+            source->connectSink(readAhead);
+            readAhead->setStats(stats);
+        }
+        else
+        {
+            source->connectSink(renderer);
+        }
+
+        stats->setPlaying(true);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t peakMs = 0;
+        std::atomic<bool> done{ false };
+        std::thread producer([&]
+        {
+            source->run(blocks, stallEvery, stallMs);
+            done = true;
+        });
+        // Sample the queue depth while it runs, as getStats() would
+        while(!done)
+        {
+            peakMs = std::max(peakMs, stats->readAheadMs.load());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        producer.join();
+        if (readAhead)
+        {
+            readAhead->waitUntilDrained();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        source->disconnectSink();
+        if (readAhead)
+        {
+            readAhead->shutdown();
+            readAhead->disconnectSink();
+        }
+
+        const auto snapshot = stats->snapshot();
+        std::cout << "read-ahead " << std::left << std::setw(5) << readAheadMs << "ms"
+                  << " underruns " << std::setw(4) << snapshot.underruns
+                  << " expected " << std::setw(4) << expected
+                  << " peak depth " << std::setw(4) << peakMs << "ms"
+                  << " " << std::fixed << std::setprecision(2) << elapsed << "s"
+                  << "  " << verdict(snapshot.underruns == expected) << std::endl;
+    }
+
+    std::vector<Benchmark> readAheadBenchmarks()
+    {
+        return {
+            {
+                "readahead/stalling-decoder",
+                "Underruns from a decoder that stalls 150ms every 500ms, with and without read-ahead",
+                []
+                {
+                    stallingDecoder(0, 5);
+                    stallingDecoder(250, 0);
+                    stallingDecoder(500, 0);
+                }
+            }
+        };
+    }
+}
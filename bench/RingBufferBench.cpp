@@ -0,0 +1,461 @@
+#include "Benchmarks.h"
+#include "LockingRingBuffer.h"
+
+#include <implementation/RingBuffer.h>
+#include <implementation/SampleRateConverter.h>
+#include <interfaces/IAudioSink.h>
+#include <interfaces/IAudioSource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace CasperTech::bench
+{
+    // Stereo float, the most common device format
+    static constexpr size_t frameSize = 8;
+
+    // Each 32-bit word written carries a running sequence number which never takes
+    // the value 0. The consumer skips zero words (silence padding from an empty ring)
+    // and checks the rest arrive in order, which doubles as a stress test of the
+    // ring's ordering guarantees.
+    struct SequenceChecker
+    {
+        uint32_t expected = 1;
+        uint64_t words = 0;
+        bool ok = true;
+
+        void check(const uint8_t* buf, size_t bytes)
+        {
+            auto* w = reinterpret_cast<const uint32_t*>(buf);
+            for(size_t i = 0; i < bytes / 4; i++)
+            {
+                if (w[i] == 0)
+                {
+                    continue;
+                }
+                if (w[i] != expected)
+                {
+                    ok = false;
+                }
+                expected = w[i] + 1 == 0 ? 1 : w[i] + 1;
+                words++;
+            }
+        }
+    };
+
+    static void fillSequence(uint8_t* buf, size_t bytes, uint32_t& seq)
+    {
+        auto* w = reinterpret_cast<uint32_t*>(buf);
+        for(size_t i = 0; i < bytes / 4; i++)
+        {
+            w[i] = seq;
+            seq = seq + 1 == 0 ? 1 : seq + 1;
+        }
+    }
+
+    template<class Ring>
+    static void throughput(const char* name, size_t ringBytes, Ring& ring)
+    {
+        const size_t totalBytes = 256ull * 1024 * 1024;
+        const size_t putBytes = 1024 * frameSize;
+        const size_t getBytes = 256 * frameSize;
+
+        SequenceChecker checker;
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&]
+        {
+            std::vector<uint8_t> chunk(putBytes);
+            uint32_t seq = 1;
+            for(size_t sent = 0; sent < totalBytes; sent += putBytes)
+            {
+                fillSequence(chunk.data(), chunk.size(), seq);
+                ring.put(chunk.data(), chunk.size());
+            }
+        });
+
+        std::vector<uint8_t> out(getBytes);
+        while(checker.words * 4 < totalBytes)
+        {
+            const uint64_t before = checker.words;
+            ring.get(out.data(), out.size());
+            checker.check(out.data(), out.size());
+            if (checker.words == before)
+            {
+                // Starved; hand the core to the producer rather than spinning on silence
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::left << std::setw(22) << name
+                  << " ring " << std::setw(6) << ringBytes
+                  << " " << std::fixed << std::setprecision(1) << std::setw(8) << (static_cast<double>(totalBytes) / (1024.0 * 1024.0)) / elapsed << " MB/s"
+                  << "  data " << verdict(checker.ok, "CORRUPT") << std::endl;
+    }
+
+    template<class Ring>
+    static void getLatency(const char* name, Ring& ring)
+    {
+        // 48 frames every millisecond is what a 48kHz device with a 1ms period asks for
+        const size_t getBytes = 48 * frameSize;
+        const size_t putBytes = 1024 * frameSize;
+        const auto period = std::chrono::microseconds(1000);
+        const auto runFor = std::chrono::seconds(3);
+
+        std::atomic<bool> stop{false};
+        std::thread producer([&]
+        {
+            std::vector<uint8_t> chunk(putBytes);
+            uint32_t seq = 1;
+            while(!stop)
+            {
+                fillSequence(chunk.data(), chunk.size(), seq);
+                ring.put(chunk.data(), chunk.size());
+            }
+        });
+
+        SequenceChecker checker;
+        std::vector<uint8_t> out(getBytes);
+        std::vector<int64_t> samples;
+        samples.reserve(4096);
+        auto end = std::chrono::steady_clock::now() + runFor;
+        auto next = std::chrono::steady_clock::now();
+        while(std::chrono::steady_clock::now() < end)
+        {
+            auto before = std::chrono::steady_clock::now();
+            ring.get(out.data(), out.size());
+            auto after = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+            checker.check(out.data(), out.size());
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+        stop = true;
+        ring.shutdown();
+        producer.join();
+
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&](double p)
+        {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+        };
+        std::cout << std::left << std::setw(22) << name
+                  << " calls " << samples.size()
+                  << "  p50 " << pct(0.5) << "ns"
+                  << "  p99 " << pct(0.99) << "ns"
+                  << "  p99.9 " << pct(0.999) << "ns"
+                  << "  max " << samples.back() << "ns"
+                  << "  data " << verdict(checker.ok, "CORRUPT") << std::endl;
+    }
+
+    // The ring end of RtAudioStream for 48kHz stereo float. audio() copies what
+    // it's given in with put(); with zeroCopy set, reserve() hands out ring memory
+    // for the converter to write into, as the renderers do.
+    class RingSink: public IAudioSink
+    {
+        public:
+            RingSink(RingBuffer& ring, bool zeroCopy)
+                : _ring(ring)
+                , _zeroCopy(zeroCopy)
+            {
+
+            }
+
+            std::string getName() const override
+            {
+                return "RingSink";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { 48000 };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                _ring.put(buffer, sampleCount * frameSize);
+                copied += sampleCount * frameSize;
+            }
+
+            bool reserve(uint64_t sampleCount, RingSpans& spans) override
+            {
+                if (!_zeroCopy)
+                {
+                    return false;
+                }
+                spans = _ring.reserve(sampleCount * frameSize);
+                return true;
+            }
+
+            void commit(uint64_t sampleCount) override
+            {
+                _ring.commit(sampleCount * frameSize);
+            }
+
+            void onEos() override
+            {
+
+            }
+
+            // Bytes that came through audio() rather than straight into the ring
+            uint64_t copied = 0;
+
+        private:
+            RingBuffer& _ring;
+            bool _zeroCopy;
+    };
+
+    // Stereo float at sampleRate, handed on a block at a time as a decoder would
+    class BlockSource: public IAudioSource
+    {
+        public:
+            explicit BlockSource(uint32_t sampleRate)
+                : _sampleRate(sampleRate)
+            {
+
+            }
+
+            std::string getName() const override
+            {
+                return "BlockSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { _sampleRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void push(const std::vector<float>& block)
+            {
+                _sink->audio(reinterpret_cast<const uint8_t*>(block.data()), nullptr, block.size() / 2);
+            }
+
+        private:
+            uint32_t _sampleRate;
+    };
+
+    // The real SampleRateConverter feeding a RingBuffer that a device thread
+    // drains. Without reserve() the converter converts into its own buffer and the
+    // sink copies that into the ring; with it, swr writes straight into the ring.
+    // From 48kHz the converter only repacks, so the copy is most of the work.
+    static void zeroCopy(uint32_t sourceRate, bool reserveCommit)
+    {
+        const size_t blockFrames = 1152;
+        const double audioSeconds = 300.0;
+        const auto totalFrames = static_cast<size_t>(sourceRate * audioSeconds);
+        RingBuffer ring(4096 * frameSize, frameSize);
+        auto sink = std::make_shared<RingSink>(ring, reserveCommit);
+        auto converter = std::make_shared<SampleRateConverter>();
+        auto source = std::make_shared<BlockSource>(sourceRate);
+        converter->connectSink(sink);
+        source->connectSink(converter);
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&]
+        {
+            std::vector<float> block(blockFrames * 2);
+            for(size_t i = 0; i < block.size(); i++)
+            {
+                block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.01f);
+            }
+            for(size_t sent = 0; sent < totalFrames; sent += blockFrames)
+            {
+                source->push(block);
+            }
+            ring.eos();
+        });
+
+        std::vector<uint8_t> out(256 * frameSize);
+        bool ended = false;
+        while(!ended)
+        {
+            const uint64_t before = ring.readPosition();
+            ended = ring.get(out.data(), out.size()) == 1;
+            if (ring.readPosition() == before && !ended)
+            {
+                std::this_thread::yield();
+            }
+        }
+        // All of it bar what swr still holds back, well under a block
+        const uint64_t received = ring.readPosition();
+        const auto expectedFrames = static_cast<uint64_t>(totalFrames) * 48000 / sourceRate;
+        producer.join();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        source->disconnectSink();
+        converter->disconnectSink();
+
+        std::cout << std::left << std::setw(8) << (std::to_string(sourceRate / 1000) + "kHz")
+                  << std::setw(16) << (reserveCommit ? "reserve/commit" : "scratch + put")
+                  << " copied into ring " << std::fixed << std::setprecision(1) << std::setw(7)
+                  << static_cast<double>(sink->copied) / audioSeconds / 1024.0 << " KB/s of audio"
+                  << "  " << std::setprecision(0) << audioSeconds / elapsed << "x real time"
+                  << "  output " << verdict(received + blockFrames >= expectedFrames, "SHORT") << std::endl;
+    }
+
+    // Repeatedly streams a randomly sized track through the ring, marks eos and
+    // checks the consumer sees exactly that many words before get() reports the end,
+    // then resets for the next track. Every few rounds the ring is shut down mid
+    // track instead, which must release a producer blocked on a full ring.
+    static void eosStress(size_t ringBytes)
+    {
+        const uint32_t rounds = 2000;
+        RingBuffer ring(ringBytes, frameSize);
+        std::mt19937 rng(1234);
+        uint32_t failures = 0;
+        uint32_t shutdowns = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t round = 0; round < rounds; round++)
+        {
+            const size_t trackBytes = (1 + rng() % 4096) * frameSize;
+            const size_t putBytes = (1 + rng() % 512) * frameSize;
+            const size_t getBytes = (1 + rng() % 256) * frameSize;
+            const bool abort = round % 7 == 6;
+
+            std::thread producer([&]
+            {
+                std::vector<uint8_t> chunk(putBytes);
+                uint32_t seq = 1;
+                for(size_t sent = 0; sent < trackBytes; sent += putBytes)
+                {
+                    const size_t bytes = std::min(putBytes, trackBytes - sent);
+                    fillSequence(chunk.data(), bytes, seq);
+                    ring.put(chunk.data(), bytes);
+                }
+                ring.eos();
+            });
+
+            SequenceChecker checker;
+            std::vector<uint8_t> out(getBytes);
+            bool ended = false;
+            while(!ended)
+            {
+                if (abort && checker.words * 4 >= trackBytes / 2)
+                {
+                    ring.shutdown();
+                    shutdowns++;
+                    break;
+                }
+                const uint64_t before = checker.words;
+                ended = ring.get(out.data(), out.size()) == 1;
+                checker.check(out.data(), out.size());
+                if (checker.words == before && !ended)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            producer.join();
+
+            if (!checker.ok || (!abort && checker.words * 4 != trackBytes))
+            {
+                failures++;
+            }
+            ring.reset();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (failures != 0)
+        {
+            recordFailure();
+        }
+
+        std::cout << std::left << std::setw(22) << "RingBuffer"
+                  << " ring " << std::setw(6) << ringBytes
+                  << " rounds " << rounds
+                  << "  shutdowns " << shutdowns
+                  << "  " << std::fixed << std::setprecision(2) << elapsed << "s"
+                  << "  " << (failures == 0 ? "ok" : "FAILED (" + std::to_string(failures) + ")") << std::endl;
+    }
+
+    std::vector<Benchmark> ringBufferBenchmarks()
+    {
+        return {
+            {
+                "ringbuffer/throughput",
+                "Unpaced producer and consumer, lock-free vs mutex ring",
+                []
+                {
+                    for(size_t ringBytes: { 4096, 9600, 65536 })
+                    {
+                        {
+                            LockingRingBuffer ring(ringBytes);
+                            throughput("LockingRingBuffer", ringBytes, ring);
+                        }
+                        {
+                            RingBuffer ring(ringBytes, frameSize);
+                            throughput("RingBuffer", ringBytes, ring);
+                        }
+                    }
+                }
+            },
+            {
+                "ringbuffer/get-latency",
+                "Worst case get() time with a 1ms paced consumer and a saturating producer",
+                []
+                {
+                    // 25ms of 48kHz stereo float, the size RtAudioRenderer asks for
+                    const size_t ringBytes = 1200 * frameSize;
+                    {
+                        LockingRingBuffer ring(ringBytes);
+                        getLatency("LockingRingBuffer", ring);
+                    }
+                    {
+                        RingBuffer ring(ringBytes, frameSize);
+                        getLatency("RingBuffer", ring);
+                    }
+                }
+            },
+            {
+                "ringbuffer/zero-copy",
+                "SampleRateConverter into a ring, converting into scratch and put() vs reserve()/commit()",
+                []
+                {
+                    for(uint32_t sourceRate: { 48000u, 44100u })
+                    {
+                        zeroCopy(sourceRate, false);
+                        zeroCopy(sourceRate, true);
+                    }
+                }
+            },
+            {
+                "ringbuffer/eos-stress",
+                "Randomised put/get/eos/shutdown/reset cycles checking ordering and end of stream",
+                []
+                {
+                    for(size_t ringBytes: { 64, 4096, 9600 })
+                    {
+                        eosStress(ringBytes);
+                    }
+                }
+            }
+        };
+    }
+}
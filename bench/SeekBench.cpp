@@ -0,0 +1,471 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/MemoryReader.h>
+#include <implementation/MixerRenderer.h>
+#include <implementation/OutputMixer.h>
+#include <implementation/ReadAheadBuffer.h>
+#include <implementation/SampleRateConverter.h>
+#include <implementation/VolumeFilter.h>
+#include <exceptions/CommandException.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr double seekTrackSeconds = 300.0;
+    // Compared this far past where a seek lands, once a lossy decoder has had a
+    // few frames to settle after its flush
+    static constexpr uint64_t seekSettleSamples = 8192;
+    static constexpr uint64_t seekWindowSamples = 1024;
+    static constexpr int64_t seekSearchSamples = 4096;
+
+    static constexpr uint32_t spliceSourceRate = 44100;
+    static constexpr uint32_t spliceOutputRate = 48000;
+    static constexpr uint32_t spliceBlockFrames = 1024;
+    static constexpr uint32_t spliceSeeks = 20;
+    // Quieter than this is the silence or fade in between, from neither side
+    static constexpr float spliceSilence = 0.001f;
+
+    // Keeps the first channel of everything it's given
+    class CaptureSink: public IAudioSink
+    {
+        public:
+            std::string getName() const override
+            {
+                return "CaptureSink";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { 48000, 44100 };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const auto* in = reinterpret_cast<const float*>(buffer);
+                for(uint64_t i = 0; i < sampleCount; i++)
+                {
+                    samples.push_back(in[i * _sourceChannels]);
+                }
+            }
+
+            void onEos() override
+            {
+
+            }
+
+            std::vector<float> samples;
+    };
+
+    struct SeekChain
+    {
+        // Read from memory the file has no key in the seek index cache, so it
+        // neither finds an index there nor leaves one behind
+        SeekChain(const std::string& path, bool fromMemory)
+        {
+            if (fromMemory)
+            {
+                std::ifstream in(path, std::ios::binary);
+                asset.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                std::shared_ptr<const uint8_t> data(asset.data(), [](const uint8_t*){});
+                source->load(std::make_shared<MemoryReader>(data, asset.size()), path);
+            }
+            else
+            {
+                source->load(path);
+            }
+            converter->connectSink(capture);
+            source->connectSink(converter);
+        }
+
+        ~SeekChain()
+        {
+            source->disconnectSink();
+            converter->disconnectSink();
+        }
+
+        // Decodes until at least samples more have arrived. False at the end.
+        bool decode(uint64_t samples)
+        {
+            const uint64_t until = capture->samples.size() + samples;
+            FFFrame frame;
+            while(capture->samples.size() < until)
+            {
+                const int result = source->getPacket(&frame);
+                if (result <= 0 && result != AVERROR(EAGAIN))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<uint8_t> asset;
+        std::shared_ptr<FFSource> source = std::make_shared<FFSource>();
+        std::shared_ptr<SampleRateConverter> converter = std::make_shared<SampleRateConverter>();
+        std::shared_ptr<CaptureSink> capture = std::make_shared<CaptureSink>();
+    };
+
+    // How many samples the audio after a seek is out from where it should be,
+    // found by sliding it along the track decoded from the start
+    static int64_t alignmentError(const std::vector<float>& reference, uint64_t expected, const std::vector<float>& landed)
+    {
+        if (landed.size() < seekSettleSamples + seekWindowSamples)
+        {
+            return std::numeric_limits<int64_t>::max();
+        }
+        int64_t best = std::numeric_limits<int64_t>::max();
+        double bestError = std::numeric_limits<double>::max();
+        for(int64_t offset = -seekSearchSamples; offset <= seekSearchSamples; offset++)
+        {
+            const int64_t start = static_cast<int64_t>(expected + seekSettleSamples) + offset;
+            if (start < 0 || static_cast<uint64_t>(start) + seekWindowSamples > reference.size())
+            {
+                continue;
+            }
+            double error = 0.0;
+            for(uint64_t i = 0; i < seekWindowSamples; i++)
+            {
+                const double d = landed[seekSettleSamples + i] - reference[start + i];
+                error += d * d;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                best = offset;
+            }
+        }
+        return best;
+    }
+
+    // Seeks round a 5 minute track, checking each lands on the sample asked for
+    // and timing it. The first seeks read the file to index it; later ones, and
+    // those after loading the file again, use the index.
+    static void seekAccuracy(const MediaFixture& fixture)
+    {
+        std::cout << std::left << std::setw(22) << fixture.name;
+        const std::string path = synthesizeFixture(fixture, seekTrackSeconds);
+        if (path.empty())
+        {
+            std::cout << " skipped, no encoder" << std::endl;
+            return;
+        }
+
+        try
+        {
+            std::vector<float> reference;
+            uint32_t sampleRate;
+            {
+                SeekChain chain(path, true);
+                while(chain.decode(seekWindowSamples))
+                {
+                }
+                reference = std::move(chain.capture->samples);
+                sampleRate = chain.source->getSupportedSampleRates()[0];
+            }
+
+            const uint64_t targetsMs[] = { 250000, 30000, 170500, 285000, 5020, 120000 };
+            double coldMs = 0.0;
+            double warmMs = 0.0;
+            double reloadMs = 0.0;
+            int64_t worstError = 0;
+            int64_t worstLanding = 0;
+            uint32_t warmSeeks = 0;
+            for(int pass = 0; pass < 2; pass++)
+            {
+                // The second pass loads the file again, finding its index cached
+                SeekChain chain(path, false);
+                for(size_t i = 0; i < std::size(targetsMs); i++)
+                {
+                    const uint64_t target = targetsMs[i];
+                    const auto start = std::chrono::steady_clock::now();
+                    const int64_t landed = chain.source->seek(target);
+                    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    if (pass == 1)
+                    {
+                        reloadMs = std::max(reloadMs, ms);
+                    }
+                    else if (i == 0)
+                    {
+                        coldMs = ms;
+                    }
+                    else
+                    {
+                        warmMs += ms;
+                        warmSeeks++;
+                    }
+
+                    chain.capture->samples.clear();
+                    chain.decode(seekSettleSamples + seekWindowSamples);
+                    const int64_t error = alignmentError(reference, target * sampleRate / 1000, chain.capture->samples);
+                    worstError = std::max(worstError, std::abs(error));
+                    worstLanding = std::max(worstLanding, std::abs(landed - static_cast<int64_t>(target)));
+                }
+            }
+            std::filesystem::remove(path);
+
+            const bool exact = worstError == 0 && worstLanding == 0;
+            std::cout << std::fixed << std::setprecision(2)
+                      << " first seek " << std::setw(7) << coldMs << "ms"
+                      << "  then " << std::setw(6) << warmMs / std::max<uint32_t>(warmSeeks, 1) << "ms"
+                      << "  reloaded " << std::setw(6) << reloadMs << "ms"
+                      << "  off by " << std::setw(5) << worstError << " samples"
+                      << ", reported " << worstLanding << "ms out"
+                      << "  " << verdict(exact) << std::endl;
+        }
+        catch(const CommandException& e)
+        {
+            std::filesystem::remove(path);
+            std::cout << " load failed: " << e.message() << std::endl;
+        }
+    }
+
+    // Plays a constant level, so which side of a seek each output sample came from
+    // shows in its sign. Its rate differs from the mixer's to keep the converter busy.
+    class LevelSource: public IAudioSource
+    {
+        public:
+            std::string getName() const override
+            {
+                return "LevelSource";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return SampleFormatFlags::FLT;
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return { spliceSourceRate };
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return 2;
+            }
+
+            void pump()
+            {
+                _block.assign(spliceBlockFrames * 2, level);
+                _sink->audio(reinterpret_cast<const uint8_t*>(_block.data()), nullptr, spliceBlockFrames);
+            }
+
+            // Only touched by the thread calling pump()
+            float level = 0.5f;
+
+        private:
+            std::vector<float> _block;
+    };
+
+    struct SpliceRun
+    {
+        double latencyMs = 0.0;
+        double worstMs = 0.0;
+        double staleMs = 0.0;
+        uint32_t seeks = 0;
+    };
+
+    // Seeks a player's chain spliceSeeks times while a headless mixer renders it in
+    // real time, timing each from the request to the first sample of the new
+    // position coming out of the mixer. The producer stands in for the play thread,
+    // applying each seek between packets; flush drops what's queued downstream of it
+    // as the player does, otherwise it carries on playing out.
+    static SpliceRun spliceLatency(uint32_t readAheadMs, bool flush)
+    {
+        auto mixer = OutputMixer::headless(spliceOutputRate, 2);
+        auto renderer = std::make_shared<MixerRenderer>(mixer);
+        auto converter = std::make_shared<SampleRateConverter>();
+        auto volume = std::make_shared<VolumeFilter>();
+        auto source = std::make_shared<LevelSource>();
+        std::shared_ptr<ReadAheadBuffer> readAhead;
+        converter->connectSink(renderer);
+        volume->connectSink(converter);
+        if (readAheadMs > 0)
+        {
+            readAhead = std::make_shared<ReadAheadBuffer>(readAheadMs);
+            readAhead->connectSink(volume);
+            source->connectSink(readAhead);
+        }
+        else
+        {
+            source->connectSink(volume);
+        }
+
+        std::atomic<bool> done{ false };
+        std::atomic<bool> seekPending{ false };
+        // When the seek waiting to be heard was asked for, 0 once it has been
+        std::atomic<int64_t> requestedNs{ 0 };
+        std::thread producer([&]
+        {
+            while(!done)
+            {
+                if (seekPending.exchange(false))
+                {
+                    if (flush)
+                    {
+                        if (readAhead)
+                        {
+                            readAhead->flush();
+                        }
+                        else
+                        {
+                            volume->flush();
+                        }
+                    }
+                    source->level = -source->level;
+                }
+                source->pump();
+            }
+        });
+
+        SpliceRun run;
+        uint64_t staleFrames = 0;
+        std::atomic<bool> rendering{ true };
+        std::thread output([&]
+        {
+            const uint32_t frames = mixer->getBufferFrames();
+            std::vector<float> out(frames * 2);
+            const int64_t periodNs = static_cast<int64_t>(frames) * 1000000000 / spliceOutputRate;
+            auto next = std::chrono::steady_clock::now();
+            float heard = 1.0f;
+            while(rendering)
+            {
+                const int64_t renderNs = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+                mixer->render(out.data(), frames, false);
+                for(uint32_t i = 0; i < frames; i++)
+                {
+                    const float sample = out[i * 2];
+                    const int64_t requested = requestedNs.load();
+                    const int64_t sampleNs = renderNs + static_cast<int64_t>(i) * 1000000000 / spliceOutputRate;
+                    if (requested == 0 || sampleNs < requested || std::abs(sample) < spliceSilence)
+                    {
+                        continue;
+                    }
+                    if ((sample > 0.0f) == (heard > 0.0f))
+                    {
+                        staleFrames++;
+                        continue;
+                    }
+                    const double ms = static_cast<double>(sampleNs - requested) / 1e6;
+                    run.latencyMs += ms;
+                    run.worstMs = std::max(run.worstMs, ms);
+                    run.seeks++;
+                    heard = -heard;
+                    requestedNs = 0;
+                }
+                next += std::chrono::nanoseconds(periodNs);
+                std::this_thread::sleep_until(next);
+            }
+        });
+
+        for(uint32_t i = 0; i < spliceSeeks; i++)
+        {
+            // Long enough for the read-ahead queue to fill again between seeks
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::max<uint32_t>(readAheadMs, 100) + 150));
+            requestedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            seekPending = true;
+            const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while(requestedNs != 0 && std::chrono::steady_clock::now() < giveUp)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        // The producer and read-ahead thread may be waiting on the mixer for room,
+        // so the mixer keeps going until they've stopped
+        done = true;
+        producer.join();
+        if (readAhead)
+        {
+            readAhead->shutdown();
+        }
+        rendering = false;
+        output.join();
+        if (readAhead)
+        {
+            readAhead->disconnectSink();
+        }
+        source->disconnectSink();
+        volume->disconnectSink();
+        converter->disconnectSink();
+
+        run.latencyMs /= std::max<uint32_t>(run.seeks, 1);
+        run.staleMs = static_cast<double>(staleFrames) * 1000.0 / spliceOutputRate / std::max<uint32_t>(run.seeks, 1);
+        return run;
+    }
+
+    std::vector<Benchmark> seekBenchmarks()
+    {
+        return {
+            {
+                "seek/accuracy",
+                "Sample accuracy and cost of seeking a 5 minute track, with the seek index cold, warm and reloaded",
+                []
+                {
+                    const MediaFixture fixtures[] = {
+                        { "mp3-vbr-no-toc", "mp3", "libmp3lame", 44100, 2, 0, 4, false },
+                        { "mp3-vbr-xing", "mp3", "libmp3lame", 44100, 2, 0, 4, true },
+                        { "mp3-cbr-192k", "mp3", "libmp3lame", 44100, 2, 192000 },
+                        { "flac-44k-stereo", "flac", "flac", 44100, 2 },
+                        { "ogg-vorbis-48k-stereo", "ogg", "libvorbis", 48000, 2, 160000 },
+                        { "m4a-aac-44k-stereo", "m4a", "aac", 44100, 2, 128000 },
+                    };
+                    for(const auto& fixture: fixtures)
+                    {
+                        seekAccuracy(fixture);
+                    }
+                }
+            },
+            {
+                "seek/audible",
+                "Time from a seek to the new position being heard, with the audio queued downstream kept or flushed",
+                []
+                {
+                    const uint32_t readAheadLengths[] = { 0, 500 };
+                    for(const uint32_t readAheadMs: readAheadLengths)
+                    {
+                        for(const bool flush: { false, true })
+                        {
+                            const SpliceRun run = spliceLatency(readAheadMs, flush);
+                            std::cout << std::left << std::setw(16)
+                                      << (readAheadMs > 0 ? "read-ahead " + std::to_string(readAheadMs) + "ms" : "direct")
+                                      << std::setw(8) << (flush ? "flushed" : "kept")
+                                      << std::fixed << std::setprecision(2)
+                                      << " heard after " << std::setw(7) << run.latencyMs << "ms"
+                                      << "  worst " << std::setw(7) << run.worstMs << "ms"
+                                      << "  old audio after the seek " << std::setw(7) << run.staleMs << "ms"
+                                      << "  (" << run.seeks << "/" << spliceSeeks << " seeks heard)" << std::endl;
+                        }
+                    }
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,180 @@
+#include "Benchmarks.h"
+#include "FirstSampleProbe.h"
+#include "MediaFixtures.h"
+
+#include <implementation/FFFrame.h>
+#include <implementation/FFSource.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/RtAudioRenderer.h>
+#include <implementation/SampleRateConverter.h>
+#include <implementation/VolumeFilter.h>
+#include <exceptions/AudioException.h>
+#include <exceptions/CommandException.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t trackSwitches = 24;
+
+    struct SwitchTimes
+    {
+        double sameFormatMs = 0.0;
+        uint32_t sameFormat = 0;
+        double formatChangeMs = 0.0;
+        uint32_t formatChange = 0;
+        double maxMs = 0.0;
+    };
+
+    // Loads tracks A A B B A A ... into one chain, as Command::Load does, and times
+    // each from the start of the switch to its first sample reaching the renderer.
+    // persistent keeps the renderer, converter and volume stages between tracks;
+    // otherwise they're rebuilt for every track, as Stop used to.
+    template<typename Renderer>
+    static bool switchTracks(const std::function<std::shared_ptr<FirstSampleProbe<Renderer>>()>& makeRenderer,
+                             const std::string (&paths)[2], bool persistent, SwitchTimes& times)
+    {
+        std::shared_ptr<FirstSampleProbe<Renderer>> renderer;
+        std::shared_ptr<SampleRateConverter> resampler;
+        std::shared_ptr<VolumeFilter> volume;
+        std::shared_ptr<FFSource> source;
+        for(uint32_t i = 0; i < trackSwitches; i++)
+        {
+            const int64_t start = probeNowNs();
+            if (source)
+            {
+                source->disconnectSink();
+            }
+            if (!persistent || !renderer)
+            {
+                if (resampler)
+                {
+                    resampler->disconnectSink();
+                    volume->disconnectSink();
+                }
+                renderer = makeRenderer();
+                resampler = std::make_shared<SampleRateConverter>();
+                volume = std::make_shared<VolumeFilter>();
+            }
+            else
+            {
+                renderer->flush();
+            }
+            renderer->firstSampleNs = 0;
+
+            source = std::make_shared<FFSource>();
+            source->load(paths[(i / 2) % 2]);
+            resampler->connectSink(renderer);
+            volume->connectSink(resampler);
+            source->connectSink(volume);
+
+            FFFrame frame;
+            int result = 1;
+            while(renderer->firstSampleNs == 0 && (result > 0 || result == -11))
+            {
+                result = source->getPacket(&frame);
+            }
+            if (renderer->firstSampleNs == 0)
+            {
+                std::cout << " decode failed: " << FFSource::getError(result) << std::endl;
+                return false;
+            }
+
+            const double ms = static_cast<double>(renderer->firstSampleNs - start) / 1e6;
+            times.maxMs = std::max(times.maxMs, ms);
+            if (i % 2 == 0 && i > 0)
+            {
+                times.formatChangeMs += ms;
+                times.formatChange++;
+            }
+            else if (i > 0)
+            {
+                times.sameFormatMs += ms;
+                times.sameFormat++;
+            }
+        }
+        source->disconnectSink();
+        volume->disconnectSink();
+        resampler->disconnectSink();
+        return true;
+    }
+
+    template<typename Renderer>
+    static void compareSwitches(const char* name, const std::function<std::shared_ptr<FirstSampleProbe<Renderer>>()>& makeRenderer,
+                                const std::string (&paths)[2])
+    {
+        for(const bool persistent: { false, true })
+        {
+            std::cout << std::left << std::setw(8) << name << std::setw(11) << (persistent ? "persistent" : "rebuilt");
+            SwitchTimes times;
+            try
+            {
+                if (!switchTracks<Renderer>(makeRenderer, paths, persistent, times))
+                {
+                    continue;
+                }
+            }
+            catch(const CommandException& e)
+            {
+                std::cout << " load failed: " << e.message() << std::endl;
+                continue;
+            }
+            catch(const AudioException& e)
+            {
+                std::cout << " skipped: " << e.message() << std::endl;
+                return;
+            }
+            std::cout << std::fixed << std::setprecision(2)
+                      << " load to first sample, same format " << std::setw(7) << times.sameFormatMs / times.sameFormat << "ms"
+                      << "  format change " << std::setw(7) << times.formatChangeMs / times.formatChange << "ms"
+                      << "  max " << std::setw(7) << times.maxMs << "ms" << std::endl;
+        }
+    }
+
+    std::vector<Benchmark> trackSwitchBenchmarks()
+    {
+        return {
+            {
+                "pipeline/track-switch",
+                "Load to first sample over repeated track switches, chain rebuilt vs kept, for the null and device renderers",
+                []
+                {
+                    // Different rates and channel counts, so alternate pairs force the
+                    // output format to change
+                    const MediaFixture fixtures[2] = {
+                        { "flac-44k-stereo", "flac", "flac", 44100, 2 },
+                        { "wav-s16-48k-mono", "wav", "pcm_s16le", 48000, 1 },
+                    };
+                    const std::string paths[2] = {
+                        synthesizeFixture(fixtures[0], 5.0),
+                        synthesizeFixture(fixtures[1], 5.0),
+                    };
+                    if (paths[0].empty() || paths[1].empty())
+                    {
+                        std::cout << "skipped, missing an encoder in this FFmpeg build" << std::endl;
+                        return;
+                    }
+
+                    compareSwitches<NullRenderer>("null", []
+                    {
+                        return std::make_shared<FirstSampleProbe<NullRenderer>>(ClockMode::Unpaced);
+                    }, paths);
+                    compareSwitches<RtAudioRenderer>("device", []
+                    {
+                        return std::make_shared<FirstSampleProbe<RtAudioRenderer>>();
+                    }, paths);
+
+                    for(const auto& path: paths)
+                    {
+                        std::filesystem::remove(path);
+                    }
+                }
+            }
+        };
+    }
+}
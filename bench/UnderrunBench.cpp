@@ -0,0 +1,348 @@
+#include "Benchmarks.h"
+#include "MediaFixtures.h"
+
+#include <implementation/AudioPlayerImpl.h>
+#include <implementation/MixerRenderer.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/OutputMixer.h>
+#include <implementation/PipelineStats.h>
+#include <implementation/RtAudioRenderer.h>
+#include <implementation/StreamReader.h>
+#include <interfaces/IAudioPlayerEventReceiver.h>
+#include <structs/events/UnderrunEvent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CasperTech::bench
+{
+    static constexpr uint32_t underrunSampleRate = 48000;
+
+    // Feeds sink 10ms blocks of 48kHz stereo float for a few seconds. Every
+    // stallEvery blocks the producer goes quiet for stallMs; stalls longer than the
+    // sink's 50ms buffer must each count as exactly one underrun while playing, and
+    // none at all if playback was paused first.
+    static void starvedProducer(const char* name, const std::shared_ptr<IAudioSink>& sink, uint32_t stallEvery, uint32_t stallMs,
+                                bool pauseDuringStall, uint64_t expected)
+    {
+        const uint64_t blockSamples = underrunSampleRate / 100;
+        const uint32_t blocks = 300;
+
+        auto stats = std::make_shared<PipelineStats>();
+        sink->setStats(stats);
+        sink->setSource(nullptr, SampleFormatFlags::FLT, underrunSampleRate, 2);
+
+        std::vector<uint8_t> block(blockSamples * 2 * sizeof(float));
+        stats->setPlaying(true);
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 1; i <= blocks; i++)
+        {
+            sink->audio(block.data(), nullptr, blockSamples);
+            // Not after the last block, where only a ring's consumer would notice
+            if (stallEvery != 0 && i % stallEvery == 0 && i < blocks)
+            {
+                if (pauseDuringStall)
+                {
+                    stats->setPlaying(false);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+                if (pauseDuringStall)
+                {
+                    stats->setPlaying(true);
+                }
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // A ring keeps being read once the producer is done, and running dry then
+        // isn't one of the stalls
+        stats->setPlaying(false);
+
+        const auto snapshot = stats->snapshot();
+        std::cout << std::left << std::setw(22) << name
+                  << " underruns " << std::setw(4) << snapshot.underruns
+                  << " expected " << std::setw(4) << expected
+                  << " " << std::fixed << std::setprecision(2) << elapsed << "s"
+                  << "  " << verdict(snapshot.underruns == expected) << std::endl;
+    }
+
+    static void starvedCases(const std::string& sinkName, const std::function<std::shared_ptr<IAudioSink>()>& makeSink)
+    {
+        starvedProducer((sinkName + " well fed").c_str(), makeSink(), 0, 0, false, 0);
+        starvedProducer((sinkName + " short stalls").c_str(), makeSink(), 25, 20, false, 0);
+        starvedProducer((sinkName + " starved").c_str(), makeSink(), 50, 150, false, 5);
+        starvedProducer((sinkName + " paused").c_str(), makeSink(), 50, 150, true, 0);
+    }
+
+    // Stands in for the device, rendering a headless mixer one buffer period at a
+    // time in real time
+    class MixerOutput
+    {
+        public:
+            MixerOutput()
+                : mixer(OutputMixer::headless(underrunSampleRate, 2))
+                , _thread([this]{ run(); })
+            {
+
+            }
+
+            ~MixerOutput()
+            {
+                _running = false;
+                _thread.join();
+            }
+
+            std::shared_ptr<OutputMixer> mixer;
+
+        private:
+            void run()
+            {
+                const uint32_t frames = mixer->getBufferFrames();
+                std::vector<float> out(frames * 2);
+                const auto period = std::chrono::nanoseconds(static_cast<int64_t>(frames) * 1000000000 / underrunSampleRate);
+                auto next = std::chrono::steady_clock::now();
+                while(_running)
+                {
+                    mixer->render(out.data(), frames, false);
+                    next += period;
+                    std::this_thread::sleep_until(next);
+                }
+            }
+
+            std::atomic<bool> _running{ true };
+            std::thread _thread;
+    };
+
+    // Collects the UnderrunEvents a player raises, and when each arrived
+    class UnderrunReceiver: public IAudioPlayerEventReceiver
+    {
+        public:
+            struct Report
+            {
+                uint64_t count;
+                uint64_t total;
+                std::chrono::steady_clock::time_point at;
+            };
+
+            void onPlayerEvent(const std::shared_ptr<PlayerEvent>& event) override
+            {
+                if (event->eventType != EventType::Underrun)
+                {
+                    return;
+                }
+                auto underrun = std::static_pointer_cast<UnderrunEvent>(event);
+                std::unique_lock<std::mutex> lk(_mutex);
+                _reports.push_back({ underrun->count, underrun->total, std::chrono::steady_clock::now() });
+            }
+
+            std::vector<Report> reports()
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                return _reports;
+            }
+
+        private:
+            std::mutex _mutex;
+            std::vector<Report> _reports;
+    };
+
+    static bool runCommand(const std::function<void(const ResultCallback& callback)>& command)
+    {
+        std::promise<CommandResult> done;
+        auto result = done.get_future();
+        command([&done](CommandResult commandResult, const std::string& errorMessage)
+        {
+            done.set_value(commandResult);
+        });
+        return result.get() == CommandResult::Success;
+    }
+
+    // Sends asset into reader as fast as it's taken, going quiet for stallMs at
+    // each of stallAt, until it's all sent or stopped is set
+    static void feedWithStalls(StreamReader& reader, const std::vector<uint8_t>& asset, const std::vector<size_t>& stallAt,
+                               uint32_t stallMs, std::mutex& drainMutex, std::condition_variable& drainWait, bool& drained,
+                               const std::atomic<bool>& stopped)
+    {
+        size_t sent = 0;
+        for(size_t i = 0; i <= stallAt.size() && !stopped; i++)
+        {
+            const size_t until = i < stallAt.size() ? std::min(stallAt[i], asset.size()) : asset.size();
+            while(sent < until && !stopped)
+            {
+                const size_t n = reader.write(asset.data() + sent, until - sent);
+                sent += n;
+                if (sent < until)
+                {
+                    std::unique_lock<std::mutex> lk(drainMutex);
+                    drainWait.wait_for(lk, std::chrono::milliseconds(100), [&]{ return drained; });
+                    drained = false;
+                }
+            }
+            if (i < stallAt.size())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+            }
+        }
+        reader.end();
+    }
+
+    // A real player, without read-ahead, on a stream that stalls for longer than
+    // everything buffered behind it every 100ms of audio, so it underruns faster
+    // than once per report interval. The underruns must all be counted, and reported
+    // at most once per interval, each event carrying those since the one before.
+    static void stalledPlayer()
+    {
+        // AudioPlayerImpl::underrunReportInterval
+        const auto reportInterval = std::chrono::milliseconds(1000);
+        const uint32_t stalls = 8;
+        const uint32_t stallMs = 400;
+        // 96kHz stereo float, so FFSource's 32KB of input buffering is only 42ms
+        const MediaFixture fixture{ "wav-f32-96k-stereo", "wav", "pcm_f32le", 96000, 2 };
+        const size_t bytesPerSecond = 96000 * 2 * sizeof(float);
+
+        std::cout << std::left << std::setw(22) << "player stalled stream";
+        const std::string path = synthesizeFixture(fixture, 3.0);
+        if (path.empty())
+        {
+            std::cout << " skipped, missing an encoder in this FFmpeg build" << std::endl;
+            return;
+        }
+        std::vector<uint8_t> asset;
+        {
+            std::ifstream in(path, std::ios::binary);
+            asset.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::filesystem::remove(path);
+
+        // A second to open and start playing, then a stall every 100ms
+        std::vector<size_t> stallAt;
+        for(uint32_t i = 0; i < stalls; i++)
+        {
+            stallAt.push_back(bytesPerSecond + i * bytesPerSecond / 10);
+        }
+
+        std::mutex drainMutex;
+        std::condition_variable drainWait;
+        bool drained = false;
+        std::atomic<bool> stopped{ false };
+        auto reader = std::make_shared<StreamReader>(4 * 1024, [&]
+        {
+            {
+                std::unique_lock<std::mutex> lk(drainMutex);
+                drained = true;
+            }
+            drainWait.notify_one();
+        });
+        std::thread feeder([&]
+        {
+            feedWithStalls(*reader, asset, stallAt, stallMs, drainMutex, drainWait, drained, stopped);
+        });
+
+        UnderrunReceiver receiver;
+        PipelineStatsSnapshot snapshot;
+        bool played = false;
+        {
+            PlayerOptions options;
+            options.renderer.type = RendererType::Null;
+            options.renderer.clockMode = ClockMode::RealTime;
+            options.readAheadMs = 0;
+            AudioPlayerImpl player(&receiver, options);
+            played = runCommand([&](const ResultCallback& callback){ player.load(reader, "stalled", callback); })
+                     && runCommand([&](const ResultCallback& callback){ player.play(callback); });
+            // Nothing reads the stream if it didn't load
+            stopped = !played;
+            feeder.join();
+            if (played)
+            {
+                // The feeder only finishes as the end of the stream is read, so this
+                // covers what's still buffered and a whole interval for the last
+                // report to be let through
+                std::this_thread::sleep_for(std::chrono::milliseconds(500) + reportInterval);
+                snapshot = player.getStats();
+            }
+        }
+        if (!played)
+        {
+            std::cout << " couldn't load the stream  " << verdict(false) << std::endl;
+            return;
+        }
+
+        const auto reports = receiver.reports();
+        uint64_t reported = 0;
+        bool totalsAddUp = true;
+        auto closest = std::chrono::steady_clock::duration::max();
+        for(size_t i = 0; i < reports.size(); i++)
+        {
+            reported += reports[i].count;
+            totalsAddUp = totalsAddUp && reports[i].total == reported;
+            if (i > 0)
+            {
+                closest = std::min(closest, reports[i].at - reports[i - 1].at);
+            }
+        }
+        // The events' own timestamps are taken a little after the player's
+        const bool spaced = reports.size() < 2 || closest >= reportInterval - std::chrono::milliseconds(10);
+        const bool pass = snapshot.underruns == stalls && reported == stalls && totalsAddUp && spaced
+                          && reports.size() < stalls;
+        std::cout << " underruns " << std::setw(4) << snapshot.underruns
+                  << " expected " << std::setw(4) << stalls
+                  << " events " << reports.size()
+                  << " reported " << reported
+                  << " closest " << (reports.size() < 2 ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(closest).count()) << "ms"
+                  << "  " << verdict(pass) << std::endl;
+    }
+
+    std::vector<Benchmark> underrunBenchmarks()
+    {
+        return {
+            {
+                "underrun/starved-producer",
+                "Underrun counting with a headless sink, a mixer voice and a device stream, each fed by a producer that stalls",
+                []
+                {
+                    starvedCases("null", []
+                    {
+                        return std::make_shared<NullRenderer>(ClockMode::RealTime);
+                    });
+
+                    // Counted in the callback, as the voice's ring runs dry
+                    MixerOutput output;
+                    starvedCases("mixer", [&output]
+                    {
+                        return std::make_shared<MixerRenderer>(output.mixer);
+                    });
+
+                    // RtAudioStream::fillBuffer, which needs a real device
+                    if (RtAudioRenderer().getDevices().empty())
+                    {
+                        std::cout << "device skipped, no output device" << std::endl;
+                        return;
+                    }
+                    starvedCases("device", []
+                    {
+                        return std::make_shared<RtAudioRenderer>();
+                    });
+                }
+            },
+            {
+                "underrun/player-events",
+                "UnderrunEvents from a real player whose stream stalls, rate limited to one per report interval",
+                []
+                {
+                    stalledPlayer();
+                }
+            }
+        };
+    }
+}
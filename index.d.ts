@@ -1,12 +1,105 @@
+/// <reference types="node" />
 import { PlaybackEvent } from "./PlaybackEvent";
+import { Writable } from "stream";
+export interface AudioPlayerOptions {
+    renderer?: 'rtaudio' | 'mixer' | 'null' | 'file';
+    file?: string;
+    clock?: 'realtime' | 'fast';
+    readAheadMs?: number;
+    clipCacheMaxMs?: number;
+    openTimeoutMs?: number;
+    probeTimeoutMs?: number;
+    probeSize?: number;
+    analyzeDurationMs?: number;
+    skipStreamInfo?: boolean;
+    formatFromExtension?: boolean;
+}
+export interface StageStats {
+    count: number;
+    minNs: number;
+    maxNs: number;
+    meanNs: number;
+    p50Ns: number;
+    p90Ns: number;
+    p99Ns: number;
+    p999Ns: number;
+}
+export interface PlayerStats {
+    stages: {
+        decode: StageStats;
+        readAhead: StageStats;
+        volume: StageStats;
+        resample: StageStats;
+        rate: StageStats;
+        render: StageStats;
+        callback: StageStats;
+    };
+    frames: number;
+    samples: number;
+    callbacks: number;
+    underruns: number;
+    ringFillBytes: number;
+    ringCapacityBytes: number;
+    lastUnderrunMs: number;
+    readAheadFrames: number;
+    readAheadMs: number;
+    readAheadCapacityMs: number;
+}
+export interface ClipCacheStats {
+    hits: number;
+    misses: number;
+    evictions: number;
+    entries: number;
+    bytes: number;
+    budgetBytes: number;
+}
+export interface MediaInfo {
+    path: string;
+    error?: string;
+    durationMs?: number;
+    codec?: string;
+    sampleRate?: number;
+    channels?: number;
+    bitRate?: number;
+    tags?: {
+        [name: string]: string;
+    };
+}
+export interface ProbeOptions {
+    threads?: number;
+    cacheFile?: string;
+}
+export interface AudioInputStreamOptions {
+    bufferBytes?: number;
+}
+export declare class AudioInputStream extends Writable {
+    private native;
+    private pending?;
+    private pendingCallback?;
+    constructor(options?: AudioInputStreamOptions);
+    get bufferedBytes(): number;
+    _write(chunk: Buffer, encoding: BufferEncoding, callback: (error?: Error | null) => void): void;
+    _final(callback: (error?: Error | null) => void): void;
+    _destroy(error: Error | null, callback: (error?: Error | null) => void): void;
+    private pump;
+}
 export declare class AudioPlayer {
     private player;
-    constructor();
+    constructor(options?: AudioPlayerOptions);
     load(fileName: string): Promise<void>;
+    loadBuffer(buffer: Buffer, name?: string): Promise<void>;
+    loadStream(stream: AudioInputStream, name?: string): Promise<void>;
+    enqueue(fileName: string): Promise<void>;
     play(): Promise<void>;
     pause(): Promise<void>;
     seek(ms: number): Promise<void>;
     stop(): Promise<void>;
-    setVolume(volume: number): Promise<void>;
+    setVolume(volume: number, rampMs?: number, curve?: 'linear' | 'exponential'): Promise<void>;
+    setPlaybackRate(rate: number, mode?: 'varispeed' | 'timestretch'): Promise<void>;
     setEventCallback(cb: (event: PlaybackEvent, msg: string) => void): void;
+    getStats(): PlayerStats;
+    getPosition(): number;
+    static getClipCacheStats(): ClipCacheStats;
+    static setClipCacheBudget(bytes: number): void;
+    static probe(paths: string[], options?: ProbeOptions): Promise<MediaInfo[]>;
 }
@@ -1,14 +1,63 @@
 "use strict";
 Object.defineProperty(exports, "__esModule", { value: true });
-exports.AudioPlayer = void 0;
+exports.AudioPlayer = exports.AudioInputStream = void 0;
+const stream_1 = require("stream");
 const audioPlayer = require('node-cmake')('node_audio');
+class AudioInputStream extends stream_1.Writable {
+    constructor(options) {
+        super();
+        this.native = new audioPlayer.InputStream(options === null || options === void 0 ? void 0 : options.bufferBytes, () => this.pump());
+    }
+    get bufferedBytes() {
+        return this.native.getBuffered();
+    }
+    _write(chunk, encoding, callback) {
+        this.pending = chunk;
+        this.pendingCallback = callback;
+        this.pump();
+    }
+    _final(callback) {
+        this.native.end();
+        callback();
+    }
+    _destroy(error, callback) {
+        if (error || !this.writableFinished) {
+            this.native.abort();
+        }
+        callback(error);
+    }
+    pump() {
+        if (this.pending === undefined) {
+            return;
+        }
+        const written = this.native.write(this.pending);
+        if (written < this.pending.length) {
+            this.pending = this.pending.subarray(written);
+            return;
+        }
+        const callback = this.pendingCallback;
+        this.pending = undefined;
+        this.pendingCallback = undefined;
+        callback();
+    }
+}
+exports.AudioInputStream = AudioInputStream;
 class AudioPlayer {
-    constructor() {
-        this.player = new audioPlayer.AudioPlayer();
+    constructor(options) {
+        this.player = new audioPlayer.AudioPlayer(options);
     }
     load(fileName) {
         return this.player.load(fileName);
     }
+    loadBuffer(buffer, name) {
+        return this.player.loadBuffer(buffer, name);
+    }
+    loadStream(stream, name) {
+        return this.player.loadStream(stream['native'], name);
+    }
+    enqueue(fileName) {
+        return this.player.enqueue(fileName);
+    }
     play() {
         return this.player.play();
     }
@@ -21,12 +70,30 @@ class AudioPlayer {
     stop() {
         return this.player.stop();
     }
-    setVolume(volume) {
-        return this.player.setVolume(volume);
+    setVolume(volume, rampMs, curve) {
+        return this.player.setVolume(volume, rampMs, curve);
+    }
+    setPlaybackRate(rate, mode) {
+        return this.player.setPlaybackRate(rate, mode);
     }
     setEventCallback(cb) {
         this.player.setEventCallback(cb);
     }
+    getStats() {
+        return this.player.getStats();
+    }
+    getPosition() {
+        return this.player.getPosition();
+    }
+    static getClipCacheStats() {
+        return audioPlayer.AudioPlayer.getClipCacheStats();
+    }
+    static setClipCacheBudget(bytes) {
+        audioPlayer.AudioPlayer.setClipCacheBudget(bytes);
+    }
+    static probe(paths, options) {
+        return audioPlayer.AudioPlayer.probe(paths, options);
+    }
 }
 exports.AudioPlayer = AudioPlayer;
 //# sourceMappingURL=index.js.map
\ No newline at end of file
@@ -4,4 +4,11 @@ export enum PlaybackEvent
     Playing = 1,
     Finished = 2,
     Error = 3,
+    // Output ran dry during playback. Reported at most once a second
+    Underrun = 4,
+    // An enqueued track took over from the one before it. The message is its file name
+    TrackChanged = 5,
+    // A seek has been carried out. The message is the position playback carries on
+    // from in ms, which is short of the one asked for past the end of the track
+    Seeked = 6,
 }
\ No newline at end of file
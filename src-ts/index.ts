@@ -1,21 +1,226 @@
 import {PlaybackEvent} from "./PlaybackEvent";
+import {Writable} from "stream";
 
 const audioPlayer = require('node-cmake')('node_audio')
 
+export interface AudioPlayerOptions
+{
+    // 'mixer' shares one output stream between every player using it, mixing them
+    // natively. 'null' and 'file' run without an audio device
+    renderer?: 'rtaudio' | 'mixer' | 'null' | 'file';
+    // Output path for the file renderer. A .wav extension writes WAV, anything else raw PCM
+    file?: string;
+    // Headless renderers only: consume at the sample rate, or as fast as possible
+    clock?: 'realtime' | 'fast';
+    // How far ahead of the output to decode, on a separate thread. 0 disables. Default 500
+    readAheadMs?: number;
+    // Files up to this long are decoded once into a cache shared by every player,
+    // and later loads play the decoded audio straight away. 0 disables. Default 0
+    clipCacheMaxMs?: number;
+    // How long a load may spend opening the file, then probing its streams, before
+    // it's rejected. Either way stop() or another load cancels it. 0 (the
+    // default) waits as long as it takes
+    openTimeoutMs?: number;
+    probeTimeoutMs?: number;
+    // Caps on how many bytes, and how much audio, probing a file's streams reads
+    // before playback can start. 0 (the default) uses FFmpeg's 5MB and 5s
+    probeSize?: number;
+    analyzeDurationMs?: number;
+    // Skips probing for containers whose header describes the audio (WAV, FLAC,
+    // Ogg, MP4/M4A), where it only confirms what's already known. load() also
+    // leaves the decoder until playback starts, so a codec that can't be opened
+    // raises PlaybackEvent.Error then instead of rejecting the load
+    skipStreamInfo?: boolean;
+    // Opens files as the container their extension names instead of probing,
+    // falling back to probing if that fails
+    formatFromExtension?: boolean;
+}
+
+export interface StageStats
+{
+    count: number;
+    minNs: number;
+    maxNs: number;
+    meanNs: number;
+    p50Ns: number;
+    p90Ns: number;
+    p99Ns: number;
+    p999Ns: number;
+}
+
+export interface PlayerStats
+{
+    // Time spent in each stage itself, excluding the downstream stages it feeds
+    stages: {
+        decode: StageStats;
+        readAhead: StageStats;
+        volume: StageStats;
+        resample: StageStats;
+        rate: StageStats;
+        render: StageStats;
+        callback: StageStats;
+    };
+    frames: number;
+    samples: number;
+    callbacks: number;
+    underruns: number;
+    ringFillBytes: number;
+    ringCapacityBytes: number;
+    // Wall clock time of the most recent underrun (ms since the epoch), 0 if none
+    lastUnderrunMs: number;
+    // Decoded audio waiting in the read-ahead queue
+    readAheadFrames: number;
+    readAheadMs: number;
+    readAheadCapacityMs: number;
+}
+
+export interface ClipCacheStats
+{
+    hits: number;
+    misses: number;
+    evictions: number;
+    entries: number;
+    // Decoded audio held, against the budget set with AudioPlayer.setClipCacheBudget()
+    bytes: number;
+    budgetBytes: number;
+}
+
+export interface MediaInfo
+{
+    path: string;
+    // Set when the file couldn't be probed, in which case nothing else is
+    error?: string;
+    durationMs?: number;
+    // FFmpeg's name for the audio codec, e.g. 'mp3', 'flac', 'aac'
+    codec?: string;
+    sampleRate?: number;
+    channels?: number;
+    // Bits per second, 0 if the file doesn't say
+    bitRate?: number;
+    // As the file names them, e.g. title, artist, album
+    tags?: { [name: string]: string };
+}
+
+export interface ProbeOptions
+{
+    // Files probed at once. Default one per core
+    threads?: number;
+    // Results are kept in this file between runs, and a file that hasn't changed
+    // size or modification time since is answered from it without being opened
+    cacheFile?: string;
+}
+
+export interface AudioInputStreamOptions
+{
+    // Native buffer between the stream and the decoder. Writes wait while it's
+    // full, which holds back whatever is piped in. Default 256KB
+    bufferBytes?: number;
+}
+
+// A file played as it arrives, for AudioPlayer.loadStream(). Write or pipe it
+// in; playback starts once there's enough to open it. The input can't be seeked
+export class AudioInputStream extends Writable
+{
+    private native;
+    private pending?: Buffer;
+    private pendingCallback?: (error?: Error | null) => void;
+
+    constructor(options?: AudioInputStreamOptions)
+    {
+        super();
+        this.native = new audioPlayer.InputStream(options?.bufferBytes, () => this.pump());
+    }
+
+    public get bufferedBytes(): number
+    {
+        return this.native.getBuffered();
+    }
+
+    _write(chunk: Buffer, encoding: BufferEncoding, callback: (error?: Error | null) => void): void
+    {
+        this.pending = chunk;
+        this.pendingCallback = callback;
+        this.pump();
+    }
+
+    _final(callback: (error?: Error | null) => void): void
+    {
+        this.native.end();
+        callback();
+    }
+
+    _destroy(error: Error | null, callback: (error?: Error | null) => void): void
+    {
+        // Destroyed after finishing too, when the player may still be reading
+        if (error || !this.writableFinished)
+        {
+            this.native.abort();
+        }
+        callback(error);
+    }
+
+    // Offers the rest of the current chunk. Called again on drain until it's all taken
+    private pump(): void
+    {
+        if (this.pending === undefined)
+        {
+            return;
+        }
+        const written: number = this.native.write(this.pending);
+        if (written < this.pending.length)
+        {
+            this.pending = this.pending.subarray(written);
+            return;
+        }
+        const callback = this.pendingCallback!;
+        this.pending = undefined;
+        this.pendingCallback = undefined;
+        callback();
+    }
+}
+
 export class AudioPlayer
 {
     private player;
 
-    constructor()
+    constructor(options?: AudioPlayerOptions)
     {
-        this.player = new audioPlayer.AudioPlayer();
+        this.player = new audioPlayer.AudioPlayer(options);
     }
 
+    // A load still waiting behind other commands, or still opening its file, is
+    // dropped for a newer one or a stop(), and resolves without loading anything.
+    // play(), pause(), seek() and enqueue() issued meanwhile wait for the file
     public load(fileName: string): Promise<void>
     {
         return this.player.load(fileName);
     }
 
+    // Plays a whole file held in memory, read in place rather than written to disk
+    // first. The Buffer is held until the player is done with it and must not be
+    // modified in the meantime. name is reported in place of a file name
+    public loadBuffer(buffer: Buffer, name?: string): Promise<void>
+    {
+        return this.player.loadBuffer(buffer, name);
+    }
+
+    // Plays a file written into stream as it arrives. Resolves once enough has
+    // been written to open it, so keep writing while waiting. name is reported in
+    // place of a file name
+    public loadStream(stream: AudioInputStream, name?: string): Promise<void>
+    {
+        return this.player.loadStream(stream['native'], name);
+    }
+
+    // Opens the file straight away and plays it when the current track (or the last
+    // one enqueued) ends, with no gap when the two share a format. Raises
+    // PlaybackEvent.TrackChanged as it takes over. Cleared by load() and stop(),
+    // which also abandon an enqueue still opening
+    public enqueue(fileName: string): Promise<void>
+    {
+        return this.player.enqueue(fileName);
+    }
+
     public play(): Promise<void>
     {
         return this.player.play();
@@ -26,6 +231,10 @@ export class AudioPlayer
         return this.player.pause();
     }
 
+    // Lands on the exact sample, once playing. Raises PlaybackEvent.Seeked with
+    // where it landed, or PlaybackEvent.Error if the input can't be seeked. Seeks
+    // overtaken by a newer one before they're carried out (dragging a scrubber)
+    // resolve straight away and are skipped
     public seek(ms: number): Promise<void>
     {
         return this.player.seek(ms);
@@ -36,13 +245,57 @@ export class AudioPlayer
         return this.player.stop();
     }
 
-    public setVolume(volume: number): Promise<void>
+    // Ramps to the new volume over rampMs instead of stepping, which avoids clicks
+    // and zipper noise. 'exponential' ramps evenly in dB. Like seek(), a change
+    // overtaken by a newer one resolves straight away and is skipped
+    public setVolume(volume: number, rampMs?: number, curve?: 'linear' | 'exponential'): Promise<void>
+    {
+        return this.player.setVolume(volume, rampMs, curve);
+    }
+
+    // Plays at 0.5x to 2x without interrupting playback. 'timestretch' (the
+    // default) keeps the pitch, for speech; 'varispeed' lets it move with the rate
+    public setPlaybackRate(rate: number, mode?: 'varispeed' | 'timestretch'): Promise<void>
     {
-        return this.player.setVolume(volume);
+        return this.player.setPlaybackRate(rate, mode);
     }
 
     public setEventCallback(cb: (event: PlaybackEvent, msg: string) => void)
     {
         this.player.setEventCallback(cb);
     }
+
+    public getStats(): PlayerStats
+    {
+        return this.player.getStats();
+    }
+
+    // Where in the track the output is playing, in ms, allowing for the audio
+    // still queued and the device's latency. Answered without waiting on the
+    // player, so it's cheap enough to poll on every animation frame
+    public getPosition(): number
+    {
+        return this.player.getPosition();
+    }
+
+    public static getClipCacheStats(): ClipCacheStats
+    {
+        return audioPlayer.AudioPlayer.getClipCacheStats();
+    }
+
+    // Least recently used clips are evicted to fit. Default 64MB
+    public static setClipCacheBudget(bytes: number): void
+    {
+        audioPlayer.AudioPlayer.setClipCacheBudget(bytes);
+    }
+
+    // Duration, format and tags for each path, in order, without creating a
+    // player. Meant for indexing a library: only the container is read, on
+    // threads of the addon's own, so neither the JS thread nor the threadpool
+    // waits on it. A file that can't be read has its error set rather than
+    // rejecting the batch
+    public static probe(paths: string[], options?: ProbeOptions): Promise<MediaInfo[]>
+    {
+        return audioPlayer.AudioPlayer.probe(paths, options);
+    }
 }
\ No newline at end of file
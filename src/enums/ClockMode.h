@@ -0,0 +1,9 @@
+#pragma once
+
+enum class ClockMode
+{
+    // Consume audio at the negotiated sample rate, like a real device would
+    RealTime,
+    // Consume audio as fast as the pipeline can produce it
+    Unpaced,
+};
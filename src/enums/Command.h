@@ -8,5 +8,9 @@ enum class Command
     Pause,
     Seek,
     Stop,
-    SetVolume
+    SetVolume,
+    Enqueue,
+    SetPlaybackRate,
+    // Internal: a load's file has been opened, or failed to
+    TrackOpened
 };
\ No newline at end of file
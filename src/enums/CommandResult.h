@@ -7,4 +7,7 @@ enum class CommandResult
         GenericFailure,
         LoadError,
         PlayError,
+        // A newer command of the same kind arrived before this one was carried out,
+        // and was carried out in its place
+        Superseded,
 };
\ No newline at end of file
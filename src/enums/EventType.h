@@ -6,4 +6,7 @@ enum class EventType
     PlaybackFinished = 1,
     PlaybackError = 2,
     Playing,
+    Underrun,
+    TrackChanged,
+    Seeked,
 };
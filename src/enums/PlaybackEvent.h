@@ -6,4 +6,7 @@ enum class PlaybackEvent
         Playing = 1,
         Finished = 2,
         Error = 3,
+        Underrun = 4,
+        TrackChanged = 5,
+        Seeked = 6,
 };
\ No newline at end of file
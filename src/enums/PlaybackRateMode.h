@@ -0,0 +1,9 @@
+#pragma once
+
+enum class PlaybackRateMode
+{
+    // Plays the audio faster or slower, shifting its pitch with it, like a tape
+    Varispeed,
+    // Changes the tempo but keeps the pitch, for speech
+    TimeStretch,
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+enum class RendererType
+{
+    RtAudio,
+    Null,
+    File,
+    Mixer,
+};
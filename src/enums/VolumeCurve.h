@@ -0,0 +1,9 @@
+#pragma once
+
+enum class VolumeCurve
+{
+    // Gain changes by the same amount every sample
+    Linear,
+    // Gain changes by the same ratio every sample, i.e. linearly in dB
+    Exponential,
+};
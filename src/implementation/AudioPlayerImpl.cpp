@@ -1,34 +1,53 @@
 #include "AudioPlayerImpl.h"
 #include "VolumeFilter.h"
 
+#include <implementation/ClipCache.h>
+#include <implementation/ClipSource.h>
 #include <implementation/FFSource.h>
 #include <implementation/FFFrame.h>
 #include <implementation/RtAudioRenderer.h>
+#include <implementation/NullRenderer.h>
+#include <implementation/FileRenderer.h>
+#include <implementation/MixerRenderer.h>
+#include <implementation/OutputMixer.h>
+#include <implementation/PipelineStats.h>
+#include <implementation/ReadAheadBuffer.h>
 
+#include <structs/commands/EnqueueCommand.h>
 #include <structs/commands/LoadCommand.h>
 #include <structs/commands/PlayCommand.h>
 #include <structs/commands/StopCommand.h>
 #include <structs/commands/SeekCommand.h>
 #include <structs/commands/PauseCommand.h>
 #include <structs/commands/SetVolumeCommand.h>
+#include <structs/commands/SetPlaybackRateCommand.h>
+#include <structs/commands/TrackOpenedCommand.h>
 #include <structs/events/PlaybackFinishedEvent.h>
 
 #include <exceptions/CommandException.h>
 
+#include <algorithm>
 #include <cassert>
 #include <thread>
+#include <utility>
 #include <iostream>
 #include <structs/events/PlaybackErrorEvent.h>
 #include <structs/events/PlayingEvent.h>
+#include <structs/events/SeekedEvent.h>
+#include <structs/events/TrackChangedEvent.h>
+#include <structs/events/UnderrunEvent.h>
 #include <exceptions/AudioException.h>
 
 namespace CasperTech
 {
-    AudioPlayerImpl::AudioPlayerImpl(IAudioPlayerEventReceiver* eventReceiver)
+    AudioPlayerImpl::AudioPlayerImpl(IAudioPlayerEventReceiver* eventReceiver, PlayerOptions options)
         : _eventReceiver(eventReceiver)
-        , _audioRenderer(std::make_shared<RtAudioRenderer>())
+        , _options(std::move(options))
+        , _stats(std::make_shared<PipelineStats>())
+        , _audioRenderer(createRenderer())
         , _volumeFilter(std::make_shared<VolumeFilter>())
         , _sampleRateConverter(std::make_shared<SampleRateConverter>())
+        , _rateFilter(std::make_shared<RateFilter>())
     {
         std::unique_lock<std::mutex> commandLock(_eventThreadMutex);
         _controlThread = std::thread(&AudioPlayerImpl::controlThreadFunc, this);
@@ -56,17 +75,27 @@ namespace CasperTech
                 unpause = true;
             }
             _readerState = PlayerState::Unloaded;
+            if (_loadedFile)
+            {
+                // A stream may have the play thread waiting on input
+                _loadedFile->interrupt();
+            }
         }
         if (unpause)
         {
             _pauseWait.notify_all();
         }
+        if (_readAhead)
+        {
+            _readAhead->shutdown();
+        }
         if (_playThread.joinable())
         {
             _playThread.join();
             _playThreadRunning = false;
         }
 
+        releaseReadAhead();
         if (_audioRenderer)
         {
             _audioRenderer.reset();
@@ -81,6 +110,11 @@ namespace CasperTech
             _volumeFilter->disconnectSink();
             _volumeFilter.reset();
         }
+        if (_rateFilter)
+        {
+            _rateFilter->disconnectSink();
+            _rateFilter.reset();
+        }
         if (_loadedFile)
         {
             _loadedFile->disconnectSink();
@@ -91,6 +125,19 @@ namespace CasperTech
         {
             _controlThread.join();
         }
+        // A file still opening gives up at its next read
+        if (_openingSource)
+        {
+            _openingSource->interrupt();
+        }
+        if (_enqueueSource)
+        {
+            _enqueueSource->interrupt();
+        }
+        for(auto& thread: _openThreads)
+        {
+            thread.join();
+        }
 #ifdef _DEBUG
         std::cout << "Done destructing AudioPlayerIMpl" << std::endl;
 #endif
@@ -107,21 +154,47 @@ namespace CasperTech
         std::shared_ptr<PlayerEvent> evt;
         while(true)
         {
+            reportUnderruns();
             {
                 std::unique_lock<std::mutex> commandLock(_eventThreadMutex);
-                while(_running && _eventQueue.empty())
+                auto ready = [this]
                 {
-                    _eventWait.wait(commandLock, [this]
-                    {
-                        return !_running || !_eventQueue.empty();
-                    });
+                    return !_running || !_eventQueue.empty();
+                };
+                bool signalled = true;
+                if (watchingUnderruns())
+                {
+                    signalled = _eventWait.wait_for(commandLock, underrunPollInterval, ready);
+                }
+                else
+                {
+                    // Nothing can underrun, so an idle player sleeps until it's told to do something
+                    _eventWait.wait(commandLock, ready);
                 }
                 if(!_running)
                 {
                     break;
                 }
+                if(!signalled)
+                {
+                    continue;
+                }
                 evt = _eventQueue.front();
                 _eventQueue.pop();
+                if (evt->eventType == EventType::Command)
+                {
+                    auto cmd = std::static_pointer_cast<CommandEvent>(evt);
+                    std::shared_ptr<CommandEvent>* slot = coalescingSlot(cmd->commandType);
+                    if (slot != nullptr && *slot == cmd)
+                    {
+                        slot->reset();
+                    }
+                    if (cmd->superseded)
+                    {
+                        // Already resolved when it was overtaken
+                        continue;
+                    }
+                }
             }
 
             if(evt)
@@ -140,6 +213,7 @@ namespace CasperTech
                         {
                             std::unique_lock<std::mutex> lk(_playThreadMutex);
                             
+                            _stats->setPlaying(false);
                             _readerState = PlayerState::Paused;
                             _state = PlayerState::Paused;
                             break;
@@ -147,7 +221,10 @@ namespace CasperTech
                         case EventType::PlaybackError:
                         {
                             auto errorEvt = std::static_pointer_cast<PlaybackErrorEvent>(evt);
-                            errorEvt->msg = FFSource::getError(errorEvt->code);
+                            if (errorEvt->msg.empty())
+                            {
+                                errorEvt->msg = FFSource::getError(errorEvt->code);
+                            }
                             break;
                         }
                     }
@@ -163,11 +240,244 @@ namespace CasperTech
         }
     }
 
+    std::shared_ptr<IAudioSink> AudioPlayerImpl::createRenderer()
+    {
+        switch(_options.renderer.type)
+        {
+            case RendererType::Null:
+                return std::make_shared<NullRenderer>(_options.renderer.clockMode);
+            case RendererType::File:
+                return std::make_shared<FileRenderer>(_options.renderer.fileName, _options.renderer.clockMode);
+            case RendererType::Mixer:
+                return std::make_shared<MixerRenderer>(OutputMixer::shared());
+            case RendererType::RtAudio:
+                [[fallthrough]];
+            default:
+                return std::make_shared<RtAudioRenderer>();
+        }
+    }
+
+    void AudioPlayerImpl::applyVolume(float volume, uint32_t rampMs, VolumeCurve curve)
+    {
+        // A mixer voice is scaled as it's mixed, so VolumeFilter is left at unity
+        if (auto voice = std::dynamic_pointer_cast<MixerRenderer>(_audioRenderer))
+        {
+            voice->setVolume(volume, rampMs, curve);
+            return;
+        }
+        _volumeFilter->setVolume(volume, rampMs, curve);
+    }
+
+    void AudioPlayerImpl::attachStats()
+    {
+        _audioRenderer->setStats(_stats);
+        _sampleRateConverter->setStats(_stats);
+        _volumeFilter->setStats(_stats);
+        _rateFilter->setStats(_stats);
+        if (_readAhead)
+        {
+            _readAhead->setStats(_stats);
+        }
+        if (_loadedFile)
+        {
+            _loadedFile->setStats(_stats);
+        }
+    }
+
+    void AudioPlayerImpl::releaseReadAhead()
+    {
+        if (_readAhead)
+        {
+            _readAhead->shutdown();
+            _readAhead->disconnectSink();
+            _readAhead.reset();
+        }
+    }
+
+    void AudioPlayerImpl::flushChain()
+    {
+        if (_readAhead)
+        {
+            // The feeding thread flushes the rest of the chain once what it's
+            // passing on has gone, so nothing decoded before now slips through
+            _readAhead->flush();
+            return;
+        }
+        _volumeFilter->flush();
+    }
+
+    void AudioPlayerImpl::clearNextTracks()
+    {
+        std::unique_lock<std::mutex> lk(_nextTracksMutex);
+        _nextTracks = {};
+    }
+
+    bool AudioPlayerImpl::startNextTrack()
+    {
+        std::shared_ptr<FFSource> next;
+        {
+            std::unique_lock<std::mutex> lk(_nextTracksMutex);
+            if (_nextTracks.empty())
+            {
+                return false;
+            }
+            next = _nextTracks.front();
+            _nextTracks.pop();
+        }
+
+        next->setStats(_stats);
+        // With a matching format the new source simply takes over the chain, so its
+        // first sample follows the last of the old track in the same buffers
+        const bool handedOver = _loadedFile->handOver(next);
+        if (!handedOver)
+        {
+            // The renderer starts its clock over as it's reconfigured
+            _stats->clock.setStartMs(0);
+            // Otherwise the chain has to renegotiate, which can't happen under audio
+            // still queued in the old format
+            if (_readAhead)
+            {
+                _readAhead->waitUntilDrained();
+            }
+            _loadedFile->disconnectSink();
+            try
+            {
+                std::unique_lock<std::mutex> lk(_playThreadMutex);
+                if (_converterBypassed)
+                {
+                    // The clip skipped the converter; a file needs it back
+                    _converterBypassed = false;
+                    connectChain();
+                }
+                lk.unlock();
+                if (_readAhead)
+                {
+                    next->connectSink(_readAhead);
+                }
+                else
+                {
+                    next->connectSink(_volumeFilter);
+                }
+            }
+            catch(const AudioException& e)
+            {
+                addEvent(std::make_shared<PlaybackErrorEvent>(-1, e.message()));
+                return false;
+            }
+        }
+        {
+            std::unique_lock<std::mutex> lk(_playThreadMutex);
+            _loadedFile = next;
+        }
+
+        // Reported when the boundary leaves the read-ahead queue, rather than when
+        // the new track starts decoding up to readAheadMs early
+        // The clock's new track starts there too, behind the end of the old one
+        auto evt = std::make_shared<TrackChangedEvent>(next->getFileName());
+        if (_readAhead)
+        {
+            _readAhead->addMarker([this, evt, handedOver]
+            {
+                if (handedOver)
+                {
+                    _stats->clock.startTrack();
+                }
+                addEvent(evt);
+            });
+        }
+        else
+        {
+            if (handedOver)
+            {
+                _stats->clock.startTrack();
+            }
+            addEvent(evt);
+        }
+        return true;
+    }
+
+    PipelineStatsSnapshot AudioPlayerImpl::getStats() const
+    {
+        return _stats->snapshot();
+    }
+
+    double AudioPlayerImpl::getPositionMs() const
+    {
+        return _stats->clock.positionMs();
+    }
+
+    bool AudioPlayerImpl::watchingUnderruns() const
+    {
+        // Playing, or holding back a report until the interval is up
+        return _readerState.load() == PlayerState::Playing
+               || _stats->underruns.load(std::memory_order_relaxed) != _reportedUnderruns;
+    }
+
+    void AudioPlayerImpl::reportUnderruns()
+    {
+        const uint64_t total = _stats->underruns.load(std::memory_order_relaxed);
+        if (total == _reportedUnderruns)
+        {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - _lastUnderrunReport < underrunReportInterval)
+        {
+            return;
+        }
+        auto evt = std::make_shared<UnderrunEvent>(total - _reportedUnderruns, total, _stats->lastUnderrunMs.load(std::memory_order_relaxed));
+        _reportedUnderruns = total;
+        _lastUnderrunReport = now;
+        try
+        {
+            _eventReceiver->onPlayerEvent(evt);
+        }
+        catch(...)
+        {
+            assert(false);
+        }
+    }
+
     void AudioPlayerImpl::addEvent(const std::shared_ptr<PlayerEvent>& command)
     {
-        std::unique_lock<std::mutex> eventLock(_eventThreadMutex);
-        _eventQueue.push(command);
-        _eventWait.notify_one();
+        std::shared_ptr<CommandEvent> superseded;
+        {
+            std::unique_lock<std::mutex> eventLock(_eventThreadMutex);
+            if (command->eventType == EventType::Command)
+            {
+                auto cmd = std::static_pointer_cast<CommandEvent>(command);
+                std::shared_ptr<CommandEvent>* slot = coalescingSlot(cmd->commandType);
+                if (slot != nullptr)
+                {
+                    superseded = std::exchange(*slot, cmd);
+                    if (superseded)
+                    {
+                        superseded->superseded = true;
+                    }
+                }
+            }
+            _eventQueue.push(command);
+            _eventWait.notify_one();
+        }
+        if (superseded)
+        {
+            superseded->completionEvent(CommandResult::Superseded, "");
+        }
+    }
+
+    std::shared_ptr<CommandEvent>* AudioPlayerImpl::coalescingSlot(Command type)
+    {
+        switch(type)
+        {
+            case Command::Seek:
+                return &_queuedSeek;
+            case Command::SetVolume:
+                return &_queuedVolume;
+            case Command::Load:
+                return &_queuedLoad;
+            default:
+                return nullptr;
+        }
     }
 
     void AudioPlayerImpl::load(const std::string& fileName, const ResultCallback& callback)
@@ -178,33 +488,321 @@ namespace CasperTech
         addEvent(loadCommand);
     }
 
-    void AudioPlayerImpl::loadFile(const std::string& fileName)
+    void AudioPlayerImpl::load(const std::shared_ptr<IByteReader>& reader, const std::string& fileName, const ResultCallback& callback)
     {
-        if(_state != PlayerState::Unloaded)
+        auto loadCommand = std::make_shared<LoadCommand>();
+        loadCommand->fileName = fileName;
+        loadCommand->reader = reader;
+        loadCommand->completionEvent = callback;
+        addEvent(loadCommand);
+    }
+
+    void AudioPlayerImpl::enqueue(const std::string& fileName, const ResultCallback& callback)
+    {
+        auto enqueueCommand = std::make_shared<EnqueueCommand>();
+        enqueueCommand->fileName = fileName;
+        enqueueCommand->completionEvent = callback;
+        addEvent(enqueueCommand);
+    }
+
+    void AudioPlayerImpl::startOpen(const std::shared_ptr<LoadCommand>& load)
+    {
+        auto source = std::make_shared<FFSource>();
+        source->setOpenOptions(_options.open);
+        _openingLoad = load;
+        _openingSource = source;
+        _openThreads.emplace_back([this, load, source, renderer = _audioRenderer]
+        {
+            auto opened = std::make_shared<TrackOpenedCommand>();
+            opened->load = load;
+            opened->openThread = std::this_thread::get_id();
+            try
+            {
+                opened->source = openTrack(load, source, renderer, opened->converterBypassed);
+            }
+            catch(const CommandException& e)
+            {
+                opened->result = e.result();
+                opened->errorMessage = e.message();
+            }
+            catch(const AudioException& e)
+            {
+                opened->result = CommandResult::LoadError;
+                opened->errorMessage = e.message();
+            }
+            addEvent(opened);
+        });
+    }
+
+    void AudioPlayerImpl::joinOpenThread(std::thread::id id)
+    {
+        auto thread = std::find_if(_openThreads.begin(), _openThreads.end(), [id](const std::thread& t)
+        {
+            return t.get_id() == id;
+        });
+        if (thread != _openThreads.end())
         {
-            unload();
+            // It has nothing left to do but return
+            thread->join();
+            _openThreads.erase(thread);
         }
-        _loadedFile = std::make_shared<FFSource>();
-        _loadedFile->load(fileName);
-        _state = PlayerState::Loaded;
     }
 
-    void AudioPlayerImpl::unload()
+    void AudioPlayerImpl::finishOpen(const std::shared_ptr<TrackOpenedCommand>& opened)
     {
-        _state = PlayerState::Unloaded;
+        joinOpenThread(opened->openThread);
+        if (opened->enqueue)
+        {
+            finishEnqueue(opened);
+            return;
+        }
+        if (opened->load != _openingLoad)
+        {
+            // Cancelled, and already resolved
+            return;
+        }
+        auto load = _openingLoad;
+        _openingLoad.reset();
+        _openingSource.reset();
+
+        if (opened->result == CommandResult::Success)
+        {
+            _state = PlayerState::Loaded;
+
+            // Spawn the play thread
+            std::unique_lock<std::mutex> lk(_playThreadMutex);
+            _loadedFile = opened->source;
+            _converterBypassed = opened->converterBypassed;
+            try
+            {
+                connectChain();
+                if (_options.readAheadMs > 0)
+                {
+                    _readAhead = std::make_shared<ReadAheadBuffer>(_options.readAheadMs);
+                    _readAhead->connectSink(_volumeFilter);
+                    _loadedFile->connectSink(_readAhead);
+                }
+                else
+                {
+                    _loadedFile->connectSink(_volumeFilter);
+                }
+                attachStats();
+
+                // Start in a paused state
+                _readerState = PlayerState::Paused;
+                _playThread = std::thread(&AudioPlayerImpl::playThreadFunc, this);
+                _playWait.wait(lk, [this]
+                {
+                    return _playThreadRunning;
+                });
+                lk.unlock();
+                load->completionEvent(CommandResult::Success, "");
+            }
+            catch(const AudioException& e)
+            {
+                lk.unlock();
+                load->completionEvent(CommandResult::PlayError, e.message());
+            }
+        }
+        else
+        {
+            load->completionEvent(opened->result, opened->errorMessage);
+        }
+
+        // Carried out in the order they came, as if they'd waited in the queue.
+        // Without a track they fail as they would have.
+        std::queue<std::shared_ptr<CommandEvent>> held;
+        std::swap(held, _heldCommands);
+        while(!held.empty())
+        {
+            handleCommand(held.front());
+            held.pop();
+        }
     }
 
-    void AudioPlayerImpl::play(const ResultCallback& callback)
+    bool AudioPlayerImpl::cancelOpen()
     {
-        if(_state == PlayerState::Unloaded)
+        if (!_openingLoad)
         {
-            throw CommandException(CommandResult::GenericFailure, "No file loaded");
+            return false;
         }
-        if(_state == PlayerState::Playing)
+        // Its thread carries on until it notices, and what it opened is dropped
+        _openingSource->interrupt();
+        _openingLoad->completionEvent(CommandResult::Superseded, "");
+        _openingLoad.reset();
+        _openingSource.reset();
+        while(!_heldCommands.empty())
         {
+            _heldCommands.front()->completionEvent(CommandResult::Superseded, "");
+            _heldCommands.pop();
+        }
+        return true;
+    }
+
+    void AudioPlayerImpl::startEnqueue(const std::shared_ptr<EnqueueCommand>& enqueue)
+    {
+        if (_openingEnqueue)
+        {
+            _pendingEnqueues.push(enqueue);
             return;
         }
+        auto source = std::make_shared<FFSource>();
+        source->setOpenOptions(_options.open);
+        _openingEnqueue = enqueue;
+        _enqueueSource = source;
+        _openThreads.emplace_back([this, enqueue, source]
+        {
+            auto opened = std::make_shared<TrackOpenedCommand>();
+            opened->enqueue = enqueue;
+            opened->openThread = std::this_thread::get_id();
+            try
+            {
+                source->load(enqueue->fileName);
+                opened->source = source;
+            }
+            catch(const CommandException& e)
+            {
+                opened->result = e.result();
+                opened->errorMessage = e.message();
+            }
+            catch(const AudioException& e)
+            {
+                opened->result = CommandResult::LoadError;
+                opened->errorMessage = e.message();
+            }
+            addEvent(opened);
+        });
+    }
 
+    void AudioPlayerImpl::finishEnqueue(const std::shared_ptr<TrackOpenedCommand>& opened)
+    {
+        if (opened->enqueue != _openingEnqueue)
+        {
+            // Cancelled, and already resolved
+            return;
+        }
+        auto enqueue = _openingEnqueue;
+        auto source = _enqueueSource;
+        _openingEnqueue.reset();
+        _enqueueSource.reset();
+
+        if (opened->result == CommandResult::Success)
+        {
+            {
+                std::unique_lock<std::mutex> lk(_nextTracksMutex);
+                _nextTracks.push(source);
+            }
+            enqueue->completionEvent(CommandResult::Success, "");
+        }
+        else
+        {
+            enqueue->completionEvent(opened->result, opened->errorMessage);
+        }
+
+        if (!_pendingEnqueues.empty())
+        {
+            auto next = _pendingEnqueues.front();
+            _pendingEnqueues.pop();
+            startEnqueue(next);
+        }
+    }
+
+    void AudioPlayerImpl::cancelEnqueues()
+    {
+        if (_openingEnqueue)
+        {
+            _enqueueSource->interrupt();
+            _openingEnqueue->completionEvent(CommandResult::Superseded, "");
+            _openingEnqueue.reset();
+            _enqueueSource.reset();
+        }
+        while(!_pendingEnqueues.empty())
+        {
+            _pendingEnqueues.front()->completionEvent(CommandResult::Superseded, "");
+            _pendingEnqueues.pop();
+        }
+    }
+
+    std::shared_ptr<ITrackSource> AudioPlayerImpl::openTrack(const std::shared_ptr<LoadCommand>& load, const std::shared_ptr<FFSource>& source,
+                                                             const std::shared_ptr<IAudioSink>& renderer, bool& converterBypassed) const
+    {
+        const std::string& fileName = load->fileName;
+        converterBypassed = false;
+        // With fast open the decoder waits for playback, so a load only pays for
+        // what it needs to start. Enqueued tracks always open it, ahead of the
+        // hand-over.
+        source->setLazyDecoder(_options.open.skipStreamInfo);
+        if (load->reader)
+        {
+            source->load(load->reader, fileName);
+            return source;
+        }
+
+        std::string key;
+        if (_options.clipCacheMaxMs > 0)
+        {
+            key = ClipCache::keyFor(fileName);
+        }
+        ClipCache& cache = ClipCache::shared();
+        if (!key.empty())
+        {
+            // Each renderer type negotiates its own format, so each has its own copy
+            key += '|' + renderer->getName();
+            auto clip = cache.find(key);
+            const auto rates = renderer->getSupportedSampleRates();
+            if (clip
+                && (renderer->getSupportedSampleFormats() & clip->format) != 0
+                && RateFilter::supports(clip->format)
+                && std::find(rates.begin(), rates.end(), clip->sampleRate) != rates.end())
+            {
+                converterBypassed = true;
+                return std::make_shared<ClipSource>(clip, fileName);
+            }
+        }
+
+        source->load(fileName);
+        const uint64_t durationMs = source->getDurationMs();
+        if (key.empty() || durationMs == 0 || durationMs > _options.clipCacheMaxMs)
+        {
+            return source;
+        }
+        // Decoding a clip this short takes about as long as opening it did, and
+        // every later load of it skips both
+        source->prepareDecoder();
+        auto clip = ClipSource::decode(source, renderer, cache.getBudget());
+        if (!clip || !RateFilter::supports(clip->format))
+        {
+            return source;
+        }
+        cache.insert(key, clip);
+        converterBypassed = true;
+        return std::make_shared<ClipSource>(clip, fileName);
+    }
+
+    void AudioPlayerImpl::connectChain()
+    {
+        // RateFilter passes on the format it's given, so it's offered whatever the
+        // renderer takes again rather than what the last chain fed it
+        _rateFilter->disconnectSource();
+        _rateFilter->connectSink(_audioRenderer);
+        if (_converterBypassed)
+        {
+            _volumeFilter->connectSink(_rateFilter);
+            return;
+        }
+        _sampleRateConverter->connectSink(_rateFilter);
+        _volumeFilter->connectSink(_sampleRateConverter);
+    }
+
+    void AudioPlayerImpl::unload()
+    {
+        _state = PlayerState::Unloaded;
+    }
+
+    void AudioPlayerImpl::play(const ResultCallback& callback)
+    {
+        // Checked on the control thread, which holds it while a load is opening
+        // and answers it at once when there's nothing to play or it's playing
         auto playCommand = std::make_shared<PlayCommand>();
         playCommand->completionEvent = callback;
         addEvent(playCommand);
@@ -232,14 +830,25 @@ namespace CasperTech
         addEvent(seekCommand);
     }
 
-    void AudioPlayerImpl::setVolume(float volume, const ResultCallback& callback)
+    void AudioPlayerImpl::setVolume(float volume, uint32_t rampMs, VolumeCurve curve, const ResultCallback& callback)
     {
         auto setVolumeCommand = std::make_shared<SetVolumeCommand>();
         setVolumeCommand->completionEvent = callback;
         setVolumeCommand->volume = volume;
+        setVolumeCommand->rampMs = rampMs;
+        setVolumeCommand->curve = curve;
         addEvent(setVolumeCommand);
     }
 
+    void AudioPlayerImpl::setPlaybackRate(double rate, PlaybackRateMode mode, const ResultCallback& callback)
+    {
+        auto setPlaybackRateCommand = std::make_shared<SetPlaybackRateCommand>();
+        setPlaybackRateCommand->completionEvent = callback;
+        setPlaybackRateCommand->rate = rate;
+        setPlaybackRateCommand->mode = mode;
+        addEvent(setPlaybackRateCommand);
+    }
+
     void AudioPlayerImpl::playThreadFunc()
     {
         {
@@ -266,44 +875,76 @@ namespace CasperTech
             {
                 {
                     std::unique_lock<std::mutex> lk(_directPlayerCommandMutex);
+                    // Only the newest seek is carried out. Any before it arrived while
+                    // the last packet was read, and landing on them would be wasted.
+                    std::shared_ptr<SeekCommand> seek;
                     while(!_directPlayerCommandQueue.empty())
                     {
                         auto evt = _directPlayerCommandQueue.front();
                         _directPlayerCommandQueue.pop();
-                        switch(evt->commandType)
+                        if (evt->commandType == Command::Seek)
                         {
-                            case Command::Seek:
-                            {
-                                auto event = std::static_pointer_cast<SeekCommand>(evt);
-                                _loadedFile->seek(event->seekMs);
-                                break;
-                            }
-                            case Command::SetVolume:
-                            {
-                                auto event = std::static_pointer_cast<SetVolumeCommand>(evt);
-                                _volumeFilter->setVolume(event->volume);
-                                break;
-                            }
-                            default:
-                                break;
+                            seek = std::static_pointer_cast<SeekCommand>(evt);
+                        }
+                    }
+                    if (seek)
+                    {
+                        const uint64_t requested = static_cast<uint64_t>(std::max<int64_t>(seek->seekMs, 0));
+                        const int64_t position = _loadedFile->seek(requested);
+                        if (position < 0)
+                        {
+                            // Playback carries on where it was
+                            addEvent(std::make_shared<PlaybackErrorEvent>(static_cast<int>(position), "Seek failed: " + FFSource::getError(static_cast<int>(position))));
+                        }
+                        else
+                        {
+                            // Only flushed once the seek has landed, so the clock
+                            // starts over from where it did
+                            _stats->clock.setStartMs(static_cast<uint64_t>(position));
+                            flushChain();
+                            addEvent(std::make_shared<SeekedEvent>(requested, static_cast<uint64_t>(position)));
+                            _trackEnded = false;
                         }
                     }
                     _commandWaiting = false;
                 }
             }
+            if (_trackEnded)
+            {
+                // Played again after finishing. Anything enqueued since follows on;
+                // otherwise the last track starts over.
+                _trackEnded = false;
+                if (!startNextTrack())
+                {
+                    _stats->clock.startTrack();
+                }
+            }
             result = _loadedFile->getPacket(frame.get());
             if (result == -11)
             {
                 result = 1;
                 continue;
             }
+            if (result == 0 && startNextTrack())
+            {
+                result = 1;
+                continue;
+            }
             if (result == 0)
             {
+                _trackEnded = true;
                 _readerState = PlayerState::Paused;
+                // The end has only been decoded so far; playback finishes once the
+                // read-ahead queue has emptied
+                if (_readAhead)
+                {
+                    _readAhead->waitUntilDrained();
+                }
                 addEvent(std::make_shared<PlaybackFinishedEvent>());
             }
         }
-        if (result < 0)
+        // AVERROR_EXIT is an interrupted read, from stopping
+        if (result < 0 && result != AVERROR_EXIT)
         {
             addEvent(std::make_shared<PlaybackErrorEvent>(result));
             addEvent(std::make_shared<PlaybackFinishedEvent>());
@@ -315,12 +956,30 @@ namespace CasperTech
 
     void AudioPlayerImpl::handleCommand(const std::shared_ptr<CommandEvent>& cmd)
     {
+        if (_openingLoad)
+        {
+            switch(cmd->commandType)
+            {
+                case Command::Play:
+                case Command::Pause:
+                case Command::Seek:
+                case Command::Enqueue:
+                    // These act on the track, so wait for it. Anything else is
+                    // carried out now: a stop or load cancels the open.
+                    _heldCommands.push(cmd);
+                    return;
+                default:
+                    break;
+            }
+        }
         try
         {
             switch(cmd->commandType)
             {
                 case Command::Load:
                 {
+                    cancelOpen();
+
                     // First unload and stop any existing thread
 
                     bool unpause = false;
@@ -335,60 +994,61 @@ namespace CasperTech
                                 unpause = true;
                             }
                             _readerState = PlayerState::Unloaded;
+                            if (_loadedFile)
+                            {
+                                _loadedFile->interrupt();
+                            }
                         }
                     }
                     if(unpause)
                     {
                         _pauseWait.notify_all();
                     }
+                    if (_readAhead)
+                    {
+                        _readAhead->shutdown();
+                    }
                     if(join && _playThread.joinable())
                     {
                         _playThread.join();
                         _playThreadRunning = false;
                     }
-
-                    // Load the new file
-                    auto evt = std::static_pointer_cast<LoadCommand>(cmd);
-                    loadFile(evt->fileName);
-
-                    // Spawn the play thread
+                    releaseReadAhead();
+                    cancelEnqueues();
+                    clearNextTracks();
+                    _trackEnded = false;
+                    if (_loadedFile)
                     {
-                        std::unique_lock<std::mutex> lk(_playThreadMutex);
-                        try
-                        {
-                            _sampleRateConverter->connectSink(_audioRenderer);
-                            //_loadedFile->connectSink(_sampleRateConverter);
-                            _volumeFilter->connectSink(_sampleRateConverter);
-                            _loadedFile->connectSink(_volumeFilter);
-                        }
-                        catch(const AudioException& e)
-                        {
-                            lk.unlock();
-                            evt->completionEvent(CommandResult::PlayError, e.message());
-                            return;
-                        }
-                        // Start in a paused state
-                        _readerState = PlayerState::Paused;
-                        _playThread = std::thread(&AudioPlayerImpl::playThreadFunc, this);
-                        _playWait.wait(lk, [this]
-                        {
-                            return _playThreadRunning;
-                        });
+                        _loadedFile->disconnectSink();
+                        _loadedFile.reset();
                     }
-                    evt->completionEvent(CommandResult::Success, "");
+                    unload();
+                    _stats->clock.setStartMs(0);
+                    flushChain();
+
+                    _stats->setPlaying(false);
+
+                    // Opening can wait on a slow disk or network for seconds, so it
+                    // happens elsewhere and this thread stays free for a stop
+                    startOpen(std::static_pointer_cast<LoadCommand>(cmd));
+                    break;
+                }
+                case Command::TrackOpened:
+                {
+                    finishOpen(std::static_pointer_cast<TrackOpenedCommand>(cmd));
                     break;
                 }
                 case Command::Play:
                 {
                     auto evt = std::static_pointer_cast<PlayCommand>(cmd);
                     {
-                        if(!_loadedFile)
-                        {
-                            throw CommandException(CommandResult::GenericFailure, "No file loaded");
-                        }
                         bool unpause = false;
                         {
                             std::unique_lock<std::mutex> lk(_playThreadMutex);
+                            if(!_loadedFile)
+                            {
+                                throw CommandException(CommandResult::GenericFailure, "No file loaded");
+                            }
                             if(!_playThreadRunning)
                             {
                                 throw CommandException(CommandResult::GenericFailure, "No file playing");
@@ -397,8 +1057,13 @@ namespace CasperTech
                             {
                                 unpause = true;
                                 _readerState = PlayerState::Playing;
+                                _stats->setPlaying(true);
                             }
                         }
+                        if (_readAhead)
+                        {
+                            _readAhead->setPaused(false);
+                        }
                         if (unpause)
                         {
                             _pauseWait.notify_all();
@@ -410,42 +1075,54 @@ namespace CasperTech
                 case Command::Stop:
                 {
                     auto evt = std::static_pointer_cast<StopCommand>(cmd);
+                    if (cancelOpen())
+                    {
+                        // The last track was already stopped for the load
+                        evt->completionEvent(CommandResult::Success, "");
+                        break;
+                    }
                     {
-                        if(!_loadedFile)
-                        {
-                            throw CommandException(CommandResult::GenericFailure, "No file loaded");
-                        }
                         bool unpause = false;
                         {
                             std::unique_lock<std::mutex> commandLock(_playThreadMutex);
+                            if(!_loadedFile)
+                            {
+                                throw CommandException(CommandResult::GenericFailure, "No file loaded");
+                            }
                             if (_readerState == PlayerState::Paused)
                             {
                                 unpause = true;
                             }
                             _readerState = PlayerState::Unloaded;
+                            _loadedFile->interrupt();
+                            _stats->setPlaying(false);
                         }
                         if (unpause)
                         {
                             _pauseWait.notify_all();
                         }
+                        if (_readAhead)
+                        {
+                            _readAhead->shutdown();
+                        }
                         if(_playThread.joinable())
                         {
                             _playThread.join();
                             _playThreadRunning = false;
                         }
 
-
-                        _audioRenderer.reset();
-                        _sampleRateConverter->disconnectSink();
-                        _sampleRateConverter.reset();
-                        _volumeFilter->disconnectSink();
-                        _volumeFilter.reset();
+                        // The renderer, converter and volume stages stay connected
+                        // for the next Load, which only has to plug in a new source.
+                        // The renderer keeps its device open unless the next file
+                        // needs a different output format.
+                        releaseReadAhead();
+                        cancelEnqueues();
+                        clearNextTracks();
+                        _trackEnded = false;
                         _loadedFile->disconnectSink();
                         _loadedFile.reset();
-
-                        _audioRenderer = std::make_shared<RtAudioRenderer>();
-                        _sampleRateConverter = std::make_shared<SampleRateConverter>();
-                        _volumeFilter = std::make_shared<VolumeFilter>();
+                        _stats->clock.setStartMs(0);
+                        flushChain();
 
                         evt->completionEvent(CommandResult::Success, "");
                     }
@@ -454,23 +1131,55 @@ namespace CasperTech
                 case Command::Pause:
                 {
                     auto evt = std::static_pointer_cast<StopCommand>(cmd);
-                    if(!_loadedFile)
-                    {
-                        throw CommandException(CommandResult::GenericFailure, "No file loaded");
-                    }
                     {
                         std::unique_lock<std::mutex> commandLock(_playThreadMutex);
+                        if(!_loadedFile)
+                        {
+                            throw CommandException(CommandResult::GenericFailure, "No file loaded");
+                        }
                         _readerState = PlayerState::Paused;
+                        _stats->setPlaying(false);
+                    }
+                    if (_readAhead)
+                    {
+                        // Otherwise the queue would carry on playing after the decoder stops
+                        _readAhead->setPaused(true);
                     }
                     evt->completionEvent(CommandResult::Success, "");
                     break;
                 }
+                case Command::Enqueue:
+                {
+                    auto evt = std::static_pointer_cast<EnqueueCommand>(cmd);
+                    {
+                        std::unique_lock<std::mutex> lk(_playThreadMutex);
+                        if(!_loadedFile)
+                        {
+                            throw CommandException(CommandResult::GenericFailure, "No file loaded");
+                        }
+                    }
+                    // Opened well before the play thread needs the track, and off this
+                    // thread, so a slow file can't hold up a stop or a load. It
+                    // resolves once it's open.
+                    startEnqueue(evt);
+                    break;
+                }
                 case Command::SetVolume:
                 {
+                    // VolumeFilter or the mixer picks this up at its next block, so
+                    // there's no need to wait for the play thread to come round
+                    // between packets
                     auto evt = std::static_pointer_cast<SetVolumeCommand>(cmd);
-                    std::unique_lock<std::mutex> lk(_directPlayerCommandMutex);
-                    _directPlayerCommandQueue.push(cmd);
-                    _commandWaiting = true;
+                    _volume = evt->volume;
+                    applyVolume(evt->volume, evt->rampMs, evt->curve);
+                    evt->completionEvent(CommandResult::Success, "");
+                    break;
+                }
+                case Command::SetPlaybackRate:
+                {
+                    // Like the volume, picked up by RateFilter at its next block
+                    auto evt = std::static_pointer_cast<SetPlaybackRateCommand>(cmd);
+                    _rateFilter->setRate(evt->rate, evt->mode);
                     evt->completionEvent(CommandResult::Success, "");
                     break;
                 }
@@ -1,52 +1,129 @@
 #pragma once
 
+#include <enums/PlaybackRateMode.h>
 #include <enums/PlayerState.h>
+#include <enums/VolumeCurve.h>
 #include <structs/events/CommandEvent.h>
+#include <structs/PlayerOptions.h>
+#include <structs/PipelineStatsSnapshot.h>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <interfaces/IAudioPlayerEventReceiver.h>
+#include "RateFilter.h"
 #include "SampleRateConverter.h"
 #include "VolumeFilter.h"
 
 namespace CasperTech
 {
     class FFSource;
-    class RtAudioRenderer;
+    class IByteReader;
+    class ITrackSource;
+    class ReadAheadBuffer;
+    struct EnqueueCommand;
+    struct LoadCommand;
+    struct PipelineStats;
+    struct TrackOpenedCommand;
     class AudioPlayerImpl
     {
         public:
-            explicit AudioPlayerImpl(IAudioPlayerEventReceiver* eventReceiver);
+            explicit AudioPlayerImpl(IAudioPlayerEventReceiver* eventReceiver, PlayerOptions options = {});
 
             ~AudioPlayerImpl();
 
             void load(const std::string& fileName, const ResultCallback& callback);
+            // Plays a file read through reader, such as one held in memory. fileName
+            // only names it in events.
+            void load(const std::shared_ptr<IByteReader>& reader, const std::string& fileName, const ResultCallback& callback);
+            // Opens fileName now and plays it straight after the current track (or the
+            // one enqueued before it), with no gap if the formats match
+            void enqueue(const std::string& fileName, const ResultCallback& callback);
             void play(const ResultCallback& callback);
             void stop(const ResultCallback& callback);
             void seek(int64_t seekMs, const ResultCallback& callback);
             void pause(const ResultCallback& callback);
-            void setVolume(float volume, const ResultCallback& callback);
+            void setVolume(float volume, uint32_t rampMs, VolumeCurve curve, const ResultCallback& callback);
+            // rate is clamped to RateFilter::minRate..maxRate
+            void setPlaybackRate(double rate, PlaybackRateMode mode, const ResultCallback& callback);
+            PipelineStatsSnapshot getStats() const;
+            // Where in the track the output is playing now. Never locks.
+            double getPositionMs() const;
 
         private:
             void addEvent(const std::shared_ptr<PlayerEvent>& event);
-            void loadFile(const std::string& fileName);
+            // Where the last queued command of type waits to be overtaken, for the
+            // kinds where only the newest matters. nullptr for the rest.
+            std::shared_ptr<CommandEvent>* coalescingSlot(Command type);
+            // Opens load's file on a thread of its own, which posts a TrackOpened
+            // command back when it's done
+            void startOpen(const std::shared_ptr<LoadCommand>& load);
+            void finishOpen(const std::shared_ptr<TrackOpenedCommand>& opened);
+            // Abandons the load being opened, resolving it and the commands held
+            // behind it as superseded. Returns false if there wasn't one.
+            bool cancelOpen();
+            // Opens enqueue's file on a thread of its own, like startOpen. Enqueues
+            // are opened one at a time, so they join _nextTracks in order.
+            void startEnqueue(const std::shared_ptr<EnqueueCommand>& enqueue);
+            void finishEnqueue(const std::shared_ptr<TrackOpenedCommand>& opened);
+            // Abandons the enqueue being opened and those waiting behind it,
+            // resolving them as superseded
+            void cancelEnqueues();
+            void joinOpenThread(std::thread::id id);
+            // Runs on the opening thread, so only touches what it's given and _options
+            std::shared_ptr<ITrackSource> openTrack(const std::shared_ptr<LoadCommand>& load, const std::shared_ptr<FFSource>& source,
+                                                    const std::shared_ptr<IAudioSink>& renderer, bool& converterBypassed) const;
+            void connectChain();
             void handleCommand(const std::shared_ptr<CommandEvent>& command);
             void unload();
             void controlThreadFunc();
             void playThreadFunc();
+            std::shared_ptr<IAudioSink> createRenderer();
+            void applyVolume(float volume, uint32_t rampMs = 0, VolumeCurve curve = VolumeCurve::Linear);
+            void attachStats();
+            void releaseReadAhead();
+            // Drops the audio already on its way to the output, for a seek, stop or
+            // load. The stream stays open.
+            void flushChain();
+            bool startNextTrack();
+            void clearNextTracks();
+            void reportUnderruns();
+            // Whether the control thread needs to wake to poll for underruns
+            [[nodiscard]] bool watchingUnderruns() const;
+
+            // Underruns are counted on the audio thread and picked up here, so raising
+            // the event never touches the callback. At most one event is sent per
+            // report interval, carrying the count since the last one. Polled only
+            // while playing; otherwise the control thread waits for a command.
+            static constexpr std::chrono::milliseconds underrunPollInterval{ 250 };
+            static constexpr std::chrono::milliseconds underrunReportInterval{ 1000 };
 
             bool _running = false;
             bool _playThreadRunning = false;
-            std::shared_ptr<CasperTech::RtAudioRenderer> _audioRenderer;
+            PlayerOptions _options;
+            std::shared_ptr<PipelineStats> _stats;
+            float _volume = 1.0f;
+            uint64_t _reportedUnderruns = 0;
+            std::chrono::steady_clock::time_point _lastUnderrunReport;
+            std::shared_ptr<CasperTech::IAudioSink> _audioRenderer;
             std::shared_ptr<CasperTech::SampleRateConverter> _sampleRateConverter;
             std::shared_ptr<CasperTech::VolumeFilter> _volumeFilter;
+            std::shared_ptr<CasperTech::RateFilter> _rateFilter;
+            std::shared_ptr<CasperTech::ReadAheadBuffer> _readAhead;
             std::thread _controlThread;
             std::thread _playThread;
             std::queue<std::shared_ptr<PlayerEvent>> _eventQueue;
+            // Seeks, volume changes and loads still in _eventQueue. A newer one of the
+            // same kind resolves the older as superseded and it's skipped, so dragging
+            // a scrubber or slider can't build up a backlog. Under _eventThreadMutex.
+            std::shared_ptr<CommandEvent> _queuedSeek;
+            std::shared_ptr<CommandEvent> _queuedVolume;
+            std::shared_ptr<CommandEvent> _queuedLoad;
             std::queue<std::shared_ptr<CommandEvent>> _directPlayerCommandQueue;
             std::mutex _eventThreadMutex;
             std::mutex _playThreadMutex;
@@ -56,7 +133,32 @@ namespace CasperTech
             std::condition_variable _playWait;
             std::condition_variable _pauseWait;
 
-            std::shared_ptr<CasperTech::FFSource> _loadedFile;
+            // Replaced by the play thread when it moves on to an enqueued track, so
+            // the control thread reads it under _playThreadMutex while that runs
+            std::shared_ptr<CasperTech::ITrackSource> _loadedFile;
+            // Control thread only. The load whose file is being opened, and the
+            // source opening it, which stop() or a newer load interrupts.
+            std::shared_ptr<LoadCommand> _openingLoad;
+            std::shared_ptr<CasperTech::FFSource> _openingSource;
+            // Commands that need the track, waiting for _openingLoad to finish
+            std::queue<std::shared_ptr<CommandEvent>> _heldCommands;
+            // Control thread only. The enqueue whose file is being opened, its
+            // source, and the enqueues waiting for it to finish.
+            std::shared_ptr<EnqueueCommand> _openingEnqueue;
+            std::shared_ptr<CasperTech::FFSource> _enqueueSource;
+            std::queue<std::shared_ptr<EnqueueCommand>> _pendingEnqueues;
+            // Threads opening files, including abandoned ones still stuck in a read.
+            // Each is joined when its TrackOpened command arrives.
+            std::list<std::thread> _openThreads;
+            // The loaded track is a cached clip, already in the renderer's format,
+            // so VolumeFilter feeds RateFilter without the converter between them.
+            // Under _playThreadMutex, as the play thread clears it for a file.
+            bool _converterBypassed = false;
+            // Enqueued tracks, already opened, waiting for the current one to end
+            std::mutex _nextTracksMutex;
+            std::queue<std::shared_ptr<CasperTech::FFSource>> _nextTracks;
+            // Play thread only. The last track ended with nothing enqueued after it.
+            bool _trackEnded = false;
             PlayerState _state = PlayerState::Unloaded;
             std::atomic<PlayerState> _readerState{ PlayerState::Unloaded };
             std::atomic<bool> _commandWaiting = false;
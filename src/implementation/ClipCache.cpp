@@ -0,0 +1,120 @@
+#include "ClipCache.h"
+
+#include <filesystem>
+#include <system_error>
+
+namespace CasperTech
+{
+    ClipCache& ClipCache::shared()
+    {
+        static ClipCache cache;
+        return cache;
+    }
+
+    std::string ClipCache::keyFor(const std::string& fileName)
+    {
+        std::error_code ec;
+        const std::filesystem::path path(fileName);
+        if (!std::filesystem::is_regular_file(path, ec))
+        {
+            return "";
+        }
+        const auto size = std::filesystem::file_size(path, ec);
+        if (ec)
+        {
+            return "";
+        }
+        const auto modified = std::filesystem::last_write_time(path, ec);
+        if (ec)
+        {
+            return "";
+        }
+        return fileName + '|' + std::to_string(size) + '|' + std::to_string(modified.time_since_epoch().count());
+    }
+
+    std::shared_ptr<const PcmClip> ClipCache::find(const std::string& key)
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end())
+        {
+            _misses++;
+            return nullptr;
+        }
+        _hits++;
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return it->second->second;
+    }
+
+    void ClipCache::insert(const std::string& key, std::shared_ptr<const PcmClip> clip)
+    {
+        const uint64_t size = clip->data.size();
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _index.find(key);
+        if (it != _index.end())
+        {
+            // Decoded twice by players loading it at the same time
+            _bytes -= it->second->second->data.size();
+            _lru.erase(it->second);
+            _index.erase(it);
+        }
+        if (size > _budget)
+        {
+            return;
+        }
+        evictTo(_budget - size);
+        _lru.emplace_front(key, std::move(clip));
+        _index[key] = _lru.begin();
+        _bytes += size;
+    }
+
+    void ClipCache::erase(const std::string& key)
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end())
+        {
+            return;
+        }
+        _bytes -= it->second->second->data.size();
+        _lru.erase(it->second);
+        _index.erase(it);
+    }
+
+    void ClipCache::setBudget(uint64_t bytes)
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        _budget = bytes;
+        evictTo(_budget);
+    }
+
+    uint64_t ClipCache::getBudget() const
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        return _budget;
+    }
+
+    ClipCacheStats ClipCache::getStats() const
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        ClipCacheStats stats;
+        stats.hits = _hits;
+        stats.misses = _misses;
+        stats.evictions = _evictions;
+        stats.entries = _lru.size();
+        stats.bytes = _bytes;
+        stats.budgetBytes = _budget;
+        return stats;
+    }
+
+    void ClipCache::evictTo(uint64_t bytes)
+    {
+        while(_bytes > bytes && !_lru.empty())
+        {
+            _bytes -= _lru.back().second->data.size();
+            _index.erase(_lru.back().first);
+            _lru.pop_back();
+            _evictions++;
+        }
+    }
+}
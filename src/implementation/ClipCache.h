@@ -0,0 +1,78 @@
+#pragma once
+
+#include <enums/SampleFormatFlags.h>
+#include <structs/ClipCacheStats.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CasperTech
+{
+    // A short sound decoded in full, already in the format the output negotiated
+    // for it, so it can be played again without opening the file
+    struct PcmClip
+    {
+        SampleFormatFlags format = SampleFormatFlags::None;
+        uint32_t sampleRate = 0;
+        uint8_t channels = 0;
+        uint8_t sampleSize = 0;
+        std::vector<uint8_t> data;
+
+        [[nodiscard]] uint64_t frameSize() const
+        {
+            return static_cast<uint64_t>(sampleSize) * channels;
+        }
+
+        [[nodiscard]] uint64_t frames() const
+        {
+            return frameSize() != 0 ? data.size() / frameSize() : 0;
+        }
+    };
+
+    // Process wide LRU of decoded clips, shared by every player, holding at most
+    // budget bytes of PCM. Clips are immutable once cached, so a player keeps
+    // playing one it holds even after it has been evicted.
+    class ClipCache
+    {
+        public:
+            static constexpr uint64_t defaultBudgetBytes = 64 * 1024 * 1024;
+
+            static ClipCache& shared();
+
+            // Identifies fileName's current contents by path, size and modification
+            // time, so an edited file misses. Empty for anything that isn't a regular
+            // file, such as a URL, which is never cached.
+            static std::string keyFor(const std::string& fileName);
+
+            // Counts a hit or a miss, and marks a hit as the most recently used
+            std::shared_ptr<const PcmClip> find(const std::string& key);
+            // Evicts the least recently used clips to make room. A clip larger than
+            // the whole budget is not kept.
+            void insert(const std::string& key, std::shared_ptr<const PcmClip> clip);
+            void erase(const std::string& key);
+
+            void setBudget(uint64_t bytes);
+            [[nodiscard]] uint64_t getBudget() const;
+            [[nodiscard]] ClipCacheStats getStats() const;
+
+        private:
+            using Entry = std::pair<std::string, std::shared_ptr<const PcmClip>>;
+
+            void evictTo(uint64_t bytes);
+
+            mutable std::mutex _mutex;
+            // Most recently used first
+            std::list<Entry> _lru;
+            std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+            uint64_t _bytes = 0;
+            uint64_t _budget = defaultBudgetBytes;
+            uint64_t _hits = 0;
+            uint64_t _misses = 0;
+            uint64_t _evictions = 0;
+    };
+}
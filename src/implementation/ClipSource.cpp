@@ -0,0 +1,189 @@
+#include "ClipSource.h"
+#include "FFSource.h"
+#include "FFFrame.h"
+#include "PipelineStats.h"
+#include "SampleRateConverter.h"
+#include "ScopedStageTimer.h"
+
+#include <interfaces/IAudioSink.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace CasperTech
+{
+    // Stands in for the output while a clip is decoded, offering the same formats,
+    // rates and channels so the converter produces exactly what the output would
+    // have been fed, and keeping everything it's given
+    class ClipRecorder: public IAudioSink
+    {
+        public:
+            ClipRecorder(std::shared_ptr<IAudioSink> output, uint64_t maxBytes)
+                : _output(std::move(output))
+                , _maxBytes(maxBytes)
+            {
+
+            }
+
+            std::string getName() const override
+            {
+                return "ClipRecorder";
+            }
+
+            SampleFormatFlags getSupportedSampleFormats() override
+            {
+                return _output->getSupportedSampleFormats()
+                       & (SampleFormatFlags::U8 | SampleFormatFlags::S16 | SampleFormatFlags::S32
+                          | SampleFormatFlags::FLT | SampleFormatFlags::DBL);
+            }
+
+            std::vector<uint32_t> getSupportedSampleRates() override
+            {
+                return _output->getSupportedSampleRates();
+            }
+
+            uint8_t getSupportedChannels() override
+            {
+                return _output->getSupportedChannels();
+            }
+
+            void onSourceConfigured() override
+            {
+                clip = std::make_shared<PcmClip>();
+                clip->format = _sourceFormat;
+                clip->sampleRate = _sourceSampleRate;
+                clip->channels = _sourceChannels;
+                clip->sampleSize = static_cast<uint8_t>(av_get_bytes_per_sample(SampleRateConverter::getSwrSampleFormat(_sourceFormat)));
+            }
+
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override
+            {
+                const uint64_t bytes = sampleCount * clip->frameSize();
+                if (tooLarge || clip->data.size() + bytes > _maxBytes)
+                {
+                    tooLarge = true;
+                    return;
+                }
+                clip->data.insert(clip->data.end(), buffer, buffer + bytes);
+            }
+
+            void onEos() override
+            {
+
+            }
+
+            std::shared_ptr<PcmClip> clip;
+            bool tooLarge = false;
+
+        private:
+            std::shared_ptr<IAudioSink> _output;
+            uint64_t _maxBytes;
+    };
+
+    ClipSource::ClipSource(std::shared_ptr<const PcmClip> clip, std::string fileName)
+        : _clip(std::move(clip))
+        , _fileName(std::move(fileName))
+        , _blockFrames(std::max<uint64_t>(static_cast<uint64_t>(_clip->sampleRate) * blockMs / 1000, 1))
+        , _block(_blockFrames * _clip->frameSize())
+    {
+
+    }
+
+    std::shared_ptr<const PcmClip> ClipSource::decode(const std::shared_ptr<FFSource>& source,
+                                                      const std::shared_ptr<IAudioSink>& output,
+                                                      uint64_t maxBytes)
+    {
+        auto recorder = std::make_shared<ClipRecorder>(output, maxBytes);
+        if (recorder->getSupportedSampleFormats() == SampleFormatFlags::None)
+        {
+            return nullptr;
+        }
+        auto converter = std::make_shared<SampleRateConverter>();
+        converter->connectSink(recorder);
+        source->connectSink(converter);
+
+        FFFrame frame;
+        int result;
+        do
+        {
+            result = source->getPacket(&frame);
+        } while((result > 0 || result == AVERROR(EAGAIN)) && !recorder->tooLarge);
+
+        source->disconnectSink();
+        converter->disconnectSink();
+        if (result != 0)
+        {
+            // Stopped part way, so it has to be put back to the start to be played
+            source->seek(0);
+        }
+        if (result < 0 || recorder->tooLarge || recorder->clip->data.empty())
+        {
+            return nullptr;
+        }
+        recorder->clip->data.shrink_to_fit();
+        return recorder->clip;
+    }
+
+    int ClipSource::getPacket(FFFrame* frame)
+    {
+        const uint64_t frames = _clip->frames();
+        if (_position >= frames)
+        {
+            _position = 0;
+            return 0;
+        }
+
+        ScopedStageTimer timer(_stats ? &_stats->decode : nullptr);
+        const uint64_t count = std::min(_blockFrames, frames - _position);
+        const uint64_t bytes = count * _clip->frameSize();
+        std::memcpy(_block.data(), _clip->data.data() + _position * _clip->frameSize(), bytes);
+        _position += count;
+
+        if (_stats)
+        {
+            _stats->frames.fetch_add(1, std::memory_order_relaxed);
+            _stats->samples.fetch_add(count, std::memory_order_relaxed);
+        }
+        if (_sink)
+        {
+            _sink->audio(_block.data(), nullptr, count);
+        }
+        return 1;
+    }
+
+    int64_t ClipSource::seek(uint64_t timeMs)
+    {
+        _position = std::min<uint64_t>(timeMs * _clip->sampleRate / 1000, _clip->frames());
+        return static_cast<int64_t>(_position * 1000 / _clip->sampleRate);
+    }
+
+    void ClipSource::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        _stats = stats;
+    }
+
+    const std::string& ClipSource::getFileName() const
+    {
+        return _fileName;
+    }
+
+    SampleFormatFlags ClipSource::getSupportedSampleFormats()
+    {
+        return _clip->format;
+    }
+
+    std::vector<uint32_t> ClipSource::getSupportedSampleRates()
+    {
+        return { _clip->sampleRate };
+    }
+
+    uint8_t ClipSource::getSupportedChannels()
+    {
+        return _clip->channels;
+    }
+
+    std::string ClipSource::getName() const
+    {
+        return "ClipSource";
+    }
+}
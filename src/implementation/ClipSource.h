@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ClipCache.h"
+
+#include <interfaces/ITrackSource.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace CasperTech
+{
+    class FFSource;
+    class IAudioSink;
+
+    // Plays a cached PcmClip. The clip is already in the output's format, so it
+    // needs no decoder or resampler and its first block is ready the moment the
+    // chain is connected.
+    class ClipSource: public ITrackSource
+    {
+        public:
+            ClipSource(std::shared_ptr<const PcmClip> clip, std::string fileName);
+
+            // Decodes the whole of source, converted to the packed format, rate and
+            // channels output would negotiate with it. Returns nullptr if output only
+            // takes planar audio or the clip would be larger than maxBytes. source is
+            // left disconnected and rewound.
+            static std::shared_ptr<const PcmClip> decode(const std::shared_ptr<FFSource>& source,
+                                                         const std::shared_ptr<IAudioSink>& output,
+                                                         uint64_t maxBytes);
+
+            /* <ITrackSource> */
+            int getPacket(FFFrame* frame) override;
+            int64_t seek(uint64_t timeMs) override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
+            [[nodiscard]] const std::string& getFileName() const override;
+            /* </ITrackSource> */
+
+            /* <IAudioNode> */
+            SampleFormatFlags getSupportedSampleFormats() override;
+            std::vector<uint32_t> getSupportedSampleRates() override;
+            uint8_t getSupportedChannels() override;
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+        private:
+            // Played out in blocks about the size of a decoded frame, so seeks,
+            // pauses and volume changes land as promptly as they do for files
+            static constexpr uint64_t blockMs = 20;
+
+            std::shared_ptr<const PcmClip> _clip;
+            std::string _fileName;
+            std::shared_ptr<PipelineStats> _stats;
+            uint64_t _blockFrames;
+            uint64_t _position = 0;
+            // Downstream nodes may scale audio in place, so each block is copied out
+            // of the shared clip first
+            std::vector<uint8_t> _block;
+    };
+}
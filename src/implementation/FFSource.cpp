@@ -1,21 +1,269 @@
 #include "FFSource.h"
 #include "ScopedPacketUnref.h"
+#include "ScopedStageTimer.h"
+#include "PipelineStats.h"
+#include "ClipCache.h"
+#include "SeekIndex.h"
 
 #include <implementation/FFFrame.h>
 #include <interfaces/IAudioSink.h>
+#include <interfaces/IByteReader.h>
 #include <exceptions/CommandException.h>
 #include <exceptions/PlayerException.h>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <cassert>
 
 namespace CasperTech
 {
     void CasperTech::FFSource::load(const std::string& fileName)
     {
-        checkError(avformat_open_input(&_fmtCtx, fileName.c_str(), nullptr, nullptr));
-        checkError(avformat_find_stream_info(_fmtCtx, nullptr));
+        _fileName = fileName;
+        openInput(fileName.c_str());
+        openStream();
+        if (!_lazyDecoder)
+        {
+            prepareDecoder();
+        }
+        if (_indexedSeek)
+        {
+            _indexKey = ClipCache::keyFor(fileName);
+            restoreIndex();
+        }
+    }
+
+    void FFSource::load(const std::shared_ptr<IByteReader>& reader, const std::string& fileName)
+    {
+        _fileName = fileName;
+        {
+            std::unique_lock<std::mutex> lk(_readerMutex);
+            _reader = reader;
+            if (_interrupted)
+            {
+                _reader->interrupt();
+            }
+        }
+        auto* ioBuffer = static_cast<uint8_t*>(av_malloc(ioBufferSize));
+        if (ioBuffer == nullptr)
+        {
+            throw CommandException(CommandResult::LoadError, "Out of memory");
+        }
+        // The demuxer reads straight from the reader, which copies out of memory
+        // it doesn't own, so nothing is staged on disk first
+        _ioCtx = avio_alloc_context(ioBuffer, ioBufferSize, 0, _reader.get(), &FFSource::readInput,
+                                    nullptr, _reader->isSeekable() ? &FFSource::seekInput : nullptr);
+        if (_ioCtx == nullptr)
+        {
+            av_free(ioBuffer);
+            throw CommandException(CommandResult::LoadError, "Out of memory");
+        }
+        _ioCtx->seekable = _reader->isSeekable() ? AVIO_SEEKABLE_NORMAL : 0;
+
+        _fmtCtx = avformat_alloc_context();
+        if (_fmtCtx == nullptr)
+        {
+            throw CommandException(CommandResult::LoadError, "Out of memory");
+        }
+        _fmtCtx->pb = _ioCtx;
+        openInput(nullptr);
+        openStream();
+        if (!_lazyDecoder)
+        {
+            prepareDecoder();
+        }
+    }
+
+    void FFSource::setOpenOptions(const OpenOptions& options)
+    {
+        _openOptions = options;
+    }
+
+    void FFSource::setLazyDecoder(bool lazy)
+    {
+        _lazyDecoder = lazy;
+    }
 
+    void FFSource::prepareDecoder()
+    {
+        const int ret = openDecoder();
+        if (ret < 0)
+        {
+            throw CommandException(CommandResult::LoadError, "Couldn't open decoder: " + getError(ret));
+        }
+    }
+
+    // The demuxer for a file name's extension, or nullptr to probe for it
+    static AVInputFormat* formatForName(const std::string& fileName)
+    {
+        static const std::pair<const char*, const char*> formats[] = {
+            { "wav", "wav" },
+            { "mp3", "mp3" },
+            { "flac", "flac" },
+            { "ogg", "ogg" },
+            { "oga", "ogg" },
+            { "opus", "ogg" },
+            { "aac", "aac" },
+            { "m4a", "m4a" },
+            { "m4b", "m4a" },
+            { "mp4", "mp4" },
+        };
+        const size_t dot = fileName.find_last_of('.');
+        if (dot == std::string::npos)
+        {
+            return nullptr;
+        }
+        std::string extension = fileName.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        for(const auto& [ext, demuxer]: formats)
+        {
+            if (extension == ext)
+            {
+                return av_find_input_format(demuxer);
+            }
+        }
+        return nullptr;
+    }
+
+    void FFSource::openInput(const char* url)
+    {
+        // Only files can be opened a second time, from the start, if the name
+        // turns out to be wrong
+        AVInputFormat* format = url != nullptr && _openOptions.formatFromExtension ? formatForName(_fileName) : nullptr;
+        setDeadline(_openOptions.openTimeoutMs);
+        int ret = openFormat(url, format);
+        if (ret < 0 && format != nullptr && !_interrupted && !_timedOut)
+        {
+            ret = openFormat(url, nullptr);
+        }
+        checkOpenError(ret, "opening");
+        if (!_openOptions.skipStreamInfo || !describedByHeader())
+        {
+            probeStreams();
+        }
+        setDeadline(0);
+    }
+
+    int FFSource::openFormat(const char* url, AVInputFormat* format)
+    {
+        if (_fmtCtx == nullptr)
+        {
+            _fmtCtx = avformat_alloc_context();
+            if (_fmtCtx == nullptr)
+            {
+                throw CommandException(CommandResult::LoadError, "Out of memory");
+            }
+        }
+        // FFmpeg checks this between reads, and while it waits to retry one, so a
+        // stop or a newer load can abandon the open part way
+        _fmtCtx->interrupt_callback.callback = &FFSource::checkInterrupt;
+        _fmtCtx->interrupt_callback.opaque = this;
+        if (_openOptions.probeSize > 0)
+        {
+            // FFmpeg's floor
+            _fmtCtx->probesize = std::max<int64_t>(_openOptions.probeSize, 32);
+        }
+        if (_openOptions.analyzeDurationMs > 0)
+        {
+            _fmtCtx->max_analyze_duration = av_rescale(_openOptions.analyzeDurationMs, AV_TIME_BASE, 1000);
+        }
+        // Frees the context if it fails
+        return avformat_open_input(&_fmtCtx, url, format, nullptr);
+    }
+
+    void FFSource::probeStreams()
+    {
+        setDeadline(_openOptions.probeTimeoutMs);
+        checkOpenError(avformat_find_stream_info(_fmtCtx, nullptr), "probing");
+        setDeadline(0);
+    }
+
+    bool FFSource::describedByHeader() const
+    {
+        // Containers whose header carries the codec, rate and channels, where
+        // probing only confirms them. Elsewhere (MP3, ADTS) they come from the
+        // first frames.
+        static const char* const described[] = { "wav", "flac", "ogg", "mov,mp4,m4a,3gp,3g2,mj2" };
+        const char* name = _fmtCtx->iformat->name;
+        if (std::none_of(std::begin(described), std::end(described), [name](const char* d){ return std::strcmp(name, d) == 0; }))
+        {
+            return false;
+        }
+        for(uint32_t i = 0; i < _fmtCtx->nb_streams; i++)
+        {
+            const AVCodecParameters* par = _fmtCtx->streams[i]->codecpar;
+            if (par->codec_type == AVMEDIA_TYPE_AUDIO)
+            {
+                return par->codec_id != AV_CODEC_ID_NONE && par->sample_rate > 0 && par->channels > 0;
+            }
+        }
+        return false;
+    }
+
+    int FFSource::checkInterrupt(void* opaque)
+    {
+        auto* source = static_cast<FFSource*>(opaque);
+        if (source->_interrupted.load(std::memory_order_relaxed))
+        {
+            return 1;
+        }
+        const int64_t deadline = source->_deadlineNs.load(std::memory_order_relaxed);
+        if (deadline != 0 && std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() > deadline)
+        {
+            source->_timedOut = true;
+            return 1;
+        }
+        return 0;
+    }
+
+    void FFSource::setDeadline(uint32_t timeoutMs)
+    {
+        if (timeoutMs == 0)
+        {
+            _deadlineNs = 0;
+            return;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        _deadlineNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    }
+
+    void FFSource::checkOpenError(int errnum, const std::string& stage)
+    {
+        if (errnum >= 0)
+        {
+            return;
+        }
+        setDeadline(0);
+        if (_interrupted)
+        {
+            throw CommandException(CommandResult::LoadError, "Load cancelled");
+        }
+        if (_timedOut)
+        {
+            throw CommandException(CommandResult::LoadError, "Timed out " + stage + " " + _fileName);
+        }
+        checkError(errnum);
+    }
+
+    int FFSource::readInput(void* opaque, uint8_t* buffer, int size)
+    {
+        return static_cast<IByteReader*>(opaque)->read(buffer, size);
+    }
+
+    int64_t FFSource::seekInput(void* opaque, int64_t offset, int whence)
+    {
+        return static_cast<IByteReader*>(opaque)->seek(offset, whence);
+    }
+
+    void FFSource::openStream()
+    {
         for (uint32_t i = 0; i < _fmtCtx->nb_streams; i++)
         {
             AVStream* pStream = _fmtCtx->streams[i];
@@ -24,14 +272,25 @@ namespace CasperTech
                 _streamIndex = i;
 
                 _audioCodec = pStream->codecpar;
-                AVCodec* dec = avcodec_find_decoder(_audioCodec->codec_id);
-                if (dec == nullptr)
+                _decoder = avcodec_find_decoder(_audioCodec->codec_id);
+                if (_decoder == nullptr)
                 {
                     throw CommandException(CommandResult::LoadError, "No codec found to handle file");
                 }
-                _audioCtx = avcodec_alloc_context3(nullptr);
-                checkError(avcodec_parameters_to_context(_audioCtx, _audioCodec));
-                checkError(avcodec_open2(_audioCtx, dec, nullptr));
+                if (_audioCodec->format == AV_SAMPLE_FMT_NONE)
+                {
+                    // The streams weren't probed, so the decoder says what it
+                    // puts out, or failing that the streams are probed after all
+                    checkError(openDecoder());
+                    if (_audioCtx->sample_fmt == AV_SAMPLE_FMT_NONE)
+                    {
+                        probeStreams();
+                    }
+                    else
+                    {
+                        _audioCodec->format = _audioCtx->sample_fmt;
+                    }
+                }
                 _channels = _audioCodec->channels;
                 _sampleRate = _audioCodec->sample_rate;
 
@@ -45,16 +304,52 @@ namespace CasperTech
                     _packetInitialised = true;
                 }
                 _stream = pStream;
+                _startTime = pStream->start_time != AV_NOPTS_VALUE ? pStream->start_time : 0;
+                _indexedSeek = (_fmtCtx->iformat->flags & AVFMT_GENERIC_INDEX) != 0
+                               && _fmtCtx->iformat->read_timestamp == nullptr;
+                if (_pending == nullptr)
+                {
+                    _pending = av_frame_alloc();
+                    if (_pending == nullptr)
+                    {
+                        throw CommandException(CommandResult::LoadError, "Out of memory");
+                    }
+                }
                 return;
             }
         }
         throw CommandException(CommandResult::LoadError, "No audio stream in file");
     }
 
+    int FFSource::openDecoder()
+    {
+        if (_audioCtx != nullptr || _decoderError < 0)
+        {
+            return _decoderError;
+        }
+        _audioCtx = avcodec_alloc_context3(nullptr);
+        if (_audioCtx == nullptr)
+        {
+            _decoderError = AVERROR(ENOMEM);
+            return _decoderError;
+        }
+        int ret = avcodec_parameters_to_context(_audioCtx, _audioCodec);
+        if (ret >= 0)
+        {
+            ret = avcodec_open2(_audioCtx, _decoder, nullptr);
+        }
+        if (ret < 0)
+        {
+            avcodec_free_context(&_audioCtx);
+            _decoderError = ret;
+        }
+        return _decoderError;
+    }
+
     std::string CasperTech::FFSource::getError(int errnum)
     {
-        static char cstr[AV_ERROR_MAX_STRING_SIZE];
-        memset(cstr, 0, sizeof(cstr));
+        // On the stack, as it's called from control, open, play and read-ahead threads at once
+        char cstr[AV_ERROR_MAX_STRING_SIZE] = {};
         av_make_error_string(cstr, AV_ERROR_MAX_STRING_SIZE, errnum);
         return std::string(cstr);
     }
@@ -74,11 +369,42 @@ namespace CasperTech
             return -1;
         }
 
+        ScopedStageTimer timer(_stats ? &_stats->decode : nullptr);
+        const int decoderError = openDecoder();
+        if (decoderError < 0)
+        {
+            return decoderError;
+        }
+        if (_hasPending)
+        {
+            _hasPending = false;
+            int ret = deliver(_pending, _pendingSkip);
+            av_frame_unref(_pending);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            // Then whatever else the packet it came from decoded to
+            ret = receiveFrames(frame);
+            if (ret < 0 && ret != AVERROR(EAGAIN))
+            {
+                return ret;
+            }
+            return 1;
+        }
         int ret = av_read_frame(_fmtCtx, &_pkt);
         if (ret == AVERROR_EOF)
         {
-            avformat_seek_file(_fmtCtx, _streamIndex, 0, 0,  0, AVSEEK_FLAG_BYTE);
-            return 0;
+            // Drain the frames the decoder is still holding back. Without this the
+            // end of the track is cut short, and the padding trimmed from its last
+            // packet never takes effect, which leaves a gap before the next track.
+            ret = avcodec_send_packet(_audioCtx, nullptr);
+            if (ret >= 0)
+            {
+                ret = receiveFrames(frame);
+            }
+            rewind();
+            return ret < 0 && ret != AVERROR_EOF ? ret : 0;
         }
         if (ret < 0)
         {
@@ -99,35 +425,87 @@ namespace CasperTech
             {
                 return ret;
             }
-            while(ret >= 0)
+            ret = receiveFrames(frame);
+            if (ret == AVERROR_EOF)
             {
-                ret = avcodec_receive_frame(_audioCtx, frame->frame);
-                if (ret == AVERROR_EOF)
-                {
-                    avformat_seek_file(_fmtCtx, _streamIndex, 0, 0, 0, AVSEEK_FLAG_BYTE);
-                    return 0;
-                }
-                if (ret < 0)
-                {
-                    return ret;
-                }
+                rewind();
+                return 0;
+            }
+            if (ret < 0 && ret != AVERROR(EAGAIN))
+            {
+                return ret;
+            }
+        }
+        return 1;
+    }
 
-                // PROCESS AUDIO
-                if(_sink)
-                {
-                    _sink->audio(frame->frame->extended_data[0], frame->frame->extended_data[1], frame->frame->nb_samples);
-                }
-                else
-                {
-#ifdef _DEBUG
-                    std::cout << "No sink" << std::endl;
-#endif
-                }
+    int FFSource::receiveFrames(FFFrame* frame)
+    {
+        while(true)
+        {
+            // Encoder delay and padding signalled by the container (LAME/Xing
+            // headers, iTunes gapless info and edit lists, Opus pre-skip) are
+            // trimmed by libavcodec here
+            int ret = avcodec_receive_frame(_audioCtx, frame->frame);
+            if (ret < 0)
+            {
+                return ret;
+            }
 
-                av_frame_unref(frame->frame);
+            ret = deliver(frame->frame, 0);
+            av_frame_unref(frame->frame);
+            if (ret < 0)
+            {
+                return ret;
             }
         }
-        return 1;
+    }
+
+    int FFSource::deliver(AVFrame* frame, int skip)
+    {
+        const int count = frame->nb_samples - skip;
+        if (_stats)
+        {
+            _stats->frames.fetch_add(1, std::memory_order_relaxed);
+            _stats->samples.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // PROCESS AUDIO
+        if(_sink)
+        {
+            // Downstream nodes may process the frame in place. Decoders hand us
+            // frames we solely own, so this only copies in the unusual case
+            // the buffer is still shared.
+            int ret = av_frame_make_writable(frame);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            const auto format = static_cast<AVSampleFormat>(frame->format);
+            const int sampleBytes = av_get_bytes_per_sample(format);
+            const size_t offset = av_sample_fmt_is_planar(format)
+                    ? static_cast<size_t>(skip) * sampleBytes
+                    : static_cast<size_t>(skip) * sampleBytes * frame->channels;
+            uint8_t* planarChannel = frame->extended_data[1];
+            _sink->audio(frame->extended_data[0] + offset, planarChannel != nullptr ? planarChannel + offset : nullptr, count);
+        }
+        else
+        {
+#ifdef _DEBUG
+            std::cout << "No sink" << std::endl;
+#endif
+        }
+        return 0;
+    }
+
+    void FFSource::rewind()
+    {
+        // Back to the start, ready to play again. The decoder has to be flushed
+        // after draining before it will take packets again.
+        _hasPending = false;
+        av_frame_unref(_pending);
+        avcodec_flush_buffers(_audioCtx);
+        avformat_seek_file(_fmtCtx, _streamIndex, 0, 0, 0, AVSEEK_FLAG_BYTE);
     }
 
     SampleFormatFlags FFSource::getSupportedSampleFormats()
@@ -206,6 +584,8 @@ namespace CasperTech
 
     FFSource::~FFSource() noexcept
     {
+        saveIndex();
+        av_frame_free(&_pending);
         if (_packetInitialised)
         {
             av_packet_unref(&_pkt);
@@ -220,20 +600,231 @@ namespace CasperTech
             avformat_close_input(&_fmtCtx);
             _fmtCtx = nullptr;
         }
+        if (_ioCtx != nullptr)
+        {
+            // Custom IO is left for its owner to free. The demuxer may have
+            // swapped in a buffer of its own.
+            av_freep(&_ioCtx->buffer);
+            avio_context_free(&_ioCtx);
+        }
 
     }
 
-    void FFSource::seek(uint64_t timeMs)
+    int64_t FFSource::seek(uint64_t timeMs)
     {
         if (!_stream || !_fmtCtx)
+        {
+            return AVERROR(EINVAL);
+        }
+        const int decoderError = openDecoder();
+        if (decoderError < 0)
+        {
+            return decoderError;
+        }
+        const int64_t target = _startTime + av_rescale_q(static_cast<int64_t>(timeMs), AVRational{ 1, 1000 }, _stream->time_base);
+        if (_indexedSeek)
+        {
+            extendIndex(target);
+        }
+
+        // The last point at or before the target the decoder can start from, or
+        // failing that the first after it
+        int ret = avformat_seek_file(_fmtCtx, _streamIndex, INT64_MIN, target, target, 0);
+        if (ret < 0)
+        {
+            ret = avformat_seek_file(_fmtCtx, _streamIndex, INT64_MIN, target, INT64_MAX, 0);
+        }
+        if (ret < 0)
+        {
+            return ret;
+        }
+        _hasPending = false;
+        av_frame_unref(_pending);
+        // Otherwise it carries on from its state before the seek
+        avcodec_flush_buffers(_audioCtx);
+        return decodeTo(target);
+    }
+
+    int64_t FFSource::decodeTo(int64_t target)
+    {
+        const AVRational sampleBase{ 1, static_cast<int>(_sampleRate) };
+        while(true)
+        {
+            int ret = avcodec_receive_frame(_audioCtx, _pending);
+            if (ret == AVERROR(EAGAIN))
+            {
+                ret = av_read_frame(_fmtCtx, &_pkt);
+                if (ret < 0)
+                {
+                    // Past the end. What the decoder still holds is short of the
+                    // target, so it's drained and dropped, and the next getPacket()
+                    // finds the end of the track.
+                    avcodec_send_packet(_audioCtx, nullptr);
+                    while(avcodec_receive_frame(_audioCtx, _pending) >= 0)
+                    {
+                        av_frame_unref(_pending);
+                    }
+                    return ret == AVERROR_EOF ? static_cast<int64_t>(getDurationMs()) : ret;
+                }
+                ScopedPacketUnref pktScope(&_pkt);
+                if (_pkt.stream_index == _streamIndex)
+                {
+                    // A packet that can't be decoded without the ones before the
+                    // sync point only costs its samples, which are discarded anyway
+                    avcodec_send_packet(_audioCtx, &_pkt);
+                }
+                continue;
+            }
+            if (ret < 0)
+            {
+                return ret;
+            }
+
+            const int64_t pts = _pending->best_effort_timestamp;
+            if (pts == AV_NOPTS_VALUE)
+            {
+                // Nothing to measure the frame against, so play on from it
+                _pendingSkip = 0;
+                _hasPending = true;
+                return av_rescale_q(target - _startTime, _stream->time_base, AVRational{ 1, 1000 });
+            }
+            const int64_t skip = av_rescale_q(target - pts, _stream->time_base, sampleBase);
+            if (skip >= _pending->nb_samples)
+            {
+                av_frame_unref(_pending);
+                continue;
+            }
+            // Landing after the target means the demuxer couldn't get before it
+            _pendingSkip = skip > 0 ? static_cast<int>(skip) : 0;
+            _hasPending = true;
+            const int64_t landed = pts + av_rescale_q(_pendingSkip, sampleBase, _stream->time_base);
+            return std::max<int64_t>(av_rescale_q(landed - _startTime, _stream->time_base, AVRational{ 1, 1000 }), 0);
+        }
+    }
+
+    // The stream's seek index. The fields behind it were never public and are
+    // gone from later libavformat, which added these accessors in their place.
+    static int indexEntryCount(AVStream* stream)
+    {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+        return avformat_index_get_entries_count(stream);
+#else
+        return stream->nb_index_entries;
+#endif
+    }
+
+    static const AVIndexEntry* indexEntry(AVStream* stream, int index)
+    {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+        return avformat_index_get_entry(stream, index);
+#else
+        return index >= 0 && index < stream->nb_index_entries ? &stream->index_entries[index] : nullptr;
+#endif
+    }
+
+    void FFSource::extendIndex(int64_t target)
+    {
+        const int entries = indexEntryCount(_stream);
+        if (_indexComplete || (entries > 0 && indexEntry(_stream, entries - 1)->timestamp >= target))
+        {
+            return;
+        }
+        // Read on from the furthest packet indexed so far until the target is
+        // covered. Demuxing costs little next to decoding, and every packet read is
+        // indexed on the way, so this is paid once per stretch of the file.
+        const int64_t from = entries > 0 ? indexEntry(_stream, entries - 1)->timestamp : _startTime;
+        if (avformat_seek_file(_fmtCtx, _streamIndex, INT64_MIN, from, from, 0) < 0)
+        {
+            return;
+        }
+        while(true)
+        {
+            const int ret = av_read_frame(_fmtCtx, &_pkt);
+            if (ret == AVERROR_EOF)
+            {
+                _indexComplete = true;
+                return;
+            }
+            if (ret < 0)
+            {
+                return;
+            }
+            ScopedPacketUnref pktScope(&_pkt);
+            if (_pkt.stream_index == _streamIndex && _pkt.dts != AV_NOPTS_VALUE && _pkt.dts >= target)
+            {
+                return;
+            }
+        }
+    }
+
+    void FFSource::restoreIndex()
+    {
+        if (_indexKey.empty())
         {
             return;
         }
-        double timeBase = av_q2d(_stream->time_base);
+        auto index = SeekIndexCache::shared().find(_indexKey);
+        if (index)
+        {
+            for(const auto& point: index->points)
+            {
+                av_add_index_entry(_stream, point.pos, point.timestamp, point.size, point.minDistance, AVINDEX_KEYFRAME);
+            }
+            _indexComplete = index->complete;
+        }
+        _restoredPoints = indexEntryCount(_stream);
+        _restoredComplete = _indexComplete;
+    }
 
-        auto ts = static_cast<int64_t>(timeMs / (timeBase * 1000));
+    void FFSource::saveIndex()
+    {
+        if (_indexKey.empty() || _stream == nullptr)
+        {
+            return;
+        }
+        const int entries = indexEntryCount(_stream);
+        if (entries == _restoredPoints && _indexComplete == _restoredComplete)
+        {
+            return;
+        }
+        auto index = std::make_shared<SeekIndex>();
+        index->complete = _indexComplete;
+        index->points.reserve(entries);
+        for(int i = 0; i < entries; i++)
+        {
+            const AVIndexEntry* entry = indexEntry(_stream, i);
+            index->points.push_back({ entry->pos, entry->timestamp, entry->size, entry->min_distance });
+        }
+        SeekIndexCache::shared().insert(_indexKey, std::move(index));
+    }
+
+    void FFSource::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        _stats = stats;
+    }
 
-        avformat_seek_file(_fmtCtx, _streamIndex, ts, ts,  ts, 0);
+    uint64_t FFSource::getDurationMs() const
+    {
+        if (_fmtCtx == nullptr || _fmtCtx->duration == AV_NOPTS_VALUE || _fmtCtx->duration < 0)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(av_rescale(_fmtCtx->duration, 1000, AV_TIME_BASE));
+    }
+
+    const std::string& FFSource::getFileName() const
+    {
+        return _fileName;
+    }
+
+    void FFSource::interrupt()
+    {
+        _interrupted = true;
+        std::unique_lock<std::mutex> lk(_readerMutex);
+        if (_reader)
+        {
+            _reader->interrupt();
+        }
     }
 
     std::string FFSource::getName() const
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <interfaces/IAudioSource.h>
+#include <interfaces/ITrackSource.h>
+#include <structs/OpenOptions.h>
 
 extern "C" {
     #include <libavformat/avformat.h>
@@ -13,16 +17,40 @@ extern "C" {
 
 namespace CasperTech
 {
-    struct FFFrame;
-    class FFSource: public IAudioSource
+    class IByteReader;
+    class FFSource: public ITrackSource
     {
         public:
             static std::string getError(int errnum);
             FFSource();
             ~FFSource() noexcept override;
             void load(const std::string& fileName);
-            void seek(uint64_t timeMs);
-            int getPacket(FFFrame * frame);
+            // Reads the file through reader rather than from disk. fileName only names it.
+            void load(const std::shared_ptr<IByteReader>& reader, const std::string& fileName);
+            // For the next load()
+            void setOpenOptions(const OpenOptions& options);
+            // For the next load(). Leaves opening the decoder to the first getPacket()
+            // or seek(), so a load that's never played doesn't pay for it, but a
+            // codec that can't be opened fails there rather than in load().
+            void setLazyDecoder(bool lazy);
+            // Opens the decoder now if it isn't already, throwing a LoadError if it
+            // can't be
+            void prepareDecoder();
+            // Length of the file as the container reports it, 0 if it doesn't know
+            [[nodiscard]] uint64_t getDurationMs() const;
+
+            /* <ITrackSource> */
+            // Decodes the next packet into the sink. At the end of the file the
+            // decoder is drained before rewinding.
+            int getPacket(FFFrame * frame) override;
+            // Lands on the exact sample: seeks to the sync point before it, then
+            // decodes and discards up to it
+            int64_t seek(uint64_t timeMs) override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
+            [[nodiscard]] const std::string& getFileName() const override;
+            // Also stops a load() in progress on another thread, which throws
+            void interrupt() override;
+            /* </ITrackSource> */
 
             /* <IAudioNode> */
             SampleFormatFlags getSupportedSampleFormats() override;
@@ -33,13 +61,38 @@ namespace CasperTech
 
         private:
             static void checkError(int errnum);
+            static int readInput(void* opaque, uint8_t* buffer, int size);
+            static int64_t seekInput(void* opaque, int64_t offset, int whence);
+            // AVIOInterruptCB: nonzero stops whatever FFmpeg is waiting on
+            static int checkInterrupt(void* opaque);
+            void setDeadline(uint32_t timeoutMs);
+            void checkOpenError(int errnum, const std::string& stage);
+            void openInput(const char* url);
+            int openFormat(const char* url, AVInputFormat* format);
+            void probeStreams();
+            [[nodiscard]] bool describedByHeader() const;
+            void openStream();
+            // By load(), or with a lazy decoder by the first getPacket() or seek()
+            int openDecoder();
+            int receiveFrames(FFFrame* frame);
+            int deliver(AVFrame* frame, int skip);
+            void rewind();
+            int64_t decodeTo(int64_t target);
+            void extendIndex(int64_t target);
+            void restoreIndex();
+            void saveIndex();
 
+            std::shared_ptr<PipelineStats> _stats;
             AVFormatContext* _fmtCtx = nullptr;
             AVCodecContext* _audioCtx = nullptr;
             AVPacket _pkt = {};
 
 
             AVCodecParameters* _audioCodec = nullptr;
+            AVCodec* _decoder = nullptr;
+            // Set if opening the decoder failed, which every later call returns
+            int _decoderError = 0;
+            bool _lazyDecoder = false;
             AVStream* _stream = nullptr;
             bool _packetInitialised = false;
 
@@ -47,6 +100,37 @@ namespace CasperTech
             uint32_t _channels = 0;
             uint32_t _sampleRate = 0;
             float _volume = 1.0;
+            std::string _fileName;
+            // Stream timestamp of the start of the track
+            int64_t _startTime = 0;
+
+            // The first frame after a seek, with the samples before the target still
+            // to be skipped, passed on by the next getPacket()
+            AVFrame* _pending = nullptr;
+            int _pendingSkip = 0;
+            bool _hasPending = false;
+
+            // Demuxers that can only estimate where a time is in the file index the
+            // packets they read instead. The index is kept in SeekIndexCache for the
+            // next time the file is loaded.
+            bool _indexedSeek = false;
+            bool _indexComplete = false;
+            std::string _indexKey;
+            int _restoredPoints = 0;
+            bool _restoredComplete = false;
+
+            // Custom input, used in place of a file when set
+            static constexpr int ioBufferSize = 32 * 1024;
+            std::shared_ptr<IByteReader> _reader;
+            AVIOContext* _ioCtx = nullptr;
+            // Guards _reader against interrupt() from another thread
+            std::mutex _readerMutex;
+
+            std::atomic<bool> _interrupted{ false };
+            // steady_clock time the current stage of opening gives up at, 0 for none
+            std::atomic<int64_t> _deadlineNs{ 0 };
+            std::atomic<bool> _timedOut{ false };
+            OpenOptions _openOptions;
     };
 }
 
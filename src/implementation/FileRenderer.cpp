@@ -0,0 +1,120 @@
+#include "FileRenderer.h"
+
+#include <exceptions/AudioException.h>
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+namespace CasperTech
+{
+    FileRenderer::FileRenderer(std::string fileName, ClockMode clockMode)
+        : NullRenderer(clockMode)
+        , _fileName(std::move(fileName))
+    {
+        std::string lower = _fileName;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+        {
+            return std::tolower(c);
+        });
+        _wav = lower.size() >= 4 && lower.compare(lower.size() - 4, 4, ".wav") == 0;
+    }
+
+    std::string FileRenderer::getName() const
+    {
+        return "FileRenderer";
+    }
+
+    void FileRenderer::onStreamStart()
+    {
+        if (_file.is_open())
+        {
+            onStreamEnd();
+            _file.close();
+        }
+        _file.open(_fileName, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!_file.is_open())
+        {
+            throw AudioException(AudioError::PipelineError, "Unable to open " + _fileName + " for writing");
+        }
+        _dataBytes = 0;
+        if (_wav)
+        {
+            writeWavHeader();
+        }
+    }
+
+    void FileRenderer::onStreamData(const uint8_t* buffer, uint64_t bytes)
+    {
+        _file.write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(bytes));
+        _dataBytes += bytes;
+    }
+
+    void FileRenderer::onStreamEnd()
+    {
+        if (!_file.is_open())
+        {
+            return;
+        }
+        if (_wav)
+        {
+            // Rewrite the header now the data size (and the frame count in the
+            // fact chunk) is known, then carry on appending in case the source is
+            // played again.
+            auto pos = _file.tellp();
+            _file.seekp(0);
+            writeWavHeader();
+            _file.seekp(pos);
+        }
+        _file.flush();
+    }
+
+    void FileRenderer::writeWavHeader()
+    {
+        auto put16 = [this](uint16_t v)
+        {
+            const char b[2] = { static_cast<char>(v & 0xFF), static_cast<char>(v >> 8) };
+            _file.write(b, 2);
+        };
+        auto put32 = [&put16](uint32_t v)
+        {
+            put16(static_cast<uint16_t>(v & 0xFFFF));
+            put16(static_cast<uint16_t>(v >> 16));
+        };
+
+        // Float data needs the extended fmt chunk (with cbSize) and a fact chunk
+        // holding the frame count, or strict readers reject the file
+        const bool isFloat = _sourceFormat == SampleFormatFlags::FLT || _sourceFormat == SampleFormatFlags::DBL;
+        const uint32_t fmtBytes = isFloat ? 18 : 16;
+        const uint32_t factBytes = isFloat ? 12 : 0;
+        const uint32_t headerBytes = 4 + 8 + fmtBytes + factBytes + 8;
+        const auto dataBytes = static_cast<uint32_t>(std::min<uint64_t>(_dataBytes, UINT32_MAX - headerBytes));
+        const uint16_t blockAlign = _sampleSize * _sourceChannels;
+
+        _file.write("RIFF", 4);
+        put32(headerBytes + dataBytes);
+        _file.write("WAVE", 4);
+        _file.write("fmt ", 4);
+        put32(fmtBytes);
+        put16(isFloat ? 3 : 1);
+        put16(_sourceChannels);
+        put32(_sourceSampleRate);
+        put32(_sourceSampleRate * blockAlign);
+        put16(blockAlign);
+        put16(_sampleSize * 8);
+        if (isFloat)
+        {
+            put16(0);
+            _file.write("fact", 4);
+            put32(4);
+            put32(blockAlign != 0 ? dataBytes / blockAlign : 0);
+        }
+        _file.write("data", 4);
+        put32(dataBytes);
+    }
+
+    FileRenderer::~FileRenderer()
+    {
+        onStreamEnd();
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "NullRenderer.h"
+
+#include <fstream>
+
+namespace CasperTech
+{
+    // Headless renderer which writes the negotiated PCM to disk, as a WAV file if the
+    // file name ends in .wav and as raw interleaved samples otherwise. Each time a
+    // source is configured the file is truncated, so it holds the last loaded track.
+    class FileRenderer: public NullRenderer
+    {
+        public:
+            FileRenderer(std::string fileName, ClockMode clockMode);
+            ~FileRenderer() override;
+
+            /* <IAudioNode> */
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+        protected:
+            void onStreamStart() override;
+            void onStreamData(const uint8_t* buffer, uint64_t bytes) override;
+            void onStreamEnd() override;
+
+        private:
+            void writeWavHeader();
+
+            std::string _fileName;
+            std::ofstream _file;
+            bool _wav = false;
+            uint64_t _dataBytes = 0;
+    };
+}
@@ -0,0 +1,80 @@
+#include "FramePool.h"
+
+#include <enums/AudioError.h>
+#include <exceptions/AudioException.h>
+
+extern "C" {
+    #include <libavutil/channel_layout.h>
+}
+
+namespace CasperTech
+{
+    FramePool::~FramePool()
+    {
+        clear();
+    }
+
+    void FramePool::configure(AVSampleFormat format, uint8_t channels, uint32_t sampleRate)
+    {
+        clear();
+        _format = format;
+        _channels = channels;
+        _sampleRate = sampleRate;
+    }
+
+    AVFrame* FramePool::acquire(int sampleCount)
+    {
+        if (sampleCount > _capacity)
+        {
+            // Every buffer is reallocated at the new size, with some headroom as
+            // decoders vary their frame lengths a little
+            clear();
+            _capacity = sampleCount + sampleCount / 4;
+        }
+
+        for(AVFrame* frame: _frames)
+        {
+            if (av_frame_is_writable(frame))
+            {
+                frame->nb_samples = sampleCount;
+                return frame;
+            }
+        }
+
+        AVFrame* frame = allocate(_capacity);
+        _frames.push_back(frame);
+        frame->nb_samples = sampleCount;
+        return frame;
+    }
+
+    AVFrame* FramePool::allocate(int sampleCount)
+    {
+        AVFrame* frame = av_frame_alloc();
+        if (frame == nullptr)
+        {
+            throw AudioException(AudioError::PipelineError, "Unable to allocate frame");
+        }
+        frame->format = _format;
+        frame->channels = _channels;
+        frame->channel_layout = av_get_default_channel_layout(_channels);
+        frame->sample_rate = static_cast<int>(_sampleRate);
+        frame->nb_samples = sampleCount;
+        if (av_frame_get_buffer(frame, 0) < 0)
+        {
+            av_frame_free(&frame);
+            throw AudioException(AudioError::PipelineError, "Unable to allocate frame buffer");
+        }
+        return frame;
+    }
+
+    void FramePool::clear()
+    {
+        // Frames still referenced elsewhere keep their buffers alive until released
+        for(AVFrame*& frame: _frames)
+        {
+            av_frame_free(&frame);
+        }
+        _frames.clear();
+        _capacity = 0;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+extern "C" {
+    #include <libavutil/frame.h>
+    #include <libavutil/samplefmt.h>
+}
+
+#include <cstdint>
+#include <vector>
+
+namespace CasperTech
+{
+    // Hands out AVFrames for one negotiated format whose sample buffers are reused.
+    // A frame goes back into circulation once every reference handed to FFmpeg
+    // has been released, so callers pass frames on with a reference of their own
+    // (e.g. AV_BUFFERSRC_FLAG_KEEP_REF) and never unref them. Frames and buffers
+    // are only allocated while the pool warms up, or when a longer frame than any
+    // so far arrives.
+    class FramePool
+    {
+        public:
+            FramePool() = default;
+            ~FramePool();
+
+            FramePool(const FramePool&) = delete;
+            FramePool& operator=(const FramePool&) = delete;
+
+            // Drops every frame; the pool is sized again from the next acquire()
+            void configure(AVSampleFormat format, uint8_t channels, uint32_t sampleRate);
+
+            // A writable frame of sampleCount samples. Throws AudioException if one
+            // can't be allocated.
+            AVFrame* acquire(int sampleCount);
+
+        private:
+            AVFrame* allocate(int sampleCount);
+            void clear();
+
+            std::vector<AVFrame*> _frames;
+            AVSampleFormat _format = AV_SAMPLE_FMT_NONE;
+            uint8_t _channels = 0;
+            uint32_t _sampleRate = 0;
+            int _capacity = 0;
+    };
+}
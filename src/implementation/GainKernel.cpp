@@ -0,0 +1,712 @@
+#include "GainKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define GAIN_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GAIN_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(GAIN_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GAIN_KERNEL_AVX2 __attribute__((target("avx2")))
+#else
+#define GAIN_KERNEL_AVX2
+#endif
+
+namespace CasperTech
+{
+    // The kernels step the gain incrementally, in float for float and 16 bit
+    // samples. Restarting from the exact ramp position every so often keeps the
+    // accumulated rounding error far below anything audible.
+    static constexpr size_t rampRunFrames = 1024;
+
+    double GainRamp::at(uint64_t frame) const
+    {
+        if (exponential)
+        {
+            return start * std::pow(step, static_cast<double>(frame));
+        }
+        return start + step * static_cast<double>(frame);
+    }
+
+    bool GainRamp::isUnity() const
+    {
+        return start == 1.0 && step == (exponential ? 1.0 : 0.0);
+    }
+
+    template<typename T, typename S>
+    static T scaleSample(T sample, S gain)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return sample * gain;
+        }
+        else
+        {
+            const S lo = static_cast<S>(std::numeric_limits<T>::min());
+            const S hi = static_cast<S>(std::numeric_limits<T>::max());
+            return static_cast<T>(std::clamp(std::nearbyint(static_cast<S>(sample) * gain), lo, hi));
+        }
+    }
+
+    // Finishes whatever the vector kernel left, which is always a whole number of
+    // frames in. S is the precision the gain is applied in.
+    template<typename S, typename T>
+    static void scaleScalar(T* data, size_t count, size_t done, uint32_t channels, const GainRamp& ramp)
+    {
+        S gain = static_cast<S>(ramp.at(done / channels));
+        const S step = static_cast<S>(ramp.step);
+        for(size_t i = done; i < count; i += channels)
+        {
+            for(size_t c = 0; c < channels && i + c < count; c++)
+            {
+                data[i + c] = scaleSample(data[i + c], gain);
+            }
+            gain = ramp.exponential ? gain * step : gain + step;
+        }
+    }
+
+    static void mixScalar(float* out, const float* in, size_t count, size_t done, uint32_t channels, const GainRamp& ramp)
+    {
+        float gain = static_cast<float>(ramp.at(done / channels));
+        const auto step = static_cast<float>(ramp.step);
+        for(size_t i = done; i < count; i += channels)
+        {
+            for(size_t c = 0; c < channels && i + c < count; c++)
+            {
+                out[i + c] += in[i + c] * gain;
+            }
+            gain = ramp.exponential ? gain * step : gain + step;
+        }
+    }
+
+    // Starting gains for each lane of a vector of Width samples, and the amount to
+    // advance them by per vector. Only valid when whole frames fit in a vector.
+    template<typename S, size_t Width>
+    static void rampLanes(const GainRamp& ramp, uint32_t channels, S (&lanes)[Width], S& increment)
+    {
+        for(size_t j = 0; j < Width; j++)
+        {
+            lanes[j] = static_cast<S>(ramp.at(j / channels));
+        }
+        const auto frames = static_cast<double>(Width / channels);
+        increment = static_cast<S>(ramp.exponential ? std::pow(ramp.step, frames) : ramp.step * frames);
+    }
+
+#if defined(GAIN_KERNEL_X86)
+    static bool cpuHasAvx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    static const bool hasAvx2 = cpuHasAvx2();
+
+    // Per lane gains, one vector at a time. Kept as separate small types rather than
+    // a template so the AVX2 ones can carry the target attribute.
+    struct Sse2FloatGains
+    {
+        Sse2FloatGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            float lanes[4];
+            float increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = _mm_loadu_ps(lanes);
+            step = _mm_set1_ps(increment);
+        }
+
+        __m128 next()
+        {
+            const __m128 gain = current;
+            current = exponential ? _mm_mul_ps(current, step) : _mm_add_ps(current, step);
+            return gain;
+        }
+
+        __m128 current;
+        __m128 step;
+        bool exponential;
+    };
+
+    struct Sse2DoubleGains
+    {
+        Sse2DoubleGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            double lanes[2];
+            double increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = _mm_loadu_pd(lanes);
+            step = _mm_set1_pd(increment);
+        }
+
+        __m128d next()
+        {
+            const __m128d gain = current;
+            current = exponential ? _mm_mul_pd(current, step) : _mm_add_pd(current, step);
+            return gain;
+        }
+
+        __m128d current;
+        __m128d step;
+        bool exponential;
+    };
+
+    struct Avx2FloatGains
+    {
+        GAIN_KERNEL_AVX2 Avx2FloatGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            float lanes[8];
+            float increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = _mm256_loadu_ps(lanes);
+            step = _mm256_set1_ps(increment);
+        }
+
+        GAIN_KERNEL_AVX2 __m256 next()
+        {
+            const __m256 gain = current;
+            current = exponential ? _mm256_mul_ps(current, step) : _mm256_add_ps(current, step);
+            return gain;
+        }
+
+        __m256 current;
+        __m256 step;
+        bool exponential;
+    };
+
+    struct Avx2DoubleGains
+    {
+        GAIN_KERNEL_AVX2 Avx2DoubleGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            double lanes[4];
+            double increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = _mm256_loadu_pd(lanes);
+            step = _mm256_set1_pd(increment);
+        }
+
+        GAIN_KERNEL_AVX2 __m256d next()
+        {
+            const __m256d gain = current;
+            current = exponential ? _mm256_mul_pd(current, step) : _mm256_add_pd(current, step);
+            return gain;
+        }
+
+        __m256d current;
+        __m256d step;
+        bool exponential;
+    };
+
+    // Each kernel handles whole vectors and returns how many samples it did; the
+    // caller finishes the remainder with the scalar loop. A kernel does nothing if
+    // a frame doesn't divide its gain vector.
+
+    static size_t scaleFltSse2(float* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        Sse2FloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    static size_t mixFltSse2(float* out, const float* in, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        Sse2FloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), gains.next())));
+        }
+        return i;
+    }
+
+    static size_t scaleDblSse2(double* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (2 % channels != 0)
+        {
+            return 0;
+        }
+        Sse2DoubleGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 2 <= count; i += 2)
+        {
+            _mm_storeu_pd(data + i, _mm_mul_pd(_mm_loadu_pd(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    static size_t scaleS16Sse2(int16_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        Sse2FloatGains gains(ramp, channels);
+        const __m128 lo = _mm_set1_ps(-32768.0f);
+        const __m128 hi = _mm_set1_ps(32767.0f);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            // Sign extend each half to 32 bits
+            __m128 a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+            __m128 b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+            a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(a, gains.next()), lo), hi);
+            b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(b, gains.next()), lo), hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+        return i;
+    }
+
+    static size_t scaleS32Sse2(int32_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (2 % channels != 0)
+        {
+            return 0;
+        }
+        // Doubles hold every int32 exactly, floats would lose the low bits
+        Sse2DoubleGains gains(ramp, channels);
+        const __m128d lo = _mm_set1_pd(-2147483648.0);
+        const __m128d hi = _mm_set1_pd(2147483647.0);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128d a = _mm_cvtepi32_pd(v);
+            __m128d b = _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+            a = _mm_min_pd(_mm_max_pd(_mm_mul_pd(a, gains.next()), lo), hi);
+            b = _mm_min_pd(_mm_max_pd(_mm_mul_pd(b, gains.next()), lo), hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b)));
+        }
+        return i;
+    }
+
+    GAIN_KERNEL_AVX2 static size_t scaleFltAvx2(float* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (8 % channels != 0)
+        {
+            return 0;
+        }
+        Avx2FloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    GAIN_KERNEL_AVX2 static size_t mixFltAvx2(float* out, const float* in, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (8 % channels != 0)
+        {
+            return 0;
+        }
+        Avx2FloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), gains.next())));
+        }
+        return i;
+    }
+
+    GAIN_KERNEL_AVX2 static size_t scaleDblAvx2(double* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        Avx2DoubleGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    GAIN_KERNEL_AVX2 static size_t scaleS16Avx2(int16_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (8 % channels != 0)
+        {
+            return 0;
+        }
+        Avx2FloatGains gains(ramp, channels);
+        const __m256 lo = _mm256_set1_ps(-32768.0f);
+        const __m256 hi = _mm256_set1_ps(32767.0f);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)));
+            __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)));
+            a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, gains.next()), lo), hi);
+            b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, gains.next()), lo), hi);
+            // packs works per 128 bit lane, so put the 64 bit quarters back in order
+            const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        return i;
+    }
+
+    GAIN_KERNEL_AVX2 static size_t scaleS32Avx2(int32_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        Avx2DoubleGains gains(ramp, channels);
+        const __m256d lo = _mm256_set1_pd(-2147483648.0);
+        const __m256d hi = _mm256_set1_pd(2147483647.0);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256d a = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+            __m256d b = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+            a = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(a, gains.next()), lo), hi);
+            b = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(b, gains.next()), lo), hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm256_cvtpd_epi32(a));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i + 4), _mm256_cvtpd_epi32(b));
+        }
+        return i;
+    }
+#elif defined(GAIN_KERNEL_NEON)
+    struct NeonFloatGains
+    {
+        NeonFloatGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            float lanes[4];
+            float increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = vld1q_f32(lanes);
+            step = vdupq_n_f32(increment);
+        }
+
+        float32x4_t next()
+        {
+            const float32x4_t gain = current;
+            current = exponential ? vmulq_f32(current, step) : vaddq_f32(current, step);
+            return gain;
+        }
+
+        float32x4_t current;
+        float32x4_t step;
+        bool exponential;
+    };
+
+    static size_t scaleFltNeon(float* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        NeonFloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            vst1q_f32(data + i, vmulq_f32(vld1q_f32(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    static size_t mixFltNeon(float* out, const float* in, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        NeonFloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(in + i), gains.next()));
+        }
+        return i;
+    }
+
+#if defined(__aarch64__)
+    // Round to nearest conversions and 64 bit lanes only exist on AArch64; 32 bit
+    // ARM keeps the float kernel and uses the scalar loop for the rest.
+    struct NeonDoubleGains
+    {
+        NeonDoubleGains(const GainRamp& ramp, uint32_t channels)
+            : exponential(ramp.exponential)
+        {
+            double lanes[2];
+            double increment;
+            rampLanes(ramp, channels, lanes, increment);
+            current = vld1q_f64(lanes);
+            step = vdupq_n_f64(increment);
+        }
+
+        float64x2_t next()
+        {
+            const float64x2_t gain = current;
+            current = exponential ? vmulq_f64(current, step) : vaddq_f64(current, step);
+            return gain;
+        }
+
+        float64x2_t current;
+        float64x2_t step;
+        bool exponential;
+    };
+
+    static size_t scaleDblNeon(double* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (2 % channels != 0)
+        {
+            return 0;
+        }
+        NeonDoubleGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 2 <= count; i += 2)
+        {
+            vst1q_f64(data + i, vmulq_f64(vld1q_f64(data + i), gains.next()));
+        }
+        return i;
+    }
+
+    static size_t scaleS16Neon(int16_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (4 % channels != 0)
+        {
+            return 0;
+        }
+        NeonFloatGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            const int16x8_t v = vld1q_s16(data + i);
+            const float32x4_t a = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), gains.next());
+            const float32x4_t b = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), gains.next());
+            // The conversions and narrowing both saturate
+            vst1q_s16(data + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+        }
+        return i;
+    }
+
+    static size_t scaleS32Neon(int32_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        if (2 % channels != 0)
+        {
+            return 0;
+        }
+        NeonDoubleGains gains(ramp, channels);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            const int32x4_t v = vld1q_s32(data + i);
+            const float64x2_t a = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(v))), gains.next());
+            const float64x2_t b = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_high_s32(v))), gains.next());
+            vst1q_s32(data + i, vcombine_s32(vqmovn_s64(vcvtnq_s64_f64(a)), vqmovn_s64(vcvtnq_s64_f64(b))));
+        }
+        return i;
+    }
+#endif
+#endif
+
+    static void scaleFlt(float* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        size_t done = 0;
+#if defined(GAIN_KERNEL_X86)
+        done = hasAvx2 ? scaleFltAvx2(data, count, channels, ramp) : scaleFltSse2(data, count, channels, ramp);
+#elif defined(GAIN_KERNEL_NEON)
+        done = scaleFltNeon(data, count, channels, ramp);
+#endif
+        scaleScalar<float>(data, count, done, channels, ramp);
+    }
+
+    static void mixFlt(float* out, const float* in, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        size_t done = 0;
+#if defined(GAIN_KERNEL_X86)
+        done = hasAvx2 ? mixFltAvx2(out, in, count, channels, ramp) : mixFltSse2(out, in, count, channels, ramp);
+#elif defined(GAIN_KERNEL_NEON)
+        done = mixFltNeon(out, in, count, channels, ramp);
+#endif
+        mixScalar(out, in, count, done, channels, ramp);
+    }
+
+    static void scaleDbl(double* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        size_t done = 0;
+#if defined(GAIN_KERNEL_X86)
+        done = hasAvx2 ? scaleDblAvx2(data, count, channels, ramp) : scaleDblSse2(data, count, channels, ramp);
+#elif defined(GAIN_KERNEL_NEON) && defined(__aarch64__)
+        done = scaleDblNeon(data, count, channels, ramp);
+#endif
+        scaleScalar<double>(data, count, done, channels, ramp);
+    }
+
+    static void scaleS16(int16_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        size_t done = 0;
+#if defined(GAIN_KERNEL_X86)
+        done = hasAvx2 ? scaleS16Avx2(data, count, channels, ramp) : scaleS16Sse2(data, count, channels, ramp);
+#elif defined(GAIN_KERNEL_NEON) && defined(__aarch64__)
+        done = scaleS16Neon(data, count, channels, ramp);
+#endif
+        scaleScalar<float>(data, count, done, channels, ramp);
+    }
+
+    static void scaleS32(int32_t* data, size_t count, uint32_t channels, const GainRamp& ramp)
+    {
+        size_t done = 0;
+#if defined(GAIN_KERNEL_X86)
+        done = hasAvx2 ? scaleS32Avx2(data, count, channels, ramp) : scaleS32Sse2(data, count, channels, ramp);
+#elif defined(GAIN_KERNEL_NEON) && defined(__aarch64__)
+        done = scaleS32Neon(data, count, channels, ramp);
+#endif
+        scaleScalar<double>(data, count, done, channels, ramp);
+    }
+
+    bool GainKernel::supports(SampleFormatFlags format)
+    {
+        switch(format)
+        {
+            case SampleFormatFlags::S16:
+            case SampleFormatFlags::S16_Planar:
+            case SampleFormatFlags::S32:
+            case SampleFormatFlags::S32_Planar:
+            case SampleFormatFlags::FLT:
+            case SampleFormatFlags::FLT_Planar:
+            case SampleFormatFlags::DBL:
+            case SampleFormatFlags::DBL_Planar:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool GainKernel::isPlanar(SampleFormatFlags format)
+    {
+        switch(format)
+        {
+            case SampleFormatFlags::U8_Planar:
+            case SampleFormatFlags::S8_Planar:
+            case SampleFormatFlags::S16_Planar:
+            case SampleFormatFlags::S24_Planar:
+            case SampleFormatFlags::S32_Planar:
+            case SampleFormatFlags::FLT_Planar:
+            case SampleFormatFlags::DBL_Planar:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void GainKernel::apply(SampleFormatFlags format, uint8_t* data, size_t count, float gain)
+    {
+        GainRamp constant;
+        constant.start = gain;
+        applyRamp(format, data, count, 1, constant);
+    }
+
+    void GainKernel::applyRamp(SampleFormatFlags format, uint8_t* data, size_t frames, uint32_t channels, const GainRamp& ramp)
+    {
+        if (channels == 0)
+        {
+            return;
+        }
+
+        for(size_t frame = 0; frame < frames; frame += rampRunFrames)
+        {
+            GainRamp run = ramp;
+            run.start = ramp.at(frame);
+            const size_t count = std::min(rampRunFrames, frames - frame) * channels;
+            const size_t offset = frame * channels;
+            switch(format)
+            {
+                case SampleFormatFlags::S16:
+                case SampleFormatFlags::S16_Planar:
+                    scaleS16(reinterpret_cast<int16_t*>(data) + offset, count, channels, run);
+                    break;
+                case SampleFormatFlags::S32:
+                case SampleFormatFlags::S32_Planar:
+                    scaleS32(reinterpret_cast<int32_t*>(data) + offset, count, channels, run);
+                    break;
+                case SampleFormatFlags::FLT:
+                case SampleFormatFlags::FLT_Planar:
+                    scaleFlt(reinterpret_cast<float*>(data) + offset, count, channels, run);
+                    break;
+                case SampleFormatFlags::DBL:
+                case SampleFormatFlags::DBL_Planar:
+                    scaleDbl(reinterpret_cast<double*>(data) + offset, count, channels, run);
+                    break;
+                default:
+                    return;
+            }
+        }
+    }
+
+    void GainKernel::mixRamp(float* out, const float* in, size_t frames, uint32_t channels, const GainRamp& ramp)
+    {
+        if (channels == 0)
+        {
+            return;
+        }
+
+        for(size_t frame = 0; frame < frames; frame += rampRunFrames)
+        {
+            GainRamp run = ramp;
+            run.start = ramp.at(frame);
+            const size_t offset = frame * channels;
+            mixFlt(out + offset, in + offset, std::min(rampRunFrames, frames - frame) * channels, channels, run);
+        }
+    }
+
+    const char* GainKernel::instructionSet()
+    {
+#if defined(GAIN_KERNEL_X86)
+        return hasAvx2 ? "avx2" : "sse2";
+#elif defined(GAIN_KERNEL_NEON)
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <enums/SampleFormatFlags.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CasperTech
+{
+    // A gain which starts at `start` and changes by `step` every frame, added for a
+    // linear ramp or multiplied for an exponential one. Every channel of a frame
+    // gets the same gain.
+    struct GainRamp
+    {
+        double start = 1.0;
+        double step = 0.0;
+        bool exponential = false;
+
+        [[nodiscard]] double at(uint64_t frame) const;
+        [[nodiscard]] bool isUnity() const;
+    };
+
+    // Scales samples in place, for 16 and 32 bit integer, float and double samples,
+    // packed or planar. Integer results are rounded to nearest and saturated. Uses
+    // AVX2 or SSE2 on x86 (picked at runtime) and NEON on ARM, finishing the tail,
+    // and anything else, with a scalar loop.
+    class GainKernel
+    {
+        public:
+            static bool supports(SampleFormatFlags format);
+            static bool isPlanar(SampleFormatFlags format);
+
+            // count is the number of samples in data: frames * channels for a packed
+            // buffer, or frames for a single plane
+            static void apply(SampleFormatFlags format, uint8_t* data, size_t count, float gain);
+
+            // channels is the number of interleaved samples per frame in data, so 1
+            // for a single plane
+            static void applyRamp(SampleFormatFlags format, uint8_t* data, size_t frames, uint32_t channels, const GainRamp& ramp);
+
+            // Adds packed float samples scaled by the ramp onto out, for mixing
+            static void mixRamp(float* out, const float* in, size_t frames, uint32_t channels, const GainRamp& ramp);
+
+            static const char* instructionSet();
+    };
+}
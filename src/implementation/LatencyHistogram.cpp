@@ -0,0 +1,105 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace CasperTech
+{
+    static uint32_t highestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+    uint32_t LatencyHistogram::bucketFor(uint64_t ns)
+    {
+        if (ns < linearBuckets)
+        {
+            return static_cast<uint32_t>(ns);
+        }
+        const uint32_t magnitude = highestBit(ns);
+        const auto sub = static_cast<uint32_t>((ns >> (magnitude - subBucketBits)) & (subBuckets - 1));
+        return linearBuckets + (magnitude - 4) * subBuckets + sub;
+    }
+
+    uint64_t LatencyHistogram::valueFor(uint32_t bucket)
+    {
+        if (bucket < linearBuckets)
+        {
+            return bucket;
+        }
+        // Report the middle of the bucket's range
+        const uint32_t magnitude = (bucket - linearBuckets) / subBuckets + 4;
+        const uint32_t sub = (bucket - linearBuckets) % subBuckets;
+        const uint64_t lower = static_cast<uint64_t>(subBuckets + sub) << (magnitude - subBucketBits);
+        const uint64_t width = uint64_t(1) << (magnitude - subBucketBits);
+        return lower + width / 2;
+    }
+
+    void LatencyHistogram::record(uint64_t ns)
+    {
+        _buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(ns, std::memory_order_relaxed);
+
+        uint64_t current = _min.load(std::memory_order_relaxed);
+        while(ns < current && !_min.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+        {
+        }
+        current = _max.load(std::memory_order_relaxed);
+        while(ns > current && !_max.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    HistogramSnapshot LatencyHistogram::snapshot() const
+    {
+        std::array<uint64_t, bucketCount> counts{};
+        uint64_t total = 0;
+        for(uint32_t i = 0; i < bucketCount; i++)
+        {
+            counts[i] = _buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        HistogramSnapshot snapshot;
+        snapshot.count = total;
+        if (total == 0)
+        {
+            return snapshot;
+        }
+        snapshot.minNs = _min.load(std::memory_order_relaxed);
+        snapshot.maxNs = _max.load(std::memory_order_relaxed);
+        const uint64_t count = _count.load(std::memory_order_relaxed);
+        snapshot.meanNs = count > 0 ? static_cast<double>(_sum.load(std::memory_order_relaxed)) / static_cast<double>(count) : 0.0;
+
+        auto percentile = [&](double p)
+        {
+            const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(total))));
+            uint64_t seen = 0;
+            for(uint32_t i = 0; i < bucketCount; i++)
+            {
+                seen += counts[i];
+                if (seen >= target)
+                {
+                    return std::clamp(valueFor(i), snapshot.minNs, snapshot.maxNs);
+                }
+            }
+            return snapshot.maxNs;
+        };
+        snapshot.p50Ns = percentile(0.5);
+        snapshot.p90Ns = percentile(0.9);
+        snapshot.p99Ns = percentile(0.99);
+        snapshot.p999Ns = percentile(0.999);
+        return snapshot;
+    }
+}
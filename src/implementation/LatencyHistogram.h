@@ -0,0 +1,38 @@
+#pragma once
+
+#include <structs/PipelineStatsSnapshot.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace CasperTech
+{
+    // Lock-free log-linear histogram of nanosecond durations, in the style of HDR
+    // histograms. Values below 16ns are exact; above that each power of two is split
+    // into 8 buckets, so any recorded value is reported to within 12.5%.
+    //
+    // record() is wait-free and safe to call from the audio callback. snapshot() may
+    // run concurrently with it and sees each bucket at some point during the read.
+    class LatencyHistogram
+    {
+        public:
+            void record(uint64_t ns);
+            [[nodiscard]] HistogramSnapshot snapshot() const;
+
+        private:
+            static constexpr uint32_t linearBuckets = 16;
+            static constexpr uint32_t subBucketBits = 3;
+            static constexpr uint32_t subBuckets = 1 << subBucketBits;
+            static constexpr uint32_t bucketCount = linearBuckets + (64 - 4) * subBuckets;
+
+            static uint32_t bucketFor(uint64_t ns);
+            static uint64_t valueFor(uint32_t bucket);
+
+            std::array<std::atomic<uint64_t>, bucketCount> _buckets{};
+            std::atomic<uint64_t> _count{0};
+            std::atomic<uint64_t> _sum{0};
+            std::atomic<uint64_t> _min{UINT64_MAX};
+            std::atomic<uint64_t> _max{0};
+    };
+}
@@ -0,0 +1,134 @@
+#include "MediaProbe.h"
+#include "ClipCache.h"
+#include "FFSource.h"
+#include "ProbeCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace CasperTech
+{
+    static void addTags(const AVDictionary* dict, std::vector<std::pair<std::string, std::string>>& tags)
+    {
+        const AVDictionaryEntry* tag = nullptr;
+        while((tag = av_dict_get(dict, "", tag, AV_DICT_IGNORE_SUFFIX)) != nullptr)
+        {
+            const std::string name(tag->key);
+            const bool present = std::any_of(tags.begin(), tags.end(), [&name](const auto& existing)
+            {
+                return existing.first == name;
+            });
+            if (!present)
+            {
+                tags.emplace_back(name, tag->value);
+            }
+        }
+    }
+
+    MediaInfo MediaProbe::probeFile(const std::string& path)
+    {
+        av_log_set_level(AV_LOG_QUIET);
+
+        MediaInfo info;
+        info.path = path;
+        AVFormatContext* fmtCtx = nullptr;
+        int result = avformat_open_input(&fmtCtx, path.c_str(), nullptr, nullptr);
+        if (result < 0)
+        {
+            info.error = FFSource::getError(result);
+            return info;
+        }
+        std::unique_ptr<AVFormatContext*, void(*)(AVFormatContext**)> closer(&fmtCtx, avformat_close_input);
+
+        result = avformat_find_stream_info(fmtCtx, nullptr);
+        if (result < 0)
+        {
+            info.error = FFSource::getError(result);
+            return info;
+        }
+        const int streamIndex = av_find_best_stream(fmtCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (streamIndex < 0)
+        {
+            info.error = "No audio stream found";
+            return info;
+        }
+        const AVStream* stream = fmtCtx->streams[streamIndex];
+        const AVCodecParameters* codecpar = stream->codecpar;
+
+        if (fmtCtx->duration != AV_NOPTS_VALUE && fmtCtx->duration > 0)
+        {
+            info.durationMs = static_cast<uint64_t>(av_rescale(fmtCtx->duration, 1000, AV_TIME_BASE));
+        }
+        else if (stream->duration != AV_NOPTS_VALUE && stream->duration > 0)
+        {
+            info.durationMs = static_cast<uint64_t>(av_rescale_q(stream->duration, stream->time_base, AVRational{ 1, 1000 }));
+        }
+        info.codec = avcodec_get_name(codecpar->codec_id);
+        info.sampleRate = static_cast<uint32_t>(std::max(codecpar->sample_rate, 0));
+        info.channels = static_cast<uint32_t>(std::max(codecpar->channels, 0));
+        info.bitRate = codecpar->bit_rate > 0 ? codecpar->bit_rate : fmtCtx->bit_rate;
+        addTags(fmtCtx->metadata, info.tags);
+        addTags(stream->metadata, info.tags);
+        return info;
+    }
+
+    std::vector<MediaInfo> MediaProbe::probe(const std::vector<std::string>& paths, const ProbeOptions& options)
+    {
+        std::vector<MediaInfo> results(paths.size());
+        if (paths.empty())
+        {
+            return results;
+        }
+
+        std::unique_ptr<ProbeCache> cache;
+        if (!options.cacheFile.empty())
+        {
+            cache = std::make_unique<ProbeCache>(options.cacheFile);
+            cache->load();
+        }
+
+        // Each thread takes the next unprobed path until none are left, so one
+        // slow file (a network mount, a large header) holds up only its own
+        // thread while the rest carry on with the batch
+        std::atomic<size_t> next{ 0 };
+        auto work = [&]
+        {
+            for(size_t i = next++; i < paths.size(); i = next++)
+            {
+                const std::string& path = paths[i];
+                const std::string key = cache ? ClipCache::keyFor(path) : std::string();
+                if (!key.empty() && cache->find(path, key, results[i]))
+                {
+                    continue;
+                }
+                results[i] = probeFile(path);
+                if (!key.empty() && results[i].error.empty())
+                {
+                    cache->insert(path, key, results[i]);
+                }
+            }
+        };
+
+        uint32_t threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<uint32_t>(std::min<size_t>(threads, paths.size()));
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for(uint32_t i = 1; i < threads; i++)
+        {
+            pool.emplace_back(work);
+        }
+        work();
+        for(auto& thread: pool)
+        {
+            thread.join();
+        }
+
+        if (cache && cache->dirty())
+        {
+            cache->save();
+        }
+        return results;
+    }
+}
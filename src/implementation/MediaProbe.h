@@ -0,0 +1,23 @@
+#pragma once
+
+#include <structs/MediaInfo.h>
+#include <structs/ProbeOptions.h>
+
+#include <string>
+#include <vector>
+
+namespace CasperTech
+{
+    // Reads what a library indexer wants to know about files (duration, codec,
+    // format and tags) without a player: only the demuxer and its stream probing
+    // run, never the decoder, output or chain.
+    class MediaProbe
+    {
+        public:
+            // Results are in the order of paths. A file that can't be probed has its
+            // error set rather than failing the batch. Blocks until done, the calling
+            // thread working alongside the pool.
+            static std::vector<MediaInfo> probe(const std::vector<std::string>& paths, const ProbeOptions& options = {});
+            static MediaInfo probeFile(const std::string& path);
+    };
+}
@@ -0,0 +1,64 @@
+#include "MemoryReader.h"
+
+extern "C" {
+    #include <libavformat/avio.h>
+    #include <libavutil/error.h>
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace CasperTech
+{
+    MemoryReader::MemoryReader(std::shared_ptr<const uint8_t> data, size_t size)
+        : _data(std::move(data))
+        , _size(size)
+    {
+
+    }
+
+    int MemoryReader::read(uint8_t* buffer, int size)
+    {
+        if (_position >= _size)
+        {
+            return AVERROR_EOF;
+        }
+        const size_t count = std::min(static_cast<size_t>(size), _size - _position);
+        std::memcpy(buffer, _data.get() + _position, count);
+        _position += count;
+        return static_cast<int>(count);
+    }
+
+    int64_t MemoryReader::seek(int64_t offset, int whence)
+    {
+        int64_t position;
+        switch(whence & ~AVSEEK_FORCE)
+        {
+            case AVSEEK_SIZE:
+                return static_cast<int64_t>(_size);
+            case SEEK_SET:
+                position = offset;
+                break;
+            case SEEK_CUR:
+                position = static_cast<int64_t>(_position) + offset;
+                break;
+            case SEEK_END:
+                position = static_cast<int64_t>(_size) + offset;
+                break;
+            default:
+                return AVERROR(EINVAL);
+        }
+        if (position < 0 || position > static_cast<int64_t>(_size))
+        {
+            return AVERROR(EINVAL);
+        }
+        _position = static_cast<size_t>(position);
+        return position;
+    }
+
+    bool MemoryReader::isSeekable() const
+    {
+        return true;
+    }
+}
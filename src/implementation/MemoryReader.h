@@ -0,0 +1,28 @@
+#pragma once
+
+#include <interfaces/IByteReader.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace CasperTech
+{
+    // Reads a file held in memory, in place. The memory is owned elsewhere and
+    // data's deleter tells the owner when the last reader has finished with it.
+    class MemoryReader: public IByteReader
+    {
+        public:
+            MemoryReader(std::shared_ptr<const uint8_t> data, size_t size);
+
+            /* <IByteReader> */
+            int read(uint8_t* buffer, int size) override;
+            int64_t seek(int64_t offset, int whence) override;
+            [[nodiscard]] bool isSeekable() const override;
+            /* </IByteReader> */
+
+        private:
+            std::shared_ptr<const uint8_t> _data;
+            size_t _size;
+            size_t _position = 0;
+    };
+}
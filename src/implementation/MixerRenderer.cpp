@@ -0,0 +1,214 @@
+#include "MixerRenderer.h"
+#include "OutputMixer.h"
+#include "PipelineStats.h"
+#include "RingBuffer.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
+
+namespace CasperTech
+{
+    MixerRenderer::MixerRenderer(std::shared_ptr<OutputMixer> mixer)
+        : _mixer(std::move(mixer))
+    {
+
+    }
+
+    MixerRenderer::~MixerRenderer()
+    {
+        if (_ringBuffer)
+        {
+            _ringBuffer->shutdown();
+        }
+        _mixer->detach(this);
+    }
+
+    std::string MixerRenderer::getName() const
+    {
+        return "MixerRenderer";
+    }
+
+    std::map<uint32_t, std::string> MixerRenderer::getDevices()
+    {
+        return _mixer->getDevices();
+    }
+
+    void MixerRenderer::selectDevice(uint32_t device)
+    {
+
+    }
+
+    void MixerRenderer::selectDefaultDevice()
+    {
+
+    }
+
+    SampleFormatFlags MixerRenderer::getSupportedSampleFormats()
+    {
+        return SampleFormatFlags::FLT;
+    }
+
+    std::vector<uint32_t> MixerRenderer::getSupportedSampleRates()
+    {
+        return { _mixer->getSampleRate() };
+    }
+
+    uint8_t MixerRenderer::getSupportedChannels()
+    {
+        return _mixer->getChannels();
+    }
+
+    void MixerRenderer::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        ScopedStageTimer timer(_stats ? &_stats->render : nullptr);
+        if (_ringBuffer)
+        {
+            _ringBuffer->put(buffer, sampleCount * _frameSize);
+            if (_stats)
+            {
+                _stats->clock.written(_ringBuffer->writePosition());
+            }
+        }
+    }
+
+    bool MixerRenderer::reserve(uint64_t sampleCount, RingSpans& spans)
+    {
+        // Waiting for ring space is the render stage's time, not the converter's
+        ScopedStageTimer timer(_stats ? &_stats->render : nullptr);
+        spans = _ringBuffer ? _ringBuffer->reserve(sampleCount * _frameSize) : RingSpans{};
+        return true;
+    }
+
+    void MixerRenderer::commit(uint64_t sampleCount)
+    {
+        if (_ringBuffer)
+        {
+            _ringBuffer->commit(sampleCount * _frameSize);
+            if (_stats)
+            {
+                _stats->clock.written(_ringBuffer->writePosition());
+            }
+        }
+    }
+
+    void MixerRenderer::onSourceConfigured()
+    {
+        if (_ringBuffer && _frameSize == sizeof(float) * _sourceChannels)
+        {
+            // Same layout as before, so the ring only needs emptying
+            flush();
+            return;
+        }
+
+        // The callback mustn't see the ring while it's replaced
+        _mixer->detach(this);
+        uint64_t position = 0;
+        if (_ringBuffer)
+        {
+            _ringBuffer->shutdown();
+            position = _ringBuffer->writePosition();
+        }
+
+        // Two callbacks' worth, the same depth a player's own stream would have
+        _frameSize = sizeof(float) * _sourceChannels;
+        _ringBuffer = std::make_unique<RingBuffer>(_mixer->getBufferFrames() * _frameSize * 2, _frameSize, position);
+        _starved.store(true, std::memory_order_relaxed);
+        if (_stats)
+        {
+            _stats->ringCapacityBytes.store(_ringBuffer->capacity(), std::memory_order_relaxed);
+            _stats->clock.setLatencyFrames(_mixer->getLatencyFrames());
+            _stats->clock.rebase(position, _mixer->getSampleRate());
+        }
+        _mixer->attach(this);
+    }
+
+    void MixerRenderer::onEos()
+    {
+        if (_ringBuffer)
+        {
+            _ringBuffer->eos();
+        }
+    }
+
+    void MixerRenderer::flush()
+    {
+        if (_ringBuffer)
+        {
+            _ringBuffer->reset();
+            _starved.store(true, std::memory_order_relaxed);
+            if (_stats)
+            {
+                _stats->clock.rebase(_ringBuffer->writePosition(), _mixer->getSampleRate());
+            }
+        }
+    }
+
+    void MixerRenderer::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        IAudioSink::setStats(stats);
+        if (_stats && _ringBuffer)
+        {
+            _stats->ringCapacityBytes.store(_ringBuffer->capacity(), std::memory_order_relaxed);
+            _stats->clock.setLatencyFrames(_mixer->getLatencyFrames());
+            _stats->clock.rebase(_ringBuffer->writePosition(), _mixer->getSampleRate());
+        }
+    }
+
+    void MixerRenderer::setVolume(float volume, uint32_t rampMs, VolumeCurve curve)
+    {
+        _volume.set(volume, rampMs, curve);
+    }
+
+    void MixerRenderer::mix(float* out, uint32_t frames, bool underflow)
+    {
+        ScopedStageTimer timer(_stats ? &_stats->callback : nullptr);
+        const uint32_t channels = _sourceChannels;
+        const size_t bytes = frames * _frameSize;
+        const size_t available = _ringBuffer->size();
+        const RingSpans spans = _ringBuffer->peek(bytes);
+
+        // The ring may wrap part way through, and the ramp may end part way through,
+        // so each stretch of gain is mixed from whichever spans it covers. Frames the
+        // ring couldn't provide are left as they are, but the ramp still moves on.
+        const uint64_t firstFrames = spans.first.size / _frameSize;
+        const uint64_t queuedFrames = spans.size() / _frameSize;
+        _volume.process(frames, _mixer->getSampleRate(), [&](uint64_t offset, uint64_t count, const GainRamp& ramp)
+        {
+            if (!ramp.exponential && ramp.start == 0.0 && ramp.step == 0.0)
+            {
+                // Muted voices add nothing
+                return;
+            }
+            const uint64_t end = std::min<uint64_t>(offset + count, queuedFrames);
+            GainRamp from = ramp;
+            for(uint64_t frame = offset; frame < end;)
+            {
+                const bool inFirst = frame < firstFrames;
+                const uint64_t stop = inFirst ? std::min(end, firstFrames) : end;
+                const auto* in = reinterpret_cast<const float*>(inFirst ? spans.first.data : spans.second.data)
+                        + (inFirst ? frame : frame - firstFrames) * channels;
+                from.start = ramp.at(frame - offset);
+                GainKernel::mixRamp(out + frame * channels, in, stop - frame, channels, from);
+                frame = stop;
+            }
+        });
+        _ringBuffer->release(spans.size());
+
+        if (_stats)
+        {
+            _stats->clock.played(_ringBuffer->readPosition(), spans.size() / _frameSize);
+            _stats->callbacks.fetch_add(1, std::memory_order_relaxed);
+            _stats->ringFillBytes.store(available, std::memory_order_relaxed);
+
+            // Counted the same way as RtAudioStream: once per dry spell, or whenever
+            // the device itself ran out
+            const bool starved = spans.size() < bytes;
+            const bool playing = _stats->playingSinceNs.load(std::memory_order_relaxed) != 0;
+            const bool wasStarved = _starved.exchange(starved, std::memory_order_relaxed);
+            if (playing && (underflow || (starved && !wasStarved)))
+            {
+                _stats->recordUnderrun();
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "VolumeRamp.h"
+
+#include <enums/VolumeCurve.h>
+#include <interfaces/IAudioRenderer.h>
+#include <interfaces/IAudioSink.h>
+
+#include <atomic>
+#include <memory>
+
+namespace CasperTech
+{
+    class OutputMixer;
+    class RingBuffer;
+
+    // A player's voice on the shared OutputMixer. Audio is queued in a ring like
+    // RtAudioStream's, and the mixer callback scales it by the voice's gain and adds
+    // it to the output without copying it anywhere first.
+    class MixerRenderer: public IAudioRenderer, public IAudioSink
+    {
+        public:
+            explicit MixerRenderer(std::shared_ptr<OutputMixer> mixer);
+            ~MixerRenderer() override;
+
+            /* <IAudioRenderer> */
+            // The device belongs to the mixer, so it can't be changed per player
+            std::map<uint32_t, std::string> getDevices() override;
+            void selectDevice(uint32_t device) override;
+            void selectDefaultDevice() override;
+            /* </IAudioRenderer> */
+
+            /* <IAudioNode> */
+            SampleFormatFlags getSupportedSampleFormats() override;
+            std::vector<uint32_t> getSupportedSampleRates() override;
+            uint8_t getSupportedChannels() override;
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+            /* <IAudioSink> */
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
+            bool reserve(uint64_t sampleCount, RingSpans& spans) override;
+            void commit(uint64_t sampleCount) override;
+            void onSourceConfigured() override;
+            void onEos() override;
+            void flush() override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
+            /* </IAudioSink> */
+
+            // Applied in the mixer callback. Safe to call from any thread.
+            void setVolume(float volume, uint32_t rampMs = 0, VolumeCurve curve = VolumeCurve::Linear);
+
+            // Called from the mixer callback. Adds frames frames of this voice onto out.
+            void mix(float* out, uint32_t frames, bool underflow);
+
+        private:
+            std::shared_ptr<OutputMixer> _mixer;
+            std::unique_ptr<RingBuffer> _ringBuffer;
+            VolumeRamp _volume;
+            uint64_t _frameSize = 0;
+            // Set by flush() and onSourceConfigured() as well as the callback
+            std::atomic<bool> _starved{ true };
+    };
+}
@@ -0,0 +1,185 @@
+#include "NullRenderer.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace CasperTech
+{
+    NullRenderer::NullRenderer(ClockMode clockMode)
+        : _clockMode(clockMode)
+    {
+
+    }
+
+    std::string NullRenderer::getName() const
+    {
+        return "NullRenderer";
+    }
+
+    std::map<uint32_t, std::string> NullRenderer::getDevices()
+    {
+        return {{ 0, getName() }};
+    }
+
+    void NullRenderer::selectDevice(uint32_t device)
+    {
+
+    }
+
+    void NullRenderer::selectDefaultDevice()
+    {
+
+    }
+
+    SampleFormatFlags NullRenderer::getSupportedSampleFormats()
+    {
+        return SampleFormatFlags::S16
+               | SampleFormatFlags::S32
+               | SampleFormatFlags::FLT
+               | SampleFormatFlags::DBL;
+    }
+
+    std::vector<uint32_t> NullRenderer::getSupportedSampleRates()
+    {
+        return {
+                384000,
+                352800,
+                192000,
+                176400,
+                96000,
+                88200,
+                48000,
+                44100,
+                32000,
+                22050,
+                11025,
+                8000
+        };
+    }
+
+    uint8_t NullRenderer::getSupportedChannels()
+    {
+        return 2;
+    }
+
+    void NullRenderer::onSourceConfigured()
+    {
+        _streamOpen = false;
+        switch(_sourceFormat)
+        {
+            case SampleFormatFlags::S16:
+                _sampleSize = 2;
+                break;
+            case SampleFormatFlags::S32:
+            case SampleFormatFlags::FLT:
+                _sampleSize = 4;
+                break;
+            case SampleFormatFlags::DBL:
+                _sampleSize = 8;
+                break;
+            default:
+                return;
+        }
+
+        _clockSamples = 0;
+        _clockStart = std::chrono::steady_clock::now();
+        onStreamStart();
+        _streamOpen = true;
+        flush();
+    }
+
+    void NullRenderer::flush()
+    {
+        // Nothing is held back, so only the playback clock starts over
+        if (_stats)
+        {
+            _stats->clock.rebase(_samplesRendered, _sourceSampleRate);
+        }
+    }
+
+    void NullRenderer::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        IAudioSink::setStats(stats);
+        flush();
+    }
+
+    void NullRenderer::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        if (!_streamOpen)
+        {
+            return;
+        }
+        ScopedStageTimer timer(_stats ? &_stats->render : nullptr);
+        onStreamData(buffer, sampleCount * _sampleSize * _sourceChannels);
+        const uint64_t rendered = _samplesRendered += sampleCount;
+        if (_clockMode == ClockMode::RealTime)
+        {
+            // Heard as the clock reaches it
+            const uint64_t ahead = pace(sampleCount);
+            if (_stats)
+            {
+                _stats->clock.written(rendered);
+                _stats->clock.played(rendered - ahead + sampleCount, sampleCount);
+            }
+        }
+        else if (_stats)
+        {
+            _stats->clock.written(rendered);
+            _stats->clock.played(rendered, 0);
+        }
+    }
+
+    uint64_t NullRenderer::pace(uint64_t sampleCount)
+    {
+        using namespace std::chrono;
+
+        const auto now = steady_clock::now();
+        const auto lead = milliseconds(_bufferLengthMs);
+        auto due = _clockStart + duration_cast<steady_clock::duration>(duration<double>(static_cast<double>(_clockSamples) / _sourceSampleRate));
+        if (now > due)
+        {
+            // Everything we were given has been "played" (paused, or a slow producer).
+            // A device would have played silence meanwhile, so restart the clock rather
+            // than letting the producer burst to catch up. It only counts as an
+            // underrun if the buffer ran dry after playback was last started.
+            if (_stats && _clockSamples > 0)
+            {
+                const int64_t playingSince = _stats->playingSinceNs.load(std::memory_order_relaxed);
+                const int64_t dryNs = duration_cast<nanoseconds>(due.time_since_epoch()).count();
+                if (playingSince != 0 && dryNs > playingSince)
+                {
+                    _stats->recordUnderrun();
+                }
+            }
+            _clockStart = now;
+            _clockSamples = 0;
+            due = now;
+        }
+
+        _clockSamples += sampleCount;
+        due = _clockStart + duration_cast<steady_clock::duration>(duration<double>(static_cast<double>(_clockSamples) / _sourceSampleRate));
+        if (due > now + lead)
+        {
+            std::this_thread::sleep_until(due - lead);
+        }
+        const auto remaining = duration_cast<duration<double>>(due - steady_clock::now()).count();
+        return std::min(static_cast<uint64_t>(std::max(remaining, 0.0) * _sourceSampleRate), _clockSamples);
+    }
+
+    void NullRenderer::onEos()
+    {
+        if (_streamOpen)
+        {
+            onStreamEnd();
+        }
+    }
+
+    uint64_t NullRenderer::getSamplesRendered() const
+    {
+        return _samplesRendered;
+    }
+
+    NullRenderer::~NullRenderer() = default;
+}
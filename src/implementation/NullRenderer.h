@@ -0,0 +1,67 @@
+#pragma once
+
+#include <enums/ClockMode.h>
+#include <interfaces/IAudioRenderer.h>
+#include <interfaces/IAudioSink.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace CasperTech
+{
+    // Headless renderer which negotiates like a device but discards the audio. Used
+    // on machines without a sound card, and as the base for FileRenderer.
+    class NullRenderer: public IAudioRenderer, public IAudioSink
+    {
+        public:
+            explicit NullRenderer(ClockMode clockMode = ClockMode::RealTime);
+            ~NullRenderer() override;
+
+            /* <IAudioRenderer> */
+            std::map<uint32_t, std::string> getDevices() override;
+            void selectDevice(uint32_t device) override;
+            void selectDefaultDevice() override;
+            /* </IAudioRenderer> */
+
+            /* <IAudioNode> */
+            SampleFormatFlags getSupportedSampleFormats() override;
+            std::vector<uint32_t> getSupportedSampleRates() override;
+            uint8_t getSupportedChannels() override;
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+            /* <IAudioSink> */
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
+            void onSourceConfigured() override;
+            void onEos() override;
+            void flush() override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
+            /* </IAudioSink> */
+
+            [[nodiscard]] uint64_t getSamplesRendered() const;
+
+        protected:
+            // Called when a (new) source format has been negotiated, for each packet of
+            // audio, and when the source reaches its end. Playback may resume after
+            // onStreamEnd if the source is replayed without being reconfigured.
+            virtual void onStreamStart(){}
+            virtual void onStreamData(const uint8_t* buffer, uint64_t bytes){}
+            virtual void onStreamEnd(){}
+
+            uint8_t _sampleSize = 0;
+
+        private:
+            // Returns how many samples are still ahead of the clock
+            uint64_t pace(uint64_t sampleCount);
+
+            ClockMode _clockMode;
+            std::chrono::steady_clock::time_point _clockStart;
+            uint64_t _clockSamples = 0;
+            bool _streamOpen = false;
+            std::atomic<uint64_t> _samplesRendered{0};
+
+            // How far ahead of the clock the producer may run, as a device's output
+            // buffer would allow. Matches RtAudioRenderer's buffer length.
+            uint64_t _bufferLengthMs = 50;
+    };
+}
@@ -0,0 +1,226 @@
+#include "OutputMixer.h"
+#include "MixerRenderer.h"
+
+#include <enums/AudioError.h>
+#include <exceptions/AudioException.h>
+
+#include <RtAudio.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace CasperTech
+{
+    std::mutex OutputMixer::sharedMutex;
+    std::weak_ptr<OutputMixer> OutputMixer::sharedMixer;
+
+    OutputMixer::OutputMixer(uint32_t sampleRate, uint8_t channels)
+        : _sampleRate(sampleRate)
+        , _channels(channels)
+    {
+
+    }
+
+    OutputMixer::~OutputMixer()
+    {
+        if (!_rtAudio)
+        {
+            return;
+        }
+        if (_rtAudio->isStreamRunning())
+        {
+            _rtAudio->abortStream();
+        }
+        if (_rtAudio->isStreamOpen())
+        {
+            _rtAudio->closeStream();
+        }
+    }
+
+    std::shared_ptr<OutputMixer> OutputMixer::shared()
+    {
+        std::unique_lock<std::mutex> lk(sharedMutex);
+        auto mixer = sharedMixer.lock();
+        if (!mixer)
+        {
+            mixer = std::shared_ptr<OutputMixer>(new OutputMixer(0, 0));
+            mixer->open();
+            sharedMixer = mixer;
+        }
+        return mixer;
+    }
+
+    std::shared_ptr<OutputMixer> OutputMixer::headless(uint32_t sampleRate, uint8_t channels)
+    {
+        auto mixer = std::shared_ptr<OutputMixer>(new OutputMixer(sampleRate, channels));
+        mixer->_bufFrames = static_cast<uint32_t>(static_cast<uint64_t>(sampleRate) * mixer->_bufferLengthMs / 1000 / 2);
+        return mixer;
+    }
+
+    void OutputMixer::open()
+    {
+        _rtAudio = std::make_unique<RtAudio>();
+
+        RtAudio::DeviceInfo info;
+        bool found = false;
+        try
+        {
+            _deviceId = _rtAudio->getDefaultOutputDevice();
+            info = _rtAudio->getDeviceInfo(_deviceId);
+            found = info.outputChannels > 0;
+        }
+        catch(RtAudioError&)
+        {
+
+        }
+        const uint32_t deviceCount = _rtAudio->getDeviceCount();
+        for(uint32_t i = 0; !found && i < deviceCount; i++)
+        {
+            try
+            {
+                info = _rtAudio->getDeviceInfo(i);
+                if (info.outputChannels > 0)
+                {
+                    _deviceId = i;
+                    found = true;
+                }
+            }
+            catch(RtAudioError&)
+            {
+
+            }
+        }
+        if (!found)
+        {
+            throw AudioException(AudioError::PipelineError, "No output device for the mixer");
+        }
+
+        // Players are converted to the mix rate, so stick with 48kHz where the device
+        // has it rather than following whatever the first file happened to be
+        const auto& rates = info.sampleRates;
+        _sampleRate = std::find(rates.begin(), rates.end(), 48000u) != rates.end() || info.preferredSampleRate == 0
+                ? 48000 : info.preferredSampleRate;
+        _channels = static_cast<uint8_t>(std::min(info.outputChannels, 2u));
+        _deviceName = info.name;
+        _bufFrames = static_cast<uint32_t>(((static_cast<float>(_sampleRate) / 1000.0) * static_cast<float>(_bufferLengthMs)) / 2.0);
+
+        RtAudio::StreamParameters params;
+        params.deviceId = _deviceId;
+        params.firstChannel = 0;
+        params.nChannels = _channels;
+        RtAudio::StreamOptions options;
+        try
+        {
+            _rtAudio->openStream(&params, nullptr, RTAUDIO_FLOAT32, _sampleRate, &_bufFrames, &OutputMixer::fillBufferStatic, this, &options, nullptr);
+            _rtAudio->startStream();
+            _latencyFrames = static_cast<uint64_t>(std::max<long>(_rtAudio->getStreamLatency(), 0));
+        }
+        catch(RtAudioError& e)
+        {
+            throw AudioException(AudioError::PipelineError, std::string("Unable to open the mixer output: ") + e.what());
+        }
+    }
+
+    int OutputMixer::fillBufferStatic(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames,
+                                      double streamTime, unsigned int status, void* data)
+    {
+        auto mixer = static_cast<OutputMixer*>(data);
+        mixer->render(static_cast<float*>(outputBuffer), nBufferFrames, (status & RTAUDIO_OUTPUT_UNDERFLOW) != 0);
+        return 0;
+    }
+
+    void OutputMixer::render(float* out, uint32_t frames, bool underflow)
+    {
+        std::memset(out, 0, static_cast<size_t>(frames) * _channels * sizeof(float));
+        // Registered as a reader before the list is used. If it was swapped in the
+        // meantime the writer may be filling it, so go round for the new one.
+        uint32_t current = _currentVoices.load();
+        for(;;)
+        {
+            _voiceReaders[current]++;
+            const uint32_t check = _currentVoices.load();
+            if (check == current)
+            {
+                break;
+            }
+            _voiceReaders[current]--;
+            current = check;
+        }
+        for(MixerRenderer* voice: _voices[current])
+        {
+            voice->mix(out, frames, underflow);
+        }
+        _voiceReaders[current]--;
+    }
+
+    void OutputMixer::publishVoices(const std::function<void(std::vector<MixerRenderer*>& voices)>& change)
+    {
+        auto waitForReaders = [this](uint32_t list)
+        {
+            while(_voiceReaders[list].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        };
+        const uint32_t current = _currentVoices.load();
+        const uint32_t next = 1 - current;
+        // A render that picked the spare list up just before the last swap backs
+        // off as soon as it sees it has changed
+        waitForReaders(next);
+        _voices[next] = _voices[current];
+        change(_voices[next]);
+        _currentVoices.store(next);
+        waitForReaders(current);
+    }
+
+    void OutputMixer::attach(MixerRenderer* voice)
+    {
+        std::unique_lock<std::mutex> lk(_voicesMutex);
+        publishVoices([voice](std::vector<MixerRenderer*>& voices)
+        {
+            if (std::find(voices.begin(), voices.end(), voice) == voices.end())
+            {
+                voices.push_back(voice);
+            }
+        });
+    }
+
+    void OutputMixer::detach(MixerRenderer* voice)
+    {
+        std::unique_lock<std::mutex> lk(_voicesMutex);
+        publishVoices([voice](std::vector<MixerRenderer*>& voices)
+        {
+            voices.erase(std::remove(voices.begin(), voices.end(), voice), voices.end());
+        });
+    }
+
+    uint32_t OutputMixer::getSampleRate() const
+    {
+        return _sampleRate;
+    }
+
+    uint8_t OutputMixer::getChannels() const
+    {
+        return _channels;
+    }
+
+    uint32_t OutputMixer::getBufferFrames() const
+    {
+        return _bufFrames;
+    }
+
+    uint64_t OutputMixer::getLatencyFrames() const
+    {
+        return _latencyFrames;
+    }
+
+    std::map<uint32_t, std::string> OutputMixer::getDevices() const
+    {
+        if (!_rtAudio)
+        {
+            return {};
+        }
+        return { { _deviceId, _deviceName } };
+    }
+}
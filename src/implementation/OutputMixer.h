@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class RtAudio;
+namespace CasperTech
+{
+    class MixerRenderer;
+
+    // One output stream shared by every player using RendererType::Mixer. Each player
+    // attaches a MixerRenderer as a voice, and the device callback sums the voices
+    // straight out of their rings into the output buffer, so a hundred players cost
+    // one device stream and one audio thread rather than a hundred.
+    //
+    // The stream is always 32 bit float at the device's rate; players convert to it
+    // before their audio reaches the voice.
+    class OutputMixer
+    {
+        public:
+            ~OutputMixer();
+
+            // The process wide mixer, opening the default output device on first use.
+            // The device is closed again once the last player lets go of it.
+            static std::shared_ptr<OutputMixer> shared();
+
+            // A mixer without a device, driven by calling render() directly
+            static std::shared_ptr<OutputMixer> headless(uint32_t sampleRate, uint8_t channels);
+
+            void attach(MixerRenderer* voice);
+            void detach(MixerRenderer* voice);
+
+            // Sums every attached voice into frames frames of interleaved float.
+            // underflow is set if the device reported running dry before this call.
+            void render(float* out, uint32_t frames, bool underflow);
+
+            [[nodiscard]] uint32_t getSampleRate() const;
+            [[nodiscard]] uint8_t getChannels() const;
+            [[nodiscard]] uint32_t getBufferFrames() const;
+            // What the device reported once opened; 0 without one
+            [[nodiscard]] uint64_t getLatencyFrames() const;
+            [[nodiscard]] std::map<uint32_t, std::string> getDevices() const;
+
+        private:
+            OutputMixer(uint32_t sampleRate, uint8_t channels);
+            void open();
+
+            static int fillBufferStatic(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames,
+                                        double streamTime, unsigned int status, void* data);
+
+            static std::mutex sharedMutex;
+            static std::weak_ptr<OutputMixer> sharedMixer;
+
+            std::unique_ptr<RtAudio> _rtAudio;
+            uint32_t _deviceId = 0;
+            std::string _deviceName;
+            uint32_t _sampleRate;
+            uint8_t _channels;
+            uint32_t _bufFrames = 0;
+            uint64_t _latencyFrames = 0;
+            uint64_t _bufferLengthMs = 50;
+
+            // Copies the voices into the list the callback isn't reading, with change
+            // applied, and publishes it. Waits for renders still reading the old
+            // list, so a voice is never detached half way through being mixed.
+            void publishVoices(const std::function<void(std::vector<MixerRenderer*>& voices)>& change);
+
+            // Serialises attach() and detach(). The callback never takes it, so a
+            // player being created or torn down can't hold up the device.
+            std::mutex _voicesMutex;
+            // Two lists of voices, _currentVoices the one renders read, with a count
+            // of renders reading each
+            std::array<std::vector<MixerRenderer*>, 2> _voices;
+            std::atomic<uint32_t> _currentVoices{ 0 };
+            std::array<std::atomic<uint32_t>, 2> _voiceReaders{};
+    };
+}
@@ -0,0 +1,47 @@
+#include "PipelineStats.h"
+
+#include <chrono>
+
+namespace CasperTech
+{
+    int64_t PipelineStats::nowNs()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void PipelineStats::setPlaying(bool playing)
+    {
+        playingSinceNs.store(playing ? nowNs() : 0, std::memory_order_relaxed);
+    }
+
+    void PipelineStats::recordUnderrun()
+    {
+        using namespace std::chrono;
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        lastUnderrunMs.store(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    }
+
+    PipelineStatsSnapshot PipelineStats::snapshot() const
+    {
+        PipelineStatsSnapshot snapshot;
+        snapshot.decode = decode.snapshot();
+        snapshot.readAhead = readAhead.snapshot();
+        snapshot.volume = volume.snapshot();
+        snapshot.resample = resample.snapshot();
+        snapshot.rate = rate.snapshot();
+        snapshot.render = render.snapshot();
+        snapshot.callback = callback.snapshot();
+        snapshot.frames = frames.load(std::memory_order_relaxed);
+        snapshot.samples = samples.load(std::memory_order_relaxed);
+        snapshot.callbacks = callbacks.load(std::memory_order_relaxed);
+        snapshot.underruns = underruns.load(std::memory_order_relaxed);
+        snapshot.ringFillBytes = ringFillBytes.load(std::memory_order_relaxed);
+        snapshot.ringCapacityBytes = ringCapacityBytes.load(std::memory_order_relaxed);
+        snapshot.lastUnderrunMs = lastUnderrunMs.load(std::memory_order_relaxed);
+        snapshot.readAheadFrames = readAheadFrames.load(std::memory_order_relaxed);
+        snapshot.readAheadMs = readAheadMs.load(std::memory_order_relaxed);
+        snapshot.readAheadCapacityMs = readAheadCapacityMs.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "PlaybackClock.h"
+
+#include <structs/PipelineStatsSnapshot.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace CasperTech
+{
+    // Counters and per-stage timings shared by every node of a player's pipeline.
+    // Everything is updated with relaxed atomics so nodes, including the audio
+    // callback, can record without locking; snapshot() can be taken at any time.
+    struct PipelineStats
+    {
+        LatencyHistogram decode;
+        LatencyHistogram readAhead;
+        LatencyHistogram volume;
+        LatencyHistogram resample;
+        LatencyHistogram rate;
+        LatencyHistogram render;
+        LatencyHistogram callback;
+
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> callbacks{0};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint64_t> ringFillBytes{0};
+        std::atomic<uint64_t> ringCapacityBytes{0};
+        std::atomic<uint64_t> lastUnderrunMs{0};
+        std::atomic<uint64_t> readAheadFrames{0};
+        std::atomic<uint64_t> readAheadMs{0};
+        std::atomic<uint64_t> readAheadCapacityMs{0};
+
+        // Steady clock time playback last (re)started, or 0 while not playing. Sinks
+        // only count an underrun when they run dry during playback they were asked
+        // to sustain, so pausing, stopping and the first fill don't register.
+        std::atomic<int64_t> playingSinceNs{0};
+
+        // Kept by the renderer, so the playback position can be read at any time
+        PlaybackClock clock;
+
+        void setPlaying(bool playing);
+        void recordUnderrun();
+
+        [[nodiscard]] PipelineStatsSnapshot snapshot() const;
+        [[nodiscard]] static int64_t nowNs();
+    };
+}
@@ -0,0 +1,159 @@
+#include "PlaybackClock.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace CasperTech
+{
+    static int64_t clockNowNs()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void PlaybackClock::beginWrite(std::atomic<uint64_t>& sequence)
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void PlaybackClock::endWrite(std::atomic<uint64_t>& sequence)
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void PlaybackClock::setStartMs(uint64_t ms)
+    {
+        _nextStartUs.store(ms * 1000, std::memory_order_relaxed);
+    }
+
+    void PlaybackClock::beginSegment(uint64_t startFrame, uint64_t startUs, uint32_t sampleRate, double speed)
+    {
+        beginWrite(_segmentSequence);
+        _previous.startFrame.store(_current.startFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _previous.startUs.store(_current.startUs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _previous.sampleRate.store(_current.sampleRate.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _previous.speed.store(_current.speed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _current.startFrame.store(startFrame, std::memory_order_relaxed);
+        _current.startUs.store(startUs, std::memory_order_relaxed);
+        _current.sampleRate.store(sampleRate, std::memory_order_relaxed);
+        _current.speed.store(speed, std::memory_order_relaxed);
+        endWrite(_segmentSequence);
+    }
+
+    void PlaybackClock::startTrack()
+    {
+        std::unique_lock<std::mutex> lk(_segmentMutex);
+        beginSegment(_written.load(std::memory_order_relaxed), 0, _current.sampleRate.load(std::memory_order_relaxed),
+                     _speed.load(std::memory_order_relaxed));
+    }
+
+    void PlaybackClock::rebase(uint64_t ringFrame, uint32_t sampleRate)
+    {
+        std::unique_lock<std::mutex> lk(_segmentMutex);
+        _written.store(ringFrame, std::memory_order_relaxed);
+        beginSegment(ringFrame, _nextStartUs.load(std::memory_order_relaxed), sampleRate, _speed.load(std::memory_order_relaxed));
+    }
+
+    void PlaybackClock::setSpeed(double speed)
+    {
+        std::unique_lock<std::mutex> lk(_segmentMutex);
+        _speed.store(speed, std::memory_order_relaxed);
+        const uint32_t sampleRate = _current.sampleRate.load(std::memory_order_relaxed);
+        if (sampleRate == 0)
+        {
+            // Nothing's been written yet; the first rebase takes the speed
+            return;
+        }
+        // The track carries on from wherever the current segment has got to
+        const uint64_t frame = _written.load(std::memory_order_relaxed);
+        const uint64_t startFrame = _current.startFrame.load(std::memory_order_relaxed);
+        const double elapsedUs = static_cast<double>(frame - startFrame) * 1e6
+                                 * _current.speed.load(std::memory_order_relaxed) / sampleRate;
+        beginSegment(frame, _current.startUs.load(std::memory_order_relaxed) + static_cast<uint64_t>(elapsedUs), sampleRate, speed);
+    }
+
+    void PlaybackClock::written(uint64_t ringFrame)
+    {
+        _written.store(ringFrame, std::memory_order_relaxed);
+    }
+
+    void PlaybackClock::played(uint64_t ringFrame, uint64_t frames)
+    {
+        beginWrite(_playedSequence);
+        _playedFrame.store(ringFrame, std::memory_order_relaxed);
+        _playedFrames.store(frames, std::memory_order_relaxed);
+        _playedNs.store(clockNowNs(), std::memory_order_relaxed);
+        endWrite(_playedSequence);
+    }
+
+    void PlaybackClock::setLatencyFrames(uint64_t frames)
+    {
+        _latencyFrames.store(frames, std::memory_order_relaxed);
+    }
+
+    double PlaybackClock::positionMs() const
+    {
+        uint64_t playedFrame;
+        uint64_t playedFrames;
+        int64_t playedNs;
+        uint64_t sequence;
+        do
+        {
+            sequence = _playedSequence.load(std::memory_order_acquire);
+            playedFrame = _playedFrame.load(std::memory_order_relaxed);
+            playedFrames = _playedFrames.load(std::memory_order_relaxed);
+            playedNs = _playedNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while((sequence & 1) != 0 || sequence != _playedSequence.load(std::memory_order_relaxed));
+
+        uint64_t startFrame;
+        uint64_t startUs;
+        uint32_t sampleRate;
+        double speed;
+        uint64_t previousFrame;
+        uint64_t previousUs;
+        uint32_t previousRate;
+        double previousSpeed;
+        do
+        {
+            sequence = _segmentSequence.load(std::memory_order_acquire);
+            startFrame = _current.startFrame.load(std::memory_order_relaxed);
+            startUs = _current.startUs.load(std::memory_order_relaxed);
+            sampleRate = _current.sampleRate.load(std::memory_order_relaxed);
+            speed = _current.speed.load(std::memory_order_relaxed);
+            previousFrame = _previous.startFrame.load(std::memory_order_relaxed);
+            previousUs = _previous.startUs.load(std::memory_order_relaxed);
+            previousRate = _previous.sampleRate.load(std::memory_order_relaxed);
+            previousSpeed = _previous.speed.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while((sequence & 1) != 0 || sequence != _segmentSequence.load(std::memory_order_relaxed));
+
+        if (sampleRate == 0)
+        {
+            return static_cast<double>(startUs) / 1000.0;
+        }
+
+        // The frames handed over by the last callback are heard one after another
+        // from latency after it, so the position moves on smoothly between callbacks
+        // but never past what the device actually has
+        const double elapsed = static_cast<double>(clockNowNs() - playedNs) * sampleRate / 1e9;
+        const double heard = static_cast<double>(playedFrame - playedFrames)
+                + std::clamp(elapsed, 0.0, static_cast<double>(playedFrames))
+                - static_cast<double>(_latencyFrames.load(std::memory_order_relaxed));
+
+        if (heard < static_cast<double>(startFrame))
+        {
+            if (previousRate != 0 && heard >= static_cast<double>(previousFrame))
+            {
+                return static_cast<double>(previousUs) / 1000.0
+                       + (heard - static_cast<double>(previousFrame)) * 1000.0 * previousSpeed / previousRate;
+            }
+            // Nothing from this segment has been heard yet
+            return static_cast<double>(startUs) / 1000.0;
+        }
+        return static_cast<double>(startUs) / 1000.0 + (heard - static_cast<double>(startFrame)) * 1000.0 * speed / sampleRate;
+    }
+}
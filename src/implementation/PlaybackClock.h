@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace CasperTech
+{
+    // Works out where in the track the output is playing. The renderer reports how
+    // far through its ring the device has read, and where in the track each stretch
+    // of the ring starts; positionMs() maps the one onto the other, less the
+    // device's latency. Ring positions are counted in frames from when the renderer
+    // was created and never go backwards.
+    //
+    // positionMs() never locks, waits or allocates, so it can be polled for a UI on
+    // every frame. What it reads is published through sequence counters: a reader
+    // that overlaps a write simply reads again.
+    class PlaybackClock
+    {
+        public:
+            // Where the audio written after the next rebase() starts in the track, as
+            // set before flushing for a seek, load or stop
+            void setStartMs(uint64_t ms);
+
+            // The next track starts with the next frame written, straight after what's
+            // queued of the last one. Called once the last of it has been passed on.
+            void startTrack();
+
+            // Called by the renderer when its ring is emptied or replaced. What's
+            // written from ringFrame on starts at the position last set.
+            void rebase(uint64_t ringFrame, uint32_t sampleRate);
+
+            // How far through the track each frame of output moves, from the next
+            // frame written on. Set by the rate stage as it changes the playback rate.
+            void setSpeed(double speed);
+
+            // Called by the renderer after writing up to ringFrame
+            void written(uint64_t ringFrame);
+
+            // Called from the device callback after it took frames, up to ringFrame
+            void played(uint64_t ringFrame, uint64_t frames);
+
+            // How long audio handed to the device takes to be heard
+            void setLatencyFrames(uint64_t frames);
+
+            // Where in the track the sample being heard now is, in ms
+            [[nodiscard]] double positionMs() const;
+
+        private:
+            struct Segment
+            {
+                std::atomic<uint64_t> startFrame{0};
+                std::atomic<uint64_t> startUs{0};
+                std::atomic<uint32_t> sampleRate{0};
+                std::atomic<double> speed{1.0};
+            };
+
+            static void beginWrite(std::atomic<uint64_t>& sequence);
+            static void endWrite(std::atomic<uint64_t>& sequence);
+            void beginSegment(uint64_t startFrame, uint64_t startUs, uint32_t sampleRate, double speed);
+
+            std::atomic<uint64_t> _nextStartUs{0};
+            std::atomic<double> _speed{1.0};
+            std::atomic<uint64_t> _written{0};
+            std::atomic<uint64_t> _latencyFrames{0};
+
+            // Segments are set from the control, play and read-ahead threads, so
+            // writers take the mutex; readers only check the sequence
+            std::mutex _segmentMutex;
+            std::atomic<uint64_t> _segmentSequence{0};
+            Segment _current;
+            // Still heard until the ring reaches the current one: the rest of a track
+            // the next follows on from, or after a flush, what the device already
+            // had. Frames a flush dropped are never reported played, so they can't
+            // be mistaken for it. Its rate is 0 when there's none.
+            Segment _previous;
+
+            // Only the device callback writes these
+            std::atomic<uint64_t> _playedSequence{0};
+            std::atomic<uint64_t> _playedFrame{0};
+            std::atomic<uint64_t> _playedFrames{0};
+            std::atomic<int64_t> _playedNs{0};
+    };
+}
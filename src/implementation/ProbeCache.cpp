@@ -0,0 +1,193 @@
+#include "ProbeCache.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace CasperTech
+{
+    static constexpr uint32_t cacheMagic = 0x4E415043; // "CPAN"
+    // Bumped whenever MediaInfo changes, so an older cache is dropped rather than misread
+    static constexpr uint32_t cacheVersion = 1;
+    // Anything longer is taken as a damaged file rather than allocated
+    static constexpr uint32_t maxStringSize = 1024 * 1024;
+
+    // Beside fileName, so the rename stays on one filesystem, and named so that no
+    // other batch or process saving the same cache writes to it too
+    static std::string tempNameFor(const std::string& fileName)
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+        static const uint64_t processTag = []
+        {
+            std::random_device random;
+            return (static_cast<uint64_t>(random()) << 32) ^ random();
+        }();
+        std::ostringstream name;
+        name << fileName << '.' << std::hex << processTag << '.' << counter++ << ".tmp";
+        return name.str();
+    }
+
+    template<typename T>
+    static void writeValue(std::ofstream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void writeString(std::ofstream& out, const std::string& value)
+    {
+        writeValue(out, static_cast<uint32_t>(value.size()));
+        out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    template<typename T>
+    static bool readValue(std::ifstream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    static bool readString(std::ifstream& in, std::string& value)
+    {
+        uint32_t size = 0;
+        if (!readValue(in, size) || size > maxStringSize)
+        {
+            return false;
+        }
+        value.resize(size);
+        return static_cast<bool>(in.read(value.data(), size));
+    }
+
+    ProbeCache::ProbeCache(std::string fileName)
+        : _fileName(std::move(fileName))
+    {
+
+    }
+
+    void ProbeCache::load()
+    {
+        std::ifstream in(_fileName, std::ios::binary);
+        if (!in)
+        {
+            return;
+        }
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!readValue(in, magic) || magic != cacheMagic
+            || !readValue(in, version) || version != cacheVersion
+            || !readValue(in, count))
+        {
+            return;
+        }
+
+        std::unordered_map<std::string, Entry> entries;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            Entry entry;
+            MediaInfo& info = entry.info;
+            uint32_t tagCount = 0;
+            if (!readString(in, info.path) || !readString(in, entry.key)
+                || !readValue(in, info.durationMs) || !readString(in, info.codec)
+                || !readValue(in, info.sampleRate) || !readValue(in, info.channels)
+                || !readValue(in, info.bitRate) || !readValue(in, tagCount))
+            {
+                return;
+            }
+            for(uint32_t t = 0; t < tagCount; t++)
+            {
+                std::string name;
+                std::string value;
+                if (!readString(in, name) || !readString(in, value))
+                {
+                    return;
+                }
+                info.tags.emplace_back(std::move(name), std::move(value));
+            }
+            entries[info.path] = std::move(entry);
+        }
+
+        std::unique_lock<std::mutex> lk(_mutex);
+        _entries = std::move(entries);
+        _dirty = false;
+    }
+
+    bool ProbeCache::save()
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        const std::string tempName = tempNameFor(_fileName);
+        {
+            std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                return false;
+            }
+            writeValue(out, cacheMagic);
+            writeValue(out, cacheVersion);
+            writeValue(out, static_cast<uint32_t>(_entries.size()));
+            for(const auto& [path, entry]: _entries)
+            {
+                const MediaInfo& info = entry.info;
+                writeString(out, info.path);
+                writeString(out, entry.key);
+                writeValue(out, info.durationMs);
+                writeString(out, info.codec);
+                writeValue(out, info.sampleRate);
+                writeValue(out, info.channels);
+                writeValue(out, info.bitRate);
+                writeValue(out, static_cast<uint32_t>(info.tags.size()));
+                for(const auto& [name, value]: info.tags)
+                {
+                    writeString(out, name);
+                    writeString(out, value);
+                }
+            }
+            out.flush();
+            if (!out)
+            {
+                out.close();
+                std::error_code ec;
+                std::filesystem::remove(tempName, ec);
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempName, _fileName, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tempName, ec);
+            return false;
+        }
+        _dirty = false;
+        return true;
+    }
+
+    bool ProbeCache::find(const std::string& path, const std::string& key, MediaInfo& info) const
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _entries.find(path);
+        if (it == _entries.end() || it->second.key != key)
+        {
+            return false;
+        }
+        info = it->second.info;
+        return true;
+    }
+
+    void ProbeCache::insert(const std::string& path, const std::string& key, const MediaInfo& info)
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        Entry& entry = _entries[path];
+        entry.key = key;
+        entry.info = info;
+        _dirty = true;
+    }
+
+    bool ProbeCache::dirty() const
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        return _dirty;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <structs/MediaInfo.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace CasperTech
+{
+    // MediaProbe's results, saved to a file between runs. Each path keeps the
+    // result for the size and modification time it was probed at (as
+    // ClipCache::keyFor identifies them), so an edited file misses and replaces
+    // its entry. Safe to share between threads.
+    class ProbeCache
+    {
+        public:
+            explicit ProbeCache(std::string fileName);
+
+            // A missing, unreadable or damaged file leaves the cache empty
+            void load();
+            // Written to a file of its own beside the cache and renamed over it, so
+            // a crash part way, or another batch or process saving at the same
+            // time, leaves a complete cache (the last renamed wins). Returns false
+            // if it couldn't be.
+            bool save();
+
+            bool find(const std::string& path, const std::string& key, MediaInfo& info) const;
+            void insert(const std::string& path, const std::string& key, const MediaInfo& info);
+            // Changed since it was loaded
+            [[nodiscard]] bool dirty() const;
+
+        private:
+            struct Entry
+            {
+                std::string key;
+                MediaInfo info;
+            };
+
+            std::string _fileName;
+            mutable std::mutex _mutex;
+            std::unordered_map<std::string, Entry> _entries;
+            bool _dirty = false;
+    };
+}
@@ -0,0 +1,401 @@
+#include "RateFilter.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace CasperTech
+{
+    static SampleFormatFlags rateFormats()
+    {
+        return SampleFormatFlags::S16
+               | SampleFormatFlags::S32
+               | SampleFormatFlags::FLT
+               | SampleFormatFlags::DBL;
+    }
+
+    std::string RateFilter::getName() const
+    {
+        return "RateFilter";
+    }
+
+    bool RateFilter::supports(SampleFormatFlags format)
+    {
+        return (rateFormats() & format) != 0;
+    }
+
+    SampleFormatFlags RateFilter::getSupportedSampleFormats()
+    {
+        // The audio leaves in the format it arrives in, so once there's a source
+        // that's the only one on offer either side
+        if (_source)
+        {
+            return _sourceFormat;
+        }
+        if (_sink)
+        {
+            return rateFormats() & _sink->getSupportedSampleFormats();
+        }
+        return rateFormats();
+    }
+
+    std::vector<uint32_t> RateFilter::getSupportedSampleRates()
+    {
+        if (_source)
+        {
+            return _source->getSupportedSampleRates();
+        }
+        return std::vector<uint32_t>{
+                384000,
+                352800,
+                192000,
+                176400,
+                96000,
+                88200,
+                48000,
+                44100,
+                32000,
+                22050,
+                11025,
+                8000
+        };
+    }
+
+    uint8_t RateFilter::getSupportedChannels()
+    {
+        if (_source)
+        {
+            return _sourceChannels;
+        }
+        if (_sink)
+        {
+            return _sinkChannels;
+        }
+        return 2;
+    }
+
+    void RateFilter::onSourceConfigured()
+    {
+        _sourceConfigured = true;
+        if (_sinkConfigured)
+        {
+            // Re-connect sink to establish preferred sample rate and channels
+            connectSink(_sink);
+        }
+    }
+
+    void RateFilter::onSinkConfigured()
+    {
+        _sinkConfigured = true;
+        if (_sourceConfigured)
+        {
+            _stretch.configure(_sourceSampleRate, _sourceChannels);
+            _varispeedInput.clear();
+            _varispeedPosition = 0.0;
+        }
+    }
+
+    void RateFilter::setRate(double rate, PlaybackRateMode mode)
+    {
+        _targetRate.store(std::clamp(rate, minRate, maxRate), std::memory_order_relaxed);
+        _targetMode.store(mode, std::memory_order_relaxed);
+    }
+
+    void RateFilter::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        ScopedStageTimer timer(_stats ? &_stats->rate : nullptr);
+        applyRate();
+        if (passingThrough())
+        {
+            if (_sink)
+            {
+                _sink->audio(buffer, planarChannel, sampleCount);
+            }
+            return;
+        }
+
+        toFloat(buffer, sampleCount);
+        _output.clear();
+        if (_mode == PlaybackRateMode::TimeStretch)
+        {
+            _stretch.put(_input.data(), sampleCount);
+            _stretch.process(_output);
+        }
+        else
+        {
+            varispeed(sampleCount);
+        }
+        emit(_output.data(), _output.size() / _sourceChannels);
+    }
+
+    bool RateFilter::reserve(uint64_t sampleCount, RingSpans& spans)
+    {
+        // A change waiting to be applied sends the block through audio(), which
+        // applies it
+        if (!_sink
+            || _flushPending.load(std::memory_order_relaxed)
+            || _targetRate.load(std::memory_order_relaxed) != _rate
+            || _targetMode.load(std::memory_order_relaxed) != _mode
+            || !passingThrough())
+        {
+            return false;
+        }
+        return _sink->reserve(sampleCount, spans);
+    }
+
+    void RateFilter::commit(uint64_t sampleCount)
+    {
+        if (_sink)
+        {
+            _sink->commit(sampleCount);
+        }
+    }
+
+    void RateFilter::onEos()
+    {
+        drain();
+        if (_sink)
+        {
+            _sink->onEos();
+        }
+    }
+
+    void RateFilter::flush()
+    {
+        _flushPending.store(true, std::memory_order_release);
+        if (_sink)
+        {
+            _sink->flush();
+        }
+    }
+
+    void RateFilter::applyRate()
+    {
+        if (_flushPending.exchange(false, std::memory_order_acquire))
+        {
+            _stretch.clear();
+            _varispeedInput.clear();
+            _varispeedPosition = 0.0;
+        }
+        const double rate = _targetRate.load(std::memory_order_relaxed);
+        const PlaybackRateMode mode = _targetMode.load(std::memory_order_relaxed);
+        if (rate == _rate && mode == _mode)
+        {
+            return;
+        }
+        if (mode != _mode || rate == 1.0)
+        {
+            // What's held was taken in for the old mode, so it's played out before
+            // switching
+            drain();
+        }
+        _rate = rate;
+        _mode = mode;
+        _stretch.setTempo(rate);
+        if (_stats)
+        {
+            _stats->clock.setSpeed(rate);
+        }
+    }
+
+    void RateFilter::drain()
+    {
+        if (_sourceChannels == 0)
+        {
+            return;
+        }
+        _output.clear();
+        _stretch.drain(_output);
+        // The varispeed is at most varispeedReach frames (under 2ms) behind, which
+        // are dropped
+        _varispeedInput.clear();
+        _varispeedPosition = 0.0;
+        if (!_output.empty())
+        {
+            emit(_output.data(), _output.size() / _sourceChannels);
+        }
+    }
+
+    bool RateFilter::passingThrough() const
+    {
+        return _rate == 1.0 && _stretch.empty() && _varispeedInput.empty();
+    }
+
+    void RateFilter::toFloat(const uint8_t* buffer, uint64_t frames)
+    {
+        const size_t count = frames * _sourceChannels;
+        _input.resize(count);
+        switch(_sourceFormat)
+        {
+            case SampleFormatFlags::S16:
+            {
+                const auto* in = reinterpret_cast<const int16_t*>(buffer);
+                for(size_t i = 0; i < count; i++)
+                {
+                    _input[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+                }
+                break;
+            }
+            case SampleFormatFlags::S32:
+            {
+                const auto* in = reinterpret_cast<const int32_t*>(buffer);
+                for(size_t i = 0; i < count; i++)
+                {
+                    _input[i] = static_cast<float>(static_cast<double>(in[i]) * (1.0 / 2147483648.0));
+                }
+                break;
+            }
+            case SampleFormatFlags::DBL:
+            {
+                const auto* in = reinterpret_cast<const double*>(buffer);
+                for(size_t i = 0; i < count; i++)
+                {
+                    _input[i] = static_cast<float>(in[i]);
+                }
+                break;
+            }
+            case SampleFormatFlags::FLT:
+            default:
+                std::memcpy(_input.data(), buffer, count * sizeof(float));
+                break;
+        }
+    }
+
+    const std::vector<float>& RateFilter::varispeedKernel()
+    {
+        static const std::vector<float> table = []
+        {
+            const double pi = std::acos(-1.0);
+            // One past the last zero crossing, where the window is zero, for the
+            // interpolation to reach
+            std::vector<float> values(static_cast<size_t>(varispeedZeroCrossings * varispeedResolution + 2), 0.0f);
+            for(int i = 0; i < varispeedZeroCrossings * varispeedResolution; i++)
+            {
+                const double u = static_cast<double>(i) / varispeedResolution;
+                const double sinc = i == 0 ? 1.0 : std::sin(pi * u) / (pi * u);
+                const double w = 0.5 + 0.5 * u / varispeedZeroCrossings;
+                const double window = 0.42 - 0.5 * std::cos(2.0 * pi * w) + 0.08 * std::cos(4.0 * pi * w);
+                values[static_cast<size_t>(i)] = static_cast<float>(sinc * window);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    void RateFilter::varispeed(uint64_t frames)
+    {
+        const uint32_t channels = _sourceChannels;
+        if (frames == 0)
+        {
+            return;
+        }
+        if (_varispeedInput.empty())
+        {
+            // Silence stands in for what came before the first frame
+            _varispeedInput.assign(static_cast<size_t>(varispeedReach) * channels, 0.0f);
+            _varispeedPosition = varispeedReach;
+        }
+        _varispeedInput.insert(_varispeedInput.end(), _input.begin(), _input.begin() + static_cast<std::ptrdiff_t>(frames * channels));
+
+        // Each output frame is the input under a sinc centred on its position.
+        // Sped up, the sinc is stretched by the rate, which cuts off what would
+        // fold back below the output's Nyquist.
+        const std::vector<float>& table = varispeedKernel();
+        const double scale = std::max(_rate, 1.0);
+        const double cutoff = varispeedCutoff / scale;
+        const int reach = std::min(static_cast<int>(std::ceil(varispeedZeroCrossings / cutoff)), varispeedReach);
+        _varispeedWeights.resize(static_cast<size_t>(reach) * 2);
+        const size_t available = _varispeedInput.size() / channels;
+        const float* in = _varispeedInput.data();
+        while(static_cast<size_t>(_varispeedPosition) + reach < available)
+        {
+            const auto centre = static_cast<int64_t>(_varispeedPosition);
+            const double fraction = _varispeedPosition - static_cast<double>(centre);
+            const int64_t first = centre - reach + 1;
+            double sum = 0.0;
+            for(int k = 0; k < reach * 2; k++)
+            {
+                const double u = std::abs((static_cast<double>(k - reach + 1) - fraction) * cutoff) * varispeedResolution;
+                float weight = 0.0f;
+                if (u < varispeedZeroCrossings * varispeedResolution)
+                {
+                    const auto i = static_cast<size_t>(u);
+                    const auto t = static_cast<float>(u - static_cast<double>(i));
+                    weight = table[i] + (table[i + 1] - table[i]) * t;
+                }
+                _varispeedWeights[static_cast<size_t>(k)] = weight;
+                sum += weight;
+            }
+            // Normalised, so the gain doesn't ripple with the fractional position
+            const auto norm = static_cast<float>(sum != 0.0 ? 1.0 / sum : 0.0);
+            for(uint32_t c = 0; c < channels; c++)
+            {
+                const float* x = in + static_cast<size_t>(first) * channels + c;
+                float acc = 0.0f;
+                for(int k = 0; k < reach * 2; k++)
+                {
+                    acc += _varispeedWeights[static_cast<size_t>(k)] * x[static_cast<size_t>(k) * channels];
+                }
+                _output.push_back(acc * norm);
+            }
+            _varispeedPosition += _rate;
+        }
+
+        // Keep varispeedReach frames behind the position for the next block
+        const auto keepFrom = static_cast<int64_t>(_varispeedPosition) - varispeedReach;
+        if (keepFrom > 0)
+        {
+            _varispeedInput.erase(_varispeedInput.begin(), _varispeedInput.begin() + static_cast<std::ptrdiff_t>(keepFrom * channels));
+            _varispeedPosition -= static_cast<double>(keepFrom);
+        }
+    }
+
+    void RateFilter::emit(const float* data, uint64_t frames)
+    {
+        if (!_sink || frames == 0)
+        {
+            return;
+        }
+        const size_t count = frames * _sourceChannels;
+        switch(_sourceFormat)
+        {
+            case SampleFormatFlags::S16:
+            {
+                _packed.resize(count * sizeof(int16_t));
+                auto* out = reinterpret_cast<int16_t*>(_packed.data());
+                for(size_t i = 0; i < count; i++)
+                {
+                    out[i] = static_cast<int16_t>(std::lrint(std::clamp(data[i], -1.0f, 1.0f) * 32767.0f));
+                }
+                break;
+            }
+            case SampleFormatFlags::S32:
+            {
+                _packed.resize(count * sizeof(int32_t));
+                auto* out = reinterpret_cast<int32_t*>(_packed.data());
+                for(size_t i = 0; i < count; i++)
+                {
+                    out[i] = static_cast<int32_t>(std::lrint(std::clamp(static_cast<double>(data[i]), -1.0, 1.0) * 2147483647.0));
+                }
+                break;
+            }
+            case SampleFormatFlags::DBL:
+            {
+                _packed.resize(count * sizeof(double));
+                auto* out = reinterpret_cast<double*>(_packed.data());
+                for(size_t i = 0; i < count; i++)
+                {
+                    out[i] = data[i];
+                }
+                break;
+            }
+            case SampleFormatFlags::FLT:
+            default:
+                _sink->audio(reinterpret_cast<const uint8_t*>(data), nullptr, frames);
+                return;
+        }
+        _sink->audio(_packed.data(), nullptr, frames);
+    }
+}
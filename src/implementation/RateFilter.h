@@ -0,0 +1,97 @@
+#pragma once
+
+#include "TimeStretch.h"
+
+#include <enums/PlaybackRateMode.h>
+#include <interfaces/IAudioSink.h>
+#include <interfaces/IAudioSource.h>
+
+#include <atomic>
+#include <vector>
+
+namespace CasperTech
+{
+    // Changes the playback rate, just before the output. Varispeed reads the audio
+    // out faster or slower through a band-limited (windowed sinc) interpolator, so
+    // sped up audio doesn't alias, and its pitch moves with it; TimeStretch keeps
+    // the pitch.
+    // Works in float on packed formats, which is everything the output is fed. At
+    // 1x the audio passes straight through, reservations on the output included, so
+    // normal playback costs nothing.
+    class RateFilter: public IAudioSink, public IAudioSource
+    {
+        public:
+            /* <IAudioNode> */
+            SampleFormatFlags getSupportedSampleFormats() override;
+            std::vector<uint32_t> getSupportedSampleRates() override;
+            uint8_t getSupportedChannels() override;
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+            /* <IAudioSink> */
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
+            // Only while passing straight through
+            bool reserve(uint64_t sampleCount, RingSpans& spans) override;
+            void commit(uint64_t sampleCount) override;
+            void onSourceConfigured() override;
+            // Drops what's held for stretching, then passes the flush on
+            void flush() override;
+            /* </IAudioSink> */
+
+            /* <IAudioSource> */
+            void onSinkConfigured() override;
+            void onEos() override;
+            /* </IAudioSource> */
+
+            // Safe to call from any thread. Takes effect from the start of the next
+            // block, without interrupting playback.
+            void setRate(double rate, PlaybackRateMode mode);
+
+            static bool supports(SampleFormatFlags format);
+
+            static constexpr double minRate = 0.5;
+            static constexpr double maxRate = 2.0;
+
+        private:
+            void applyRate();
+            void drain();
+            [[nodiscard]] bool passingThrough() const;
+            void toFloat(const uint8_t* buffer, uint64_t frames);
+            void varispeed(uint64_t frames);
+            void emit(const float* data, uint64_t frames);
+
+            std::atomic<double> _targetRate{ 1.0 };
+            std::atomic<PlaybackRateMode> _targetMode{ PlaybackRateMode::TimeStretch };
+            // Set by flush(), picked up by the next block
+            std::atomic<bool> _flushPending{ false };
+
+            // Only used by the thread passing audio through
+            double _rate = 1.0;
+            PlaybackRateMode _mode = PlaybackRateMode::TimeStretch;
+            TimeStretch _stretch;
+            std::vector<float> _input;
+            std::vector<float> _output;
+            std::vector<uint8_t> _packed;
+            // Starts varispeedReach frames before the next output position, which
+            // the interpolation reaches back to
+            std::vector<float> _varispeedInput;
+            double _varispeedPosition = 0.0;
+            std::vector<float> _varispeedWeights;
+
+            // Zero crossings of the interpolating sinc either side of a sample, and its
+            // cutoff as a fraction of the output's Nyquist, leaving the window's
+            // transition band room below it. Above 1x the kernel widens with the
+            // rate, lowering its cutoff to the new Nyquist, so it reaches at most
+            // varispeedReach input frames either side.
+            static constexpr int varispeedZeroCrossings = 16;
+            static constexpr double varispeedCutoff = 0.95;
+            static constexpr int varispeedReach = static_cast<int>(varispeedZeroCrossings * maxRate / varispeedCutoff) + 1;
+            // The kernel, a Blackman windowed sinc, sampled varispeedResolution times
+            // between zero crossings and interpolated between samples
+            static constexpr int varispeedResolution = 512;
+            static const std::vector<float>& varispeedKernel();
+
+            bool _sinkConfigured = false;
+            bool _sourceConfigured = false;
+    };
+}
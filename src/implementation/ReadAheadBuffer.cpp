@@ -0,0 +1,369 @@
+#include "ReadAheadBuffer.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
+
+namespace CasperTech
+{
+    ReadAheadBuffer::ReadAheadBuffer(uint32_t lengthMs)
+        : _lengthMs(lengthMs)
+    {
+        _thread = std::thread(&ReadAheadBuffer::threadFunc, this);
+    }
+
+    ReadAheadBuffer::~ReadAheadBuffer()
+    {
+        shutdown();
+    }
+
+    std::string ReadAheadBuffer::getName() const
+    {
+        return "ReadAheadBuffer";
+    }
+
+    SampleFormatFlags ReadAheadBuffer::getSupportedSampleFormats()
+    {
+        if (_source)
+        {
+            return _source->getSupportedSampleFormats();
+        }
+        return SampleFormatFlags::U8_Planar
+               | SampleFormatFlags::U8
+               | SampleFormatFlags::S16_Planar
+               | SampleFormatFlags::S16
+               | SampleFormatFlags::S32
+               | SampleFormatFlags::S32_Planar
+               | SampleFormatFlags::FLT
+               | SampleFormatFlags::FLT_Planar
+               | SampleFormatFlags::DBL
+               | SampleFormatFlags::DBL_Planar;
+    }
+
+    std::vector<uint32_t> ReadAheadBuffer::getSupportedSampleRates()
+    {
+        if (_source)
+        {
+            return _source->getSupportedSampleRates();
+        }
+        return std::vector<uint32_t>{
+                384000,
+                352800,
+                192000,
+                176400,
+                96000,
+                88200,
+                48000,
+                44100,
+                32000,
+                22050,
+                11025,
+                8000
+        };
+    }
+
+    uint8_t ReadAheadBuffer::getSupportedChannels()
+    {
+        if (_source)
+        {
+            return _sourceChannels;
+        }
+        if (_sink)
+        {
+            return _sinkChannels;
+        }
+        return 2;
+    }
+
+    void ReadAheadBuffer::onSourceConfigured()
+    {
+        _sourceConfigured = true;
+        if (_sinkConfigured)
+        {
+            // Re-connect sink to establish preferred sample rate and channels
+            connectSink(_sink);
+        }
+    }
+
+    void ReadAheadBuffer::onSinkConfigured()
+    {
+        _sinkConfigured = true;
+        switch(_sourceFormat)
+        {
+            case SampleFormatFlags::U8:
+            case SampleFormatFlags::U8_Planar:
+            case SampleFormatFlags::S8:
+            case SampleFormatFlags::S8_Planar:
+                _sampleSize = 1;
+                break;
+            case SampleFormatFlags::S16:
+            case SampleFormatFlags::S16_Planar:
+                _sampleSize = 2;
+                break;
+            case SampleFormatFlags::S24:
+            case SampleFormatFlags::S24_Planar:
+            case SampleFormatFlags::S32:
+            case SampleFormatFlags::S32_Planar:
+            case SampleFormatFlags::FLT:
+            case SampleFormatFlags::FLT_Planar:
+                _sampleSize = 4;
+                break;
+            case SampleFormatFlags::DBL:
+            case SampleFormatFlags::DBL_Planar:
+                _sampleSize = 8;
+                break;
+            default:
+                break;
+        }
+
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _capacitySamples = static_cast<uint64_t>(_lengthMs) * _sourceSampleRate / 1000;
+    }
+
+    void ReadAheadBuffer::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        IAudioSink::setStats(stats);
+        if (_stats)
+        {
+            _stats->readAheadCapacityMs.store(_lengthMs, std::memory_order_relaxed);
+        }
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        updateStats();
+    }
+
+    void ReadAheadBuffer::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        // Includes any wait for room, so it doesn't count against the decoder
+        ScopedStageTimer timer(_stats ? &_stats->readAhead : nullptr);
+        const uint64_t bytes = planarChannel != nullptr
+                ? sampleCount * _sampleSize
+                : sampleCount * _sampleSize * _sourceChannels;
+
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        // A frame is always let into an empty queue, however long it is
+        _spaceWait.wait(lk, [this]
+        {
+            return _shutdown || _count == 0 || _queuedSamples < _capacitySamples;
+        });
+        if (_shutdown)
+        {
+            return;
+        }
+        if (_slots.empty())
+        {
+            preallocate(sampleCount, bytes, planarChannel != nullptr);
+        }
+
+        QueuedFrame& frame = pushSlot();
+        frame.eos = false;
+        frame.marker = false;
+        frame.sampleCount = sampleCount;
+        frame.planar = planarChannel != nullptr;
+        frame.data.assign(buffer, buffer + bytes);
+        if (frame.planar)
+        {
+            frame.planarData.assign(planarChannel, planarChannel + bytes);
+        }
+        _queuedSamples += sampleCount;
+        updateStats();
+        _dataWait.notify_one();
+    }
+
+    void ReadAheadBuffer::onEos()
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        if (_shutdown)
+        {
+            // Nothing left to drain, so there's no need to keep the end in order
+            lk.unlock();
+            eos();
+            return;
+        }
+        QueuedFrame& frame = pushSlot();
+        frame.eos = true;
+        frame.marker = false;
+        frame.sampleCount = 0;
+        _dataWait.notify_one();
+    }
+
+    void ReadAheadBuffer::addMarker(std::function<void()> callback)
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        if (_shutdown)
+        {
+            return;
+        }
+        _markers.push(std::move(callback));
+        QueuedFrame& frame = pushSlot();
+        frame.eos = false;
+        frame.marker = true;
+        frame.sampleCount = 0;
+        _dataWait.notify_one();
+    }
+
+    void ReadAheadBuffer::preallocate(uint64_t sampleCount, uint64_t bytes, bool planar)
+    {
+        // Enough slots to fill the queue with frames like the first, each with room
+        // for one a little longer, so playback doesn't allocate as the queue fills
+        const size_t slots = static_cast<size_t>(_capacitySamples / std::max<uint64_t>(sampleCount, 1)) + 2;
+        const size_t reserveBytes = bytes + bytes / 4;
+        _slots.reserve(slots * 2);
+        for(size_t i = 0; i < slots; i++)
+        {
+            auto frame = std::make_unique<QueuedFrame>();
+            frame->data.reserve(reserveBytes);
+            if (planar)
+            {
+                frame->planarData.reserve(reserveBytes);
+            }
+            _slots.push_back(std::move(frame));
+        }
+    }
+
+    ReadAheadBuffer::QueuedFrame& ReadAheadBuffer::pushSlot()
+    {
+        if (_count == _slots.size())
+        {
+            // Every slot is in use, so open a new one where the next frame goes. The
+            // oldest frame sits at the same index when the queue is full and moves up.
+            _slots.insert(_slots.begin() + static_cast<std::ptrdiff_t>(_head), std::make_unique<QueuedFrame>());
+            if (_count > 0 && _tail >= _head)
+            {
+                _tail++;
+            }
+        }
+        QueuedFrame& frame = *_slots[_head];
+        _head = (_head + 1) % _slots.size();
+        _count++;
+        return frame;
+    }
+
+    void ReadAheadBuffer::threadFunc()
+    {
+        while(true)
+        {
+            QueuedFrame* frame;
+            std::function<void()> marker;
+            bool flushDownstream;
+            {
+                std::unique_lock<std::mutex> lk(_queueMutex);
+                _dataWait.wait(lk, [this]
+                {
+                    return _shutdown || (!_paused && _count > 0);
+                });
+                if (_shutdown)
+                {
+                    break;
+                }
+                // The slot stays counted while it's processed, so the decoder can't
+                // reuse it and flush() leaves it alone
+                frame = _slots[_tail].get();
+                _inFlight = true;
+                flushDownstream = _passedEpoch != _epoch;
+                _passedEpoch = _epoch;
+                if (frame->marker)
+                {
+                    marker = std::move(_markers.front());
+                    _markers.pop();
+                }
+            }
+
+            if (flushDownstream && _sink)
+            {
+                _sink->flush();
+            }
+            if (frame->eos)
+            {
+                eos();
+            }
+            else if (frame->marker)
+            {
+                marker();
+            }
+            else if (_sink)
+            {
+                _sink->audio(frame->data.data(), frame->planar ? frame->planarData.data() : nullptr, frame->sampleCount);
+            }
+
+            {
+                std::unique_lock<std::mutex> lk(_queueMutex);
+                _inFlight = false;
+                _tail = (_tail + 1) % _slots.size();
+                _count--;
+                _queuedSamples -= frame->sampleCount;
+                updateStats();
+            }
+            _spaceWait.notify_all();
+        }
+    }
+
+    void ReadAheadBuffer::setPaused(bool paused)
+    {
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            _paused = paused;
+        }
+        _dataWait.notify_one();
+    }
+
+    void ReadAheadBuffer::flush()
+    {
+        std::queue<std::function<void()>> markers;
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            _epoch++;
+            if (_count == 0)
+            {
+                return;
+            }
+            // The frame being passed downstream is released by the thread when it's
+            // done. A marker being passed has already left _markers.
+            std::swap(markers, _markers);
+            _count = _inFlight ? 1 : 0;
+            _queuedSamples = _inFlight ? _slots[_tail]->sampleCount : 0;
+            _head = (_tail + _count) % _slots.size();
+            updateStats();
+        }
+        _spaceWait.notify_all();
+
+        // The points they mark have been skipped past, not lost
+        while(!markers.empty())
+        {
+            markers.front()();
+            markers.pop();
+        }
+    }
+
+    void ReadAheadBuffer::waitUntilDrained()
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _spaceWait.wait(lk, [this]
+        {
+            return _shutdown || _count == 0;
+        });
+    }
+
+    void ReadAheadBuffer::shutdown()
+    {
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            _shutdown = true;
+        }
+        _dataWait.notify_all();
+        _spaceWait.notify_all();
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+    void ReadAheadBuffer::updateStats()
+    {
+        if (!_stats)
+        {
+            return;
+        }
+        _stats->readAheadFrames.store(_count, std::memory_order_relaxed);
+        _stats->readAheadMs.store(_sourceSampleRate != 0 ? _queuedSamples * 1000 / _sourceSampleRate : 0, std::memory_order_relaxed);
+    }
+}
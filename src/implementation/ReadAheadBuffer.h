@@ -0,0 +1,111 @@
+#pragma once
+
+#include <interfaces/IAudioSink.h>
+#include <interfaces/IAudioSource.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace CasperTech
+{
+    // Decouples decoding from the render clock. The decoder's frames are copied into
+    // a queue holding up to lengthMs of audio, and a thread of its own feeds them to
+    // the rest of the pipeline, so the decoder can run ahead and a slow packet or
+    // disk read is absorbed by the queue instead of the output buffer.
+    class ReadAheadBuffer: public IAudioSink, public IAudioSource
+    {
+        public:
+            explicit ReadAheadBuffer(uint32_t lengthMs);
+            ~ReadAheadBuffer() override;
+
+            /* <IAudioNode> */
+            SampleFormatFlags getSupportedSampleFormats() override;
+            std::vector<uint32_t> getSupportedSampleRates() override;
+            uint8_t getSupportedChannels() override;
+            std::string getName() const override;
+            /* </IAudioNode> */
+
+            /* <IAudioSink> */
+            // Blocks while the queue is full
+            void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
+            void onSourceConfigured() override;
+            void onEos() override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
+            /* </IAudioSink> */
+
+            /* <IAudioSource> */
+            void onSinkConfigured() override;
+            /* </IAudioSource> */
+
+            // While paused queued audio is held back, and the decoder stops once the
+            // queue is full
+            void setPaused(bool paused);
+
+            // Calls callback from the feeding thread once everything queued before it
+            // has been passed downstream, marking a point in the stream such as a
+            // track boundary. Markers still queued when the buffer is flushed are
+            // called straight away.
+            void addMarker(std::function<void()> callback);
+
+            // Drops everything queued. The stages downstream are flushed by the feeding
+            // thread before it passes on anything queued afterwards, which also
+            // catches a frame that was already on its way down.
+            void flush() override;
+
+            // Returns once everything queued has been passed downstream
+            void waitUntilDrained();
+
+            // Stops the feeding thread and releases anyone waiting. Audio arriving
+            // afterwards is dropped. Called by the destructor.
+            void shutdown();
+
+        private:
+            // Slots are allocated for the whole queue when the first frame arrives and
+            // reused round it, keeping their buffers' capacity, so steady playback
+            // doesn't allocate
+            struct QueuedFrame
+            {
+                std::vector<uint8_t> data;
+                std::vector<uint8_t> planarData;
+                uint64_t sampleCount = 0;
+                bool planar = false;
+                bool eos = false;
+                bool marker = false;
+            };
+
+            void threadFunc();
+            void preallocate(uint64_t sampleCount, uint64_t bytes, bool planar);
+            QueuedFrame& pushSlot();
+            void updateStats();
+
+            uint32_t _lengthMs;
+            uint64_t _capacitySamples = 0;
+            uint8_t _sampleSize = 0;
+
+            std::mutex _queueMutex;
+            std::condition_variable _dataWait;
+            std::condition_variable _spaceWait;
+            std::vector<std::unique_ptr<QueuedFrame>> _slots;
+            std::queue<std::function<void()>> _markers;
+            size_t _head = 0;
+            size_t _tail = 0;
+            size_t _count = 0;
+            uint64_t _queuedSamples = 0;
+            bool _inFlight = false;
+            // Advanced by flush(). The feeding thread flushes downstream when the
+            // next thing it takes was queued in a later epoch than the last.
+            uint64_t _epoch = 0;
+            uint64_t _passedEpoch = 0;
+            bool _paused = false;
+            bool _shutdown = false;
+
+            bool _sinkConfigured = false;
+            bool _sourceConfigured = false;
+            std::thread _thread;
+    };
+}
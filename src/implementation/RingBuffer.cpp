@@ -1,229 +1,257 @@
 #include "RingBuffer.h"
 
-#include <memory>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <thread>
 
 namespace CasperTech
 {
-    RingBuffer::RingBuffer(size_t size)
-            : _buf(std::make_unique<uint8_t[]>(size))
-            , _maxSize(size)
+    // The consumer never signals the producer (that would mean a syscall on the audio
+    // thread), so a full producer re-checks for space at this interval instead.
+    static constexpr std::chrono::microseconds putPollInterval(500);
+    static constexpr uint32_t putSpinCount = 64;
+
+    RingBuffer::RingBuffer(size_t size, size_t frameSize, uint64_t position)
+            : _frameSize(frameSize == 0 ? 1 : frameSize)
+            , _capacityFrames(roundUpPow2((size + _frameSize - 1) / _frameSize))
+            , _mask(_capacityFrames - 1)
+            , _buf(std::make_unique<uint8_t[]>(_capacityFrames * _frameSize))
+            , _head(position)
+            , _tail(position)
     {
 
     }
 
+    size_t RingBuffer::roundUpPow2(size_t value)
+    {
+        size_t result = 1;
+        while(result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
     void RingBuffer::reset()
     {
         shutdown();
-        
-        std::lock_guard<std::mutex> lock(_mutex);
-        _head = _tail;
-        _eos = -1;
-        _shutdownGet = false;
-        _shutdownPut = false;
-        _full = false;
+
+        // Both sides are parked now, so the positions can be rewritten safely. A
+        // consumer arriving meanwhile finds the ring shut down and releases nothing,
+        // but still checks its tail against _eos, so the end is cleared before the
+        // tail moves up to it.
+        _eos.store(noEos);
+        _tail.store(_head.load(std::memory_order_relaxed), std::memory_order_release);
+        _shutdown.store(false);
+
+        // One that read _eos before it was cleared may yet mark the end reached, so
+        // the flag is only cleared once it has finished
+        while(_runningGet.load())
+        {
+            std::this_thread::yield();
+        }
+        _eosReached.store(false);
     }
 
     bool RingBuffer::empty() const
     {
-        return (!_full && (_head == _tail));
+        return size() == 0;
     }
 
     bool RingBuffer::full() const
     {
-        return _full;
+        return size() == capacity();
     }
 
     void RingBuffer::shutdown()
     {
-        std::unique_lock<std::mutex> shutdownGetLock(_shutdownGetMutex);
-        std::unique_lock<std::mutex> shutdownPutLock(_shutdownPutMutex);
-        if (_runningPut)
         {
-            _shutdownPut = true;
-            _wait.notify_all();
-            _shutdownPutWait.wait(shutdownPutLock);
+            std::unique_lock<std::mutex> lk(_putMutex);
+            _shutdown.store(true);
+            _putWait.notify_all();
+            _putWait.wait(lk, [this]
+            {
+                return !_runningPut.load();
+            });
         }
-        if (_runningGet)
+
+        // The consumer never blocks between peek() and release(), so an in-flight read
+        // is at most one memcpy away from done.
+        while(_runningGet.load())
         {
-            _shutdownGet = true;
-            _wait.notify_all();
-            _shutdownGetWait.wait(shutdownGetLock);
+            std::this_thread::yield();
         }
     }
 
     size_t RingBuffer::capacity() const
     {
-        return _maxSize;
+        return _capacityFrames * _frameSize;
     }
 
     size_t RingBuffer::size() const
     {
-        size_t size = _maxSize;
+        const uint64_t tail = _tail.load(std::memory_order_acquire);
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        return static_cast<size_t>(head - tail) * _frameSize;
+    }
 
-        if(!_full)
-        {
-            if(_head >= _tail)
-            {
-                size = _head - _tail;
-            }
-            else
-            {
-                size = _maxSize + _head - _tail;
-            }
-        }
+    uint64_t RingBuffer::writePosition() const
+    {
+        return _head.load(std::memory_order_acquire);
+    }
 
-        return size;
+    uint64_t RingBuffer::readPosition() const
+    {
+        return _tail.load(std::memory_order_acquire);
     }
 
-    void RingBuffer::put(const uint8_t* buf, size_t bytes)
+    RingSpans RingBuffer::spansAt(uint64_t pos, size_t frames)
     {
+        const size_t offset = static_cast<size_t>(pos & _mask);
+        const size_t firstFrames = std::min(frames, _capacityFrames - offset);
+
+        RingSpans spans;
+        spans.first = { &_buf[offset * _frameSize], firstFrames * _frameSize };
+        if (firstFrames < frames)
         {
-            std::unique_lock<std::mutex> lk(_shutdownPutMutex);
-            _runningPut = true;
-        }
-        _eos = -1;
-        if (bytes == 0)
-        {
-            return;
+            spans.second = { &_buf[0], (frames - firstFrames) * _frameSize };
         }
-        std::unique_lock<std::mutex> lock(_mutex);
-        size_t srcBufPos = 0;
-        size_t destBufPos = _head;
-        size_t bytesLeft = bytes;
-        while(srcBufPos < bytes)
+        return spans;
+    }
+
+    RingSpans RingBuffer::reserve(size_t bytes)
+    {
+        _runningPut.store(true);
+        _eos.store(noEos, std::memory_order_relaxed);
+
+        const size_t wanted = bytes / _frameSize;
+        uint32_t spins = 0;
+        while(wanted > 0 && !_shutdown.load())
         {
-            while(_full && !_shutdownPut)
+            const uint64_t head = _head.load(std::memory_order_relaxed);
+            const uint64_t tail = _tail.load(std::memory_order_acquire);
+            const size_t space = _capacityFrames - static_cast<size_t>(head - tail);
+            if (space == 0)
             {
-                _wait.wait(lock, [this]
+                // A consumer that is actively draining frees space within a few
+                // yields; only fall back to sleeping when it isn't.
+                if (spins++ < putSpinCount)
                 {
-                    return !_full || _shutdownPut;
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lk(_putMutex);
+                _putWait.wait_for(lk, putPollInterval, [this]
+                {
+                    return _shutdown.load() || !full();
                 });
+                continue;
             }
-            if (_shutdownPut)
-            {
-#ifdef _DEBUG
-                std::cout << "shutdown" << std::endl;
-#endif
-                break;
-            }
+            return spansAt(head, std::min(space, wanted));
+        }
+        return {};
+    }
 
-            size_t space = _maxSize - size();
-            size_t bytesToWrite = bytesLeft;
-            if (bytesToWrite > space)
-            {
-                bytesToWrite = space;
-            }
+    void RingBuffer::commit(size_t bytes)
+    {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        _head.store(head + bytes / _frameSize, std::memory_order_release);
 
-            if (destBufPos + bytesToWrite > _maxSize)
-            {
-                size_t bytesRemaining = _maxSize - destBufPos;
-                memcpy(&_buf[destBufPos], buf + srcBufPos, bytesRemaining);
-                destBufPos = 0;
-                srcBufPos += bytesRemaining;
-                bytesLeft -= bytesRemaining;
-                bytesToWrite -= bytesRemaining;
-            }
-            memcpy(&_buf[destBufPos], buf + srcBufPos, bytesToWrite);
-            destBufPos += bytesToWrite;
-            if (destBufPos >= _maxSize)
-            {
-                destBufPos -= _maxSize;
-            }
-            srcBufPos += bytesToWrite;
-            bytesLeft -= bytesToWrite;
+        std::unique_lock<std::mutex> lk(_putMutex);
+        _runningPut.store(false);
+        _putWait.notify_all();
+    }
 
-            _head = destBufPos;
-            _full = _head == _tail;
-            _wait.notify_one();
+    RingSpans RingBuffer::peek(size_t bytes)
+    {
+        _runningGet.store(true);
+        if (_shutdown.load() || _eosReached.load(std::memory_order_relaxed))
+        {
+            return {};
         }
-        std::unique_lock<std::mutex> lk(_shutdownPutMutex);
-        _runningPut = false;
-        if (_shutdownPut)
+
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        const uint64_t eos = _eos.load(std::memory_order_acquire);
+
+        uint64_t available = head - tail;
+        if (eos != noEos && eos - tail < available)
         {
-            _shutdownPutWait.notify_all();
+            available = eos - tail;
         }
+        return spansAt(tail, static_cast<size_t>(std::min<uint64_t>(available, bytes / _frameSize)));
     }
 
-    int RingBuffer::get(uint8_t* buf, size_t bytes)
+    void RingBuffer::release(size_t bytes)
     {
+        // An empty release leaves the tail alone, so a reset() racing with a
+        // consumer that found the ring shut down can't have its tail overwritten
+        const uint64_t tail = _tail.load(std::memory_order_relaxed) + bytes / _frameSize;
+        if (bytes >= _frameSize)
         {
-            std::unique_lock<std::mutex> lk(_shutdownGetMutex);
-            _runningGet = true;
+            _tail.store(tail, std::memory_order_release);
         }
-        if (bytes == 0)
+
+        const uint64_t eos = _eos.load(std::memory_order_acquire);
+        if (eos != noEos && tail == eos)
         {
-            return 0;
+            _eosReached.store(true, std::memory_order_relaxed);
         }
-        std::unique_lock<std::mutex> lock(_mutex);
-        size_t srcBufPos = _tail;
-        size_t destBufPos = 0;
-        size_t bytesLeft = bytes;
-        while(destBufPos < bytes)
+        _runningGet.store(false);
+    }
+
+    void RingBuffer::put(const uint8_t* buf, size_t bytes)
+    {
+        while(bytes >= _frameSize)
         {
-            if(size() == 0 && !_shutdownGet)
-            {
-                {
-                    memset(&buf[destBufPos], 0, bytes - destBufPos);
-                    break;
-                }
-            }
-            if (_shutdownGet)
+            const RingSpans spans = reserve(bytes);
+            if (spans.size() == 0)
             {
 #ifdef _DEBUG
                 std::cout << "shutdown" << std::endl;
 #endif
-                _runningGet = false;
-                break;
-            }
-
-            size_t bytesToWrite = size();
-            if (bytesToWrite > bytesLeft)
-            {
-                bytesToWrite = bytesLeft;
-            }
-            if(_tail + bytesToWrite > _maxSize)
-            {
-                size_t remainingBytes = _maxSize - _tail;
-                memcpy(&buf[destBufPos], &_buf[srcBufPos], remainingBytes);
-                srcBufPos = 0;
-                destBufPos += remainingBytes;
-                bytesLeft -= remainingBytes;
-                bytesToWrite -= remainingBytes;
-            }
-            memcpy(&buf[destBufPos], &_buf[srcBufPos], bytesToWrite);
-            srcBufPos += bytesToWrite;
-            if (srcBufPos >= _maxSize)
-            {
-                srcBufPos -= _maxSize;
+                commit(0);
+                return;
             }
-            destBufPos += bytesToWrite;
-            bytesLeft -= bytesToWrite;
-            _tail = srcBufPos;
-            if (_eos > -1 && _eos == _tail)
+            memcpy(spans.first.data, buf, spans.first.size);
+            if (spans.second.size > 0)
             {
-                _shutdownGet = true;
-                _wait.notify_one();
-                return 1;
+                memcpy(spans.second.data, buf + spans.first.size, spans.second.size);
             }
-            _full = false;
-            _wait.notify_one();
+            commit(spans.size());
+
+            buf += spans.size();
+            bytes -= spans.size();
         }
-        std::unique_lock<std::mutex> lk(_shutdownGetMutex);
-        _runningGet = false;
-        if (_shutdownGet)
+    }
+
+    int RingBuffer::get(uint8_t* buf, size_t bytes)
+    {
+        const RingSpans spans = peek(bytes);
+        if (spans.first.size > 0)
+        {
+            memcpy(buf, spans.first.data, spans.first.size);
+        }
+        if (spans.second.size > 0)
         {
-            _shutdownGetWait.notify_all();
-            return 1;
+            memcpy(buf + spans.first.size, spans.second.data, spans.second.size);
         }
-        return 0;
+
+        // Anything we couldn't satisfy is played as silence rather than stale data
+        if (spans.size() < bytes)
+        {
+            memset(buf + spans.size(), 0, bytes - spans.size());
+        }
+        release(spans.size());
+
+        return (_shutdown.load() || _eosReached.load(std::memory_order_relaxed)) ? 1 : 0;
     }
 
     void RingBuffer::eos()
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _eos = static_cast<int64_t>(_head);
+        _eos.store(_head.load(std::memory_order_relaxed), std::memory_order_release);
     }
 
     RingBuffer::~RingBuffer()
@@ -1,19 +1,53 @@
+#pragma once
+
+#include <structs/RingSpans.h>
+
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 
 namespace CasperTech
 {
+    // Single producer / single consumer ring buffer.
+    //
+    // The consumer side (get) is called from the audio device callback, so it never
+    // locks, allocates or waits. The producer side (put) may block while the ring is
+    // full. Capacity is rounded up to a power of two frames so that positions can be
+    // wrapped with a mask, and reads/writes are always whole frames.
+    //
+    // Besides the copying put/get, both sides can work on ring memory in place:
+    // the producer reserve()s space, writes into it and commit()s, the consumer
+    // peek()s at queued data and release()s it once read. Every reserve must be
+    // followed by a commit and every peek by a release, even if nothing was used.
     class RingBuffer
     {
         public:
-            explicit RingBuffer(size_t size);
+            // Positions count on from position, so a ring replacing another can carry
+            // on where it left off
+            explicit RingBuffer(size_t size, size_t frameSize = 1, uint64_t position = 0);
             ~RingBuffer();
 
             void put(const uint8_t* buf, size_t size);
 
             int get(uint8_t* buf, size_t size);
 
+            // Blocks until there is room for at least one frame, then returns up to
+            // size bytes of writable space. Returns no space if the ring is shut down.
+            RingSpans reserve(size_t size);
+
+            // Publishes size bytes (which may be less than reserved) to the consumer.
+            void commit(size_t size);
+
+            // Never blocks. Returns up to size bytes of queued data, stopping at eos.
+            RingSpans peek(size_t size);
+
+            // Frees size bytes (which may be less than peeked) for the producer.
+            void release(size_t size);
+
+            // Empties the ring and clears eos. The consumer may carry on reading
+            // throughout; nothing queued before the reset reaches it.
             void reset();
 
             void shutdown();
@@ -28,24 +62,37 @@ namespace CasperTech
 
             [[nodiscard]] size_t size() const;
 
+            // How many frames have been written and read since the ring was created.
+            // reset() moves the read position up to the write position.
+            [[nodiscard]] uint64_t writePosition() const;
+
+            [[nodiscard]] uint64_t readPosition() const;
+
         private:
-            std::mutex _mutex;
-            std::mutex _shutdownPutMutex;
-            std::mutex _shutdownGetMutex;
-            std::condition_variable _wait;
-            std::condition_variable _shutdownPutWait;
-            std::condition_variable _shutdownGetWait;
+            static size_t roundUpPow2(size_t value);
+            RingSpans spansAt(uint64_t pos, size_t frames);
+
+            static constexpr uint64_t noEos = UINT64_MAX;
+
+            const size_t _frameSize;
+            const size_t _capacityFrames;
+            const size_t _mask;
             std::unique_ptr<uint8_t[]> _buf;
-            size_t _head = 0;
-            size_t _tail = 0;
-            int64_t _eos = -1;
-            const size_t _maxSize;
-            bool _full = false;
-            bool _shutdownPut = false;
-            bool _runningPut = false;
-            bool _shutdownGet = false;
-            bool _runningGet = false;
-    };
 
-}
+            // Head is only written by the producer, tail only by the consumer. They are
+            // kept on separate cache lines so the two threads don't false-share.
+            alignas(64) std::atomic<uint64_t> _head{0};
+            alignas(64) std::atomic<uint64_t> _tail{0};
 
+            alignas(64) std::atomic<uint64_t> _eos{noEos};
+            std::atomic<bool> _eosReached{false};
+            std::atomic<bool> _shutdown{false};
+            std::atomic<bool> _runningPut{false};
+            std::atomic<bool> _runningGet{false};
+
+            // Only used by the producer to sleep while the ring is full, and by
+            // shutdown() to wait for an in-flight reservation to be committed.
+            std::mutex _putMutex;
+            std::condition_variable _putWait;
+    };
+}
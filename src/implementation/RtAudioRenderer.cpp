@@ -1,5 +1,7 @@
 #include "RtAudioRenderer.h"
 #include "RtAudioStream.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
 
 #include <RtAudio.h>
 
@@ -42,18 +44,33 @@ namespace CasperTech
 
     void RtAudioRenderer::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
     {
+        ScopedStageTimer timer(_stats ? &_stats->render : nullptr);
         std::shared_lock<std::shared_mutex> lk(_streamMutex);
         return _currentStream->audio(buffer, planarChannel, sampleCount);
     }
 
+    bool RtAudioRenderer::reserve(uint64_t sampleCount, RingSpans& spans)
+    {
+        // Waiting for ring space is the render stage's time, not the converter's
+        ScopedStageTimer timer(_stats ? &_stats->render : nullptr);
+        std::shared_lock<std::shared_mutex> lk(_streamMutex);
+        spans = _currentStream->reserve(sampleCount);
+        return true;
+    }
+
+    void RtAudioRenderer::commit(uint64_t sampleCount)
+    {
+        std::shared_lock<std::shared_mutex> lk(_streamMutex);
+        _currentStream->commit(sampleCount);
+    }
+
     void RtAudioRenderer::onSourceConfigured()
     {
+        // The stream lives as long as the renderer. Reconnecting with the format it
+        // already plays (a new track, or the renegotiation each stage does while a
+        // chain is built) only empties its ring; the device is reopened when the
+        // format, rate, channels or selected device change.
         std::unique_lock<std::shared_mutex> lk(_streamMutex);
-        _currentStream = std::make_unique<RtAudioStream>();
-        if (_selectedDevice != -1)
-        {
-            _currentStream->selectDevice(_selectedDevice);
-        }
 
         RtAudioFormat fmt;
         switch(_sourceFormat)
@@ -86,6 +103,12 @@ namespace CasperTech
                 return;
         }
 
+        if (_currentStream->isConfigured(fmt, _sourceChannels, _sourceSampleRate))
+        {
+            _currentStream->flush();
+            return;
+        }
+
         auto frameSize = _sampleSize * _sourceChannels;
         auto bufFrames = static_cast<uint32_t>(((static_cast<float>(_sourceSampleRate) / 1000.0) * static_cast<float>(_bufferLengthMs)) / 2.0);
         auto bufSize = bufFrames * frameSize;
@@ -100,6 +123,19 @@ namespace CasperTech
         _currentStream->onEos();
     }
 
+    void RtAudioRenderer::flush()
+    {
+        std::shared_lock<std::shared_mutex> lk(_streamMutex);
+        _currentStream->flush();
+    }
+
+    void RtAudioRenderer::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        std::shared_lock<std::shared_mutex> lk(_streamMutex);
+        IAudioSink::setStats(stats);
+        _currentStream->setStats(stats);
+    }
+
     void RtAudioRenderer::selectDevice(uint32_t device)
     {
         std::shared_lock<std::shared_mutex> lk(_streamMutex);
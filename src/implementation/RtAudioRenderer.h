@@ -35,8 +35,12 @@ namespace CasperTech
 
             /* <IAudioSink> */
             void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
+            bool reserve(uint64_t sampleCount, RingSpans& spans) override;
+            void commit(uint64_t sampleCount) override;
             void onSourceConfigured() override;
             void onEos() override;
+            void flush() override;
+            void setStats(const std::shared_ptr<PipelineStats>& stats) override;
             /* </IAudioSink> */
 
         private:
@@ -1,5 +1,9 @@
 #include "RtAudioStream.h"
 #include "AudioCallbackContainer.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
 
 namespace CasperTech
 {
@@ -167,9 +171,31 @@ namespace CasperTech
     int RtAudioStream::fillBuffer(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime,
                                   RtAudioStreamStatus status)
     {
-        std::unique_lock<std::mutex> _fillBufferMutex;
+        ScopedStageTimer timer(_stats ? &_stats->callback : nullptr);
         uint64_t bytesToCopy = nBufferFrames * _sampleSize *  _sourceChannels;
-        if (_ringBuffer->get(reinterpret_cast<uint8_t*>(outputBuffer), bytesToCopy))
+        const size_t available = _ringBuffer->size();
+        const uint64_t readFrom = _ringBuffer->readPosition();
+        const int result = _ringBuffer->get(reinterpret_cast<uint8_t*>(outputBuffer), bytesToCopy);
+        if (_stats)
+        {
+            const uint64_t readTo = _ringBuffer->readPosition();
+            _stats->clock.played(readTo, readTo - readFrom);
+            _stats->callbacks.fetch_add(1, std::memory_order_relaxed);
+            _stats->ringFillBytes.store(available, std::memory_order_relaxed);
+
+            // Either the device ran out before we were called, or we ran out of
+            // audio to give it. Starvation is counted once per dry spell rather
+            // than for every silent callback that follows.
+            const bool starved = result == 0 && available < bytesToCopy;
+            const bool underflow = (status & RTAUDIO_OUTPUT_UNDERFLOW) != 0;
+            const bool playing = _stats->playingSinceNs.load(std::memory_order_relaxed) != 0;
+            const bool wasStarved = _starved.exchange(starved, std::memory_order_relaxed);
+            if (playing && (underflow || (starved && !wasStarved)))
+            {
+                _stats->recordUnderrun();
+            }
+        }
+        if (result)
         {
 #ifdef _DEBUG
             std::cout << "RingBuffer shutdown" << std::endl;
@@ -229,9 +255,37 @@ namespace CasperTech
     {
         uint64_t byteSize = sampleCount * _sampleSize * _sourceChannels;
         _ringBuffer->put(buffer, byteSize);
+        if (_stats)
+        {
+            _stats->clock.written(_ringBuffer->writePosition());
+        }
 
     }
 
+    RingSpans RtAudioStream::reserve(uint64_t sampleCount)
+    {
+        return _ringBuffer->reserve(sampleCount * _sampleSize * _sourceChannels);
+    }
+
+    void RtAudioStream::commit(uint64_t sampleCount)
+    {
+        _ringBuffer->commit(sampleCount * _sampleSize * _sourceChannels);
+        if (_stats)
+        {
+            _stats->clock.written(_ringBuffer->writePosition());
+        }
+    }
+
+    void RtAudioStream::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        _stats = stats;
+        if (_stats && _ringBuffer)
+        {
+            _stats->clock.setLatencyFrames(_latencyFrames);
+            _stats->clock.rebase(_ringBuffer->writePosition(), _openSampleRate);
+        }
+    }
+
     void RtAudioStream::shutdown()
     {
         if (_container != nullptr)
@@ -260,6 +314,26 @@ namespace CasperTech
             delete _container;
             _container = nullptr;
         }
+        _openDeviceId = -1;
+    }
+
+    bool RtAudioStream::isConfigured(RtAudioFormat fmt, uint8_t channels, uint32_t sampleRate) const
+    {
+        return _openDeviceId != -1
+               && _openDeviceId == _selectedDeviceId
+               && _openFormat == fmt
+               && _sourceChannels == channels
+               && _openSampleRate == sampleRate;
+    }
+
+    void RtAudioStream::flush()
+    {
+        _ringBuffer->reset();
+        _starved.store(true, std::memory_order_relaxed);
+        if (_stats)
+        {
+            _stats->clock.rebase(_ringBuffer->writePosition(), _openSampleRate);
+        }
     }
 
     void RtAudioStream::configure(RtAudioFormat fmt, uint8_t channels, uint32_t sampleRate, uint8_t sampleSize,
@@ -279,7 +353,15 @@ namespace CasperTech
             delete _container;
         }
 
-        _ringBuffer = std::make_unique<RingBuffer>(bufSize);
+        // The new ring counts on from the old one, keeping the playback clock's
+        // positions going forwards
+        const uint64_t position = _ringBuffer ? _ringBuffer->writePosition() : 0;
+        _ringBuffer = std::make_unique<RingBuffer>(bufSize, sampleSize * channels, position);
+        _starved.store(true, std::memory_order_relaxed);
+        if (_stats)
+        {
+            _stats->ringCapacityBytes.store(_ringBuffer->capacity(), std::memory_order_relaxed);
+        }
         RtAudio::StreamOptions options;
 #ifdef _DEBUG
         std::cout << "Starting RtAudioStream with " << unsigned(channels) << " channels, sample rate " << sampleRate << std::endl;
@@ -288,5 +370,14 @@ namespace CasperTech
         _container->rtAudioStream = this;
         _rtAudio->openStream(&params, nullptr, fmt, sampleRate, &bufFrames, &RtAudioStream::fillBufferStatic, _container, &options, nullptr);
         _rtAudio->startStream();
+        _openDeviceId = _selectedDeviceId;
+        _openFormat = fmt;
+        _openSampleRate = sampleRate;
+        _latencyFrames = static_cast<uint64_t>(std::max<long>(_rtAudio->getStreamLatency(), 0));
+        if (_stats)
+        {
+            _stats->clock.setLatencyFrames(_latencyFrames);
+            _stats->clock.rebase(position, sampleRate);
+        }
     }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "RingBuffer.h"
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <enums/SampleFormatFlags.h>
@@ -11,6 +12,7 @@
 namespace CasperTech
 {
     struct AudioCallbackContainer;
+    struct PipelineStats;
     class RtAudioStream
     {
         public:
@@ -23,7 +25,14 @@ namespace CasperTech
             void onEos();
             void shutdown();
             void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount);
+            RingSpans reserve(uint64_t sampleCount);
+            void commit(uint64_t sampleCount);
+            void setStats(const std::shared_ptr<PipelineStats>& stats);
             void configure(RtAudioFormat fmt, uint8_t channels, uint32_t sampleRate, uint8_t sampleSize, uint32_t bufFrames, uint32_t bufSize);
+            // True if the open stream already plays this format on the selected device
+            [[nodiscard]] bool isConfigured(RtAudioFormat fmt, uint8_t channels, uint32_t sampleRate) const;
+            // Empties the ring and clears any eos, leaving the stream running
+            void flush();
             [[nodiscard]] SampleFormatFlags getSupportedSampleFormats() const;
             [[nodiscard]] std::vector<uint32_t> getSupportedSampleRates() const;
             [[nodiscard]] uint8_t getSupportedChannels() const;
@@ -42,9 +51,18 @@ namespace CasperTech
             std::unique_ptr<RtAudio> _rtAudio;
             RtAudio::DeviceInfo _selectedDevice;
             std::unique_ptr<RingBuffer> _ringBuffer;
+            std::shared_ptr<PipelineStats> _stats;
+            // Set by flush() and configure() as well as the callback
+            std::atomic<bool> _starved{ true };
 
             uint8_t _sampleSize = 0;
             uint8_t _sourceChannels = 0;
+            // What the open stream was configured with, -1 when there's none
+            int _openDeviceId = -1;
+            RtAudioFormat _openFormat = 0;
+            uint32_t _openSampleRate = 0;
+            // Reported by the device once the stream is open
+            uint64_t _latencyFrames = 0;
             uint32_t _bufMs = 100;
             AudioCallbackContainer* _container = nullptr;
     };
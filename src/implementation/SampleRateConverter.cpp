@@ -2,6 +2,10 @@
 #include <exceptions/AudioException.h>
 #include "SampleRateConverter.h"
 #include "FFSource.h"
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
+
+#include <algorithm>
 
 namespace CasperTech
 {
@@ -66,35 +70,105 @@ namespace CasperTech
         {
             throw AudioException(AudioError::PipelineError, "Sink or source not yet set");
         }
+        ScopedStageTimer timer(_stats ? &_stats->resample : nullptr);
         auto dst_nb_samples = av_rescale_rnd(swr_get_delay(_swrCtx, _sourceSampleRate) + sampleCount, _sinkSampleRate, _sourceSampleRate, AV_ROUND_UP);
+
+        const uint8_t* container[2] = {
+            buffer,
+            planarChannel
+        };
+        const uint8_t** in = planarChannel != nullptr ? container : &buffer;
+
+        RingSpans spans;
+        if (_sink && _sink->reserve(dst_nb_samples, spans))
+        {
+            convertIntoSink(spans, in, static_cast<int>(sampleCount), dst_nb_samples);
+            return;
+        }
+
         if (dst_nb_samples > _maxDstSamples)
         {
-            if (_maxDstSamples != 0)
-            {
-                av_free(&_dstData[0]);
-            }
-            checkError(av_samples_alloc(reinterpret_cast<uint8_t**>(&_dstData), &_dstLineSize, _sinkChannels, static_cast<int>(dst_nb_samples), _destFormat, 1));
-            _maxDstSamples = dst_nb_samples;
+            // Output lengths wobble by a sample or two with the resampler's delay, so
+            // leave room to avoid reallocating for each new longest frame
+            allocateDst(dst_nb_samples + dst_nb_samples / 4);
         }
 
-        int samplesConverted = 0;
-        if (planarChannel != nullptr)
+        int samplesConverted = checkError(swr_convert(_swrCtx, reinterpret_cast<uint8_t**>(&_dstData), static_cast<int>(dst_nb_samples), in, static_cast<int>(sampleCount)));
+
+        if (_sink)
         {
-            const uint8_t* container[2] = {
-                buffer,
-                planarChannel
-            };
-            samplesConverted = checkError(swr_convert(_swrCtx, reinterpret_cast<uint8_t**>(&_dstData), static_cast<int>(dst_nb_samples), container, static_cast<int>(sampleCount)));
+            _sink->audio(reinterpret_cast<uint8_t*>(&_dstData[0]), nullptr, samplesConverted);
         }
-        else
+    }
+
+    void SampleRateConverter::convertIntoSink(RingSpans& spans, const uint8_t** in, int sampleCount, int64_t dstSamples)
+    {
+        // swr keeps whatever doesn't fit in the output it is given, so the first call
+        // converts into the first span and later calls (with no new input) drain the
+        // remainder into the wrapped span, and into fresh reservations if the sink
+        // had less room than we asked for.
+        const int frameSize = av_get_bytes_per_sample(_destFormat) * _sinkChannels;
+        bool drained = false;
+        while(!drained && spans.size() > 0)
+        {
+            int64_t written = 0;
+            for(RingSpan* span: { &spans.first, &spans.second })
+            {
+                if (span->size == 0)
+                {
+                    continue;
+                }
+                const int room = static_cast<int>(span->size / frameSize);
+                const int result = swr_convert(_swrCtx, &span->data, room, in, sampleCount);
+                if (result < 0)
+                {
+                    _sink->commit(written);
+                    checkError(result);
+                }
+                sampleCount = 0;
+                written += result;
+                if (result < room)
+                {
+                    drained = true;
+                    break;
+                }
+            }
+            _sink->commit(written);
+            dstSamples -= written;
+
+            if (!drained && !_sink->reserve(std::max<int64_t>(dstSamples, 1), spans))
+            {
+                // The sink stopped taking reservations part way, as RateFilter does
+                // when the rate changes, so the remainder goes through audio()
+                dstSamples = std::max<int64_t>(dstSamples, 1);
+                if (dstSamples > _maxDstSamples)
+                {
+                    allocateDst(dstSamples);
+                }
+                const int result = checkError(swr_convert(_swrCtx, reinterpret_cast<uint8_t**>(&_dstData), static_cast<int>(dstSamples), in, 0));
+                if (result > 0)
+                {
+                    _sink->audio(reinterpret_cast<uint8_t*>(&_dstData[0]), nullptr, result);
+                }
+                return;
+            }
+        }
+        if (!drained)
         {
-            samplesConverted = checkError(swr_convert(_swrCtx, reinterpret_cast<uint8_t**>(&_dstData), static_cast<int>(dst_nb_samples), const_cast<const uint8_t**>(&buffer), static_cast<int>(sampleCount)));
+            // Sink was shut down, the reservation it handed back is empty
+            _sink->commit(0);
         }
+    }
 
-        if (_sink)
+    void SampleRateConverter::allocateDst(int64_t sampleCount)
+    {
+        if (_maxDstSamples != 0)
         {
-            _sink->audio(reinterpret_cast<uint8_t*>(&_dstData[0]), nullptr, samplesConverted);
+            av_free(&_dstData[0]);
+            _maxDstSamples = 0;
         }
+        checkError(av_samples_alloc(reinterpret_cast<uint8_t**>(&_dstData), &_dstLineSize, _sinkChannels, static_cast<int>(sampleCount), _destFormat, 1));
+        _maxDstSamples = sampleCount;
     }
 
     SampleRateConverter::SampleRateConverter()
@@ -141,6 +215,9 @@ namespace CasperTech
         av_opt_set_sample_fmt(_swrCtx, "out_sample_fmt", _destFormat, 0);
 
         checkError(swr_init(_swrCtx));
+
+        // Sized for the negotiated output up front so playback doesn't allocate
+        allocateDst(initialDstSamples);
         _configured = true;
     }
 
@@ -228,6 +305,20 @@ namespace CasperTech
         }
     }
 
+    void SampleRateConverter::flush()
+    {
+        if (_configured)
+        {
+            // Reinitialising keeps the settings and empties the filter history
+            swr_close(_swrCtx);
+            checkError(swr_init(_swrCtx));
+        }
+        if (_sink)
+        {
+            _sink->flush();
+        }
+    }
+
     void SampleRateConverter::onEos()
     {
         if (_sink)
@@ -30,6 +30,8 @@ namespace CasperTech
             /* <IAudioSink> */
             void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
             void onSourceConfigured() override;
+            // Drops the input the resampler is holding back, then passes the flush on
+            void flush() override;
             /* </IAudioSink> */
 
             /* <IAudioSource> */
@@ -43,6 +45,13 @@ namespace CasperTech
             static int checkError(int errnum);
 
         private:
+            void convertIntoSink(RingSpans& spans, const uint8_t** in, int sampleCount, int64_t dstSamples);
+            void allocateDst(int64_t sampleCount);
+
+            // Output buffer length for sinks without reserve(), enough for the
+            // largest frames common decoders produce at up to 2x upsampling
+            static constexpr int64_t initialDstSamples = 8192;
+
             SwrContext* _swrCtx;
             bool _sinkConfigured = false;
             bool _inited = false;
@@ -0,0 +1,32 @@
+#include "ScopedStageTimer.h"
+#include "LatencyHistogram.h"
+
+namespace CasperTech
+{
+    // Time spent in nested timers since the innermost open timer on this thread started
+    static thread_local int64_t childNs = 0;
+
+    ScopedStageTimer::ScopedStageTimer(LatencyHistogram* histogram)
+        : _histogram(histogram)
+    {
+        if (_histogram == nullptr)
+        {
+            return;
+        }
+        _parentChildNs = childNs;
+        childNs = 0;
+        _start = std::chrono::steady_clock::now();
+    }
+
+    ScopedStageTimer::~ScopedStageTimer()
+    {
+        if (_histogram == nullptr)
+        {
+            return;
+        }
+        const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+        const int64_t own = elapsed - childNs;
+        _histogram->record(static_cast<uint64_t>(own > 0 ? own : 0));
+        childNs = _parentChildNs + elapsed;
+    }
+}
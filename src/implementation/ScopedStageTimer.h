@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace CasperTech
+{
+    class LatencyHistogram;
+
+    // Records how long a pipeline stage took into a histogram when it goes out of
+    // scope. Stages call each other, so time spent in nested timers on the same
+    // thread is subtracted: each stage records only its own work. Does nothing if
+    // given no histogram.
+    class ScopedStageTimer
+    {
+        public:
+            explicit ScopedStageTimer(LatencyHistogram* histogram);
+            ~ScopedStageTimer();
+
+        private:
+            LatencyHistogram* _histogram;
+            std::chrono::steady_clock::time_point _start;
+            int64_t _parentChildNs = 0;
+    };
+}
@@ -0,0 +1,53 @@
+#include "SeekIndex.h"
+
+namespace CasperTech
+{
+    SeekIndexCache& SeekIndexCache::shared()
+    {
+        static SeekIndexCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const SeekIndex> SeekIndexCache::find(const std::string& key)
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end())
+        {
+            return nullptr;
+        }
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return it->second->second;
+    }
+
+    void SeekIndexCache::insert(const std::string& key, std::shared_ptr<const SeekIndex> index)
+    {
+        const uint64_t size = sizeOf(*index);
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _index.find(key);
+        if (it != _index.end())
+        {
+            _bytes -= sizeOf(*it->second->second);
+            _lru.erase(it->second);
+            _index.erase(it);
+        }
+        if (size > budgetBytes)
+        {
+            return;
+        }
+        while(_bytes + size > budgetBytes && !_lru.empty())
+        {
+            _bytes -= sizeOf(*_lru.back().second);
+            _index.erase(_lru.back().first);
+            _lru.pop_back();
+        }
+        _lru.emplace_front(key, std::move(index));
+        _index[key] = _lru.begin();
+        _bytes += size;
+    }
+
+    uint64_t SeekIndexCache::sizeOf(const SeekIndex& index)
+    {
+        return index.points.size() * sizeof(SeekPoint);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CasperTech
+{
+    // Where a packet the demuxer can start reading from was found, in the
+    // stream's time base
+    struct SeekPoint
+    {
+        int64_t pos = 0;
+        int64_t timestamp = 0;
+        int size = 0;
+        int minDistance = 0;
+    };
+
+    // A file's packet positions, as far through it as they've been read
+    struct SeekIndex
+    {
+        std::vector<SeekPoint> points;
+        // Read to the end, so there's nothing further to find
+        bool complete = false;
+    };
+
+    // Process wide LRU of seek indexes, so a file loaded again seeks as quickly
+    // as it did last time without reading through it first. Keyed as ClipCache
+    // keys clips, so an edited file misses. Indexes are immutable once stored.
+    class SeekIndexCache
+    {
+        public:
+            static constexpr uint64_t budgetBytes = 16 * 1024 * 1024;
+
+            static SeekIndexCache& shared();
+
+            std::shared_ptr<const SeekIndex> find(const std::string& key);
+            // Replaces any index already held for key
+            void insert(const std::string& key, std::shared_ptr<const SeekIndex> index);
+
+        private:
+            using Entry = std::pair<std::string, std::shared_ptr<const SeekIndex>>;
+
+            static uint64_t sizeOf(const SeekIndex& index);
+
+            std::mutex _mutex;
+            // Most recently used first
+            std::list<Entry> _lru;
+            std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+            uint64_t _bytes = 0;
+    };
+}
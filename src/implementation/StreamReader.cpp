@@ -0,0 +1,140 @@
+#include "StreamReader.h"
+
+extern "C" {
+    #include <libavutil/avutil.h>
+}
+
+#include <algorithm>
+#include <cstring>
+
+namespace CasperTech
+{
+    StreamReader::StreamReader(size_t capacity, std::function<void()> onDrain)
+        : _ring(capacity)
+        , _onDrain(std::move(onDrain))
+    {
+
+    }
+
+    size_t StreamReader::write(const uint8_t* data, size_t size)
+    {
+        if (_ended.load() || _interrupted.load())
+        {
+            return 0;
+        }
+        size_t written = 0;
+        while(written < size)
+        {
+            if (_ring.full())
+            {
+                _wantsDrain.store(true);
+                // The reader may have made room since the check, in which case it
+                // could already have gone back to sleep without seeing the flag
+                if (_ring.full() || !_wantsDrain.exchange(false))
+                {
+                    break;
+                }
+                continue;
+            }
+            // Only this thread adds to the ring, so the room seen above can't shrink
+            // and reserve() won't wait
+            const RingSpans spans = _ring.reserve(std::min(size - written, _ring.capacity() - _ring.size()));
+            std::memcpy(spans.first.data, data + written, spans.first.size);
+            if (spans.second.size > 0)
+            {
+                std::memcpy(spans.second.data, data + written + spans.first.size, spans.second.size);
+            }
+            _ring.commit(spans.size());
+            written += spans.size();
+        }
+        if (written > 0)
+        {
+            wakeReader();
+        }
+        return written;
+    }
+
+    void StreamReader::end()
+    {
+        _ended.store(true);
+        wakeReader();
+    }
+
+    void StreamReader::interrupt()
+    {
+        _interrupted.store(true);
+        wakeReader();
+    }
+
+    void StreamReader::wakeReader()
+    {
+        // Taking the lock orders this against a reader between checking the ring
+        // and going to sleep
+        {
+            std::unique_lock<std::mutex> lk(_readMutex);
+        }
+        _readWait.notify_one();
+    }
+
+    int StreamReader::read(uint8_t* buffer, int size)
+    {
+        while(true)
+        {
+            if (_interrupted.load())
+            {
+                return AVERROR_EXIT;
+            }
+            const RingSpans spans = _ring.peek(static_cast<size_t>(size));
+            if (spans.size() > 0)
+            {
+                std::memcpy(buffer, spans.first.data, spans.first.size);
+                if (spans.second.size > 0)
+                {
+                    std::memcpy(buffer + spans.first.size, spans.second.data, spans.second.size);
+                }
+                _ring.release(spans.size());
+                if (_ring.size() <= _ring.capacity() / 2 && _wantsDrain.exchange(false) && _onDrain)
+                {
+                    _onDrain();
+                }
+                return static_cast<int>(spans.size());
+            }
+            _ring.release(0);
+
+            // Data written before end() is in the ring before _ended is seen
+            if (_ended.load())
+            {
+                if (!_ring.empty())
+                {
+                    continue;
+                }
+                return AVERROR_EOF;
+            }
+            std::unique_lock<std::mutex> lk(_readMutex);
+            _readWait.wait(lk, [this]
+            {
+                return !_ring.empty() || _ended.load() || _interrupted.load();
+            });
+        }
+    }
+
+    int64_t StreamReader::seek(int64_t offset, int whence)
+    {
+        return AVERROR(ENOSYS);
+    }
+
+    bool StreamReader::isSeekable() const
+    {
+        return false;
+    }
+
+    size_t StreamReader::buffered() const
+    {
+        return _ring.size();
+    }
+
+    size_t StreamReader::capacity() const
+    {
+        return _ring.capacity();
+    }
+}
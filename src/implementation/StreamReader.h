@@ -0,0 +1,60 @@
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <interfaces/IByteReader.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+namespace CasperTech
+{
+    // A file arriving a piece at a time, such as over the network. The writer
+    // copies pieces into a fixed size ring, the decoder reads them out, and the
+    // decoder can start as soon as there is enough for the demuxer to open the
+    // stream. The input can't be seeked.
+    //
+    // write() never blocks: it takes what fits and the writer waits for onDrain
+    // before offering the rest, so a writer outpacing playback is held back
+    // rather than buffered without bound.
+    class StreamReader: public IByteReader
+    {
+        public:
+            // onDrain is called from the reading thread once half the ring is free,
+            // if an earlier write() was cut short
+            StreamReader(size_t capacity, std::function<void()> onDrain);
+
+            // Writer side. Returns how many of size bytes were taken.
+            size_t write(const uint8_t* data, size_t size);
+            // No more data is coming. Reads return AVERROR_EOF once the ring is empty.
+            void end();
+
+            /* <IByteReader> */
+            // Waits for data while the ring is empty and the input hasn't ended
+            int read(uint8_t* buffer, int size) override;
+            int64_t seek(int64_t offset, int whence) override;
+            [[nodiscard]] bool isSeekable() const override;
+            void interrupt() override;
+            /* </IByteReader> */
+
+            [[nodiscard]] size_t buffered() const;
+            [[nodiscard]] size_t capacity() const;
+
+        private:
+            void wakeReader();
+
+            RingBuffer _ring;
+            std::function<void()> _onDrain;
+
+            std::atomic<bool> _ended{ false };
+            std::atomic<bool> _interrupted{ false };
+            std::atomic<bool> _wantsDrain{ false };
+
+            // Only for the reader to sleep on while the ring is empty
+            std::mutex _readMutex;
+            std::condition_variable _readWait;
+    };
+}
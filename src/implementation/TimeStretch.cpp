@@ -0,0 +1,215 @@
+#include "TimeStretch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TIME_STRETCH_X86
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TIME_STRETCH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace CasperTech
+{
+    void TimeStretch::configure(uint32_t sampleRate, uint32_t channels)
+    {
+        _channels = channels;
+        _sequenceFrames = static_cast<size_t>(sampleRate) * sequenceMs / 1000;
+        _seekFrames = static_cast<size_t>(sampleRate) * seekWindowMs / 1000;
+        _overlapFrames = std::max<size_t>(static_cast<size_t>(sampleRate) * overlapMs / 1000, 1);
+        _mid.assign(_overlapFrames * _channels, 0.0f);
+        _reference.assign(_overlapFrames * _channels, 0.0f);
+        setTempo(_tempo);
+        clear();
+    }
+
+    void TimeStretch::setTempo(double tempo)
+    {
+        _tempo = tempo;
+        _nominalSkip = tempo * static_cast<double>(_sequenceFrames - _overlapFrames);
+        // Enough for the furthest a sequence can be shifted, and for the skip past it
+        _requiredFrames = std::max(static_cast<size_t>(std::ceil(_nominalSkip)) + _overlapFrames, _sequenceFrames) + _seekFrames;
+    }
+
+    void TimeStretch::put(const float* data, size_t frames)
+    {
+        if (_inputOffset > 0)
+        {
+            _input.erase(_input.begin(), _input.begin() + static_cast<std::ptrdiff_t>(_inputOffset * _channels));
+            _inputOffset = 0;
+        }
+        _input.insert(_input.end(), data, data + frames * _channels);
+    }
+
+    void TimeStretch::process(std::vector<float>& out)
+    {
+        // Each pass outputs a sequence less its overlap with the next, and moves on
+        // through the input by that times the tempo
+        while(inputFrames() >= _requiredFrames)
+        {
+            const float* in = _input.data() + _inputOffset * _channels;
+            size_t offset;
+            if (_haveMid)
+            {
+                offset = bestOffset();
+                crossfade(out, in + offset * _channels);
+                offset += _overlapFrames;
+            }
+            else
+            {
+                append(out, in, _overlapFrames);
+                offset = _overlapFrames;
+                _haveMid = true;
+            }
+
+            const size_t middle = _sequenceFrames - 2 * _overlapFrames;
+            append(out, in + offset * _channels, middle);
+            offset += middle;
+
+            std::copy(in + offset * _channels, in + (offset + _overlapFrames) * _channels, _mid.begin());
+            for(size_t i = 0; i < _overlapFrames; i++)
+            {
+                const auto weight = static_cast<float>(i * (_overlapFrames - i));
+                for(uint32_t c = 0; c < _channels; c++)
+                {
+                    _reference[i * _channels + c] = _mid[i * _channels + c] * weight;
+                }
+            }
+
+            _skipFraction += _nominalSkip;
+            const auto skip = static_cast<size_t>(_skipFraction);
+            _skipFraction -= static_cast<double>(skip);
+            _inputOffset += skip;
+        }
+    }
+
+    void TimeStretch::drain(std::vector<float>& out)
+    {
+        const float* in = _input.data() + _inputOffset * _channels;
+        const size_t frames = inputFrames();
+        size_t offset = 0;
+        if (_haveMid)
+        {
+            if (frames >= _overlapFrames)
+            {
+                crossfade(out, in);
+                offset = _overlapFrames;
+            }
+            else
+            {
+                append(out, _mid.data(), _overlapFrames);
+            }
+        }
+        append(out, in + offset * _channels, frames - offset);
+        clear();
+    }
+
+    void TimeStretch::clear()
+    {
+        _input.clear();
+        _inputOffset = 0;
+        _haveMid = false;
+        _skipFraction = 0.0;
+    }
+
+    bool TimeStretch::empty() const
+    {
+        return !_haveMid && inputFrames() == 0;
+    }
+
+    size_t TimeStretch::inputFrames() const
+    {
+        return _channels != 0 ? _input.size() / _channels - _inputOffset : 0;
+    }
+
+    size_t TimeStretch::bestOffset() const
+    {
+        // Normalised cross-correlation with the end of the last sequence. The energy
+        // of the candidate is kept as a running sum as the window slides along.
+        const float* in = _input.data() + _inputOffset * _channels;
+        const size_t count = _overlapFrames * _channels;
+        double energy = 0.0;
+        for(size_t i = 0; i < count; i++)
+        {
+            energy += static_cast<double>(in[i]) * in[i];
+        }
+
+        size_t best = 0;
+        double bestScore = -std::numeric_limits<double>::infinity();
+        for(size_t k = 0; k < _seekFrames; k++)
+        {
+            if (k > 0)
+            {
+                const float* leaving = in + (k - 1) * _channels;
+                const float* entering = in + (k - 1 + _overlapFrames) * _channels;
+                for(uint32_t c = 0; c < _channels; c++)
+                {
+                    energy += static_cast<double>(entering[c]) * entering[c] - static_cast<double>(leaving[c]) * leaving[c];
+                }
+            }
+            const double score = correlate(_reference.data(), in + k * _channels, count) / std::sqrt(std::max(energy, 1e-9));
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best = k;
+            }
+        }
+        return best;
+    }
+
+    void TimeStretch::crossfade(std::vector<float>& out, const float* in) const
+    {
+        const float step = 1.0f / static_cast<float>(_overlapFrames);
+        for(size_t i = 0; i < _overlapFrames; i++)
+        {
+            const float t = static_cast<float>(i) * step;
+            for(uint32_t c = 0; c < _channels; c++)
+            {
+                const float from = _mid[i * _channels + c];
+                out.push_back(from + (in[i * _channels + c] - from) * t);
+            }
+        }
+    }
+
+    void TimeStretch::append(std::vector<float>& out, const float* in, size_t frames) const
+    {
+        out.insert(out.end(), in, in + frames * _channels);
+    }
+
+    float TimeStretch::correlate(const float* a, const float* b, size_t count)
+    {
+        size_t i = 0;
+        float sum = 0.0f;
+#if defined(TIME_STRETCH_X86)
+        // Two accumulators so consecutive adds don't wait on each other
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for(; i + 8 <= count; i += 8)
+        {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(TIME_STRETCH_NEON)
+        float32x4_t sum0 = vdupq_n_f32(0.0f);
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        for(; i + 8 <= count; i += 8)
+        {
+            sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+            sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        const float32x4_t total = vaddq_f32(sum0, sum1);
+        sum = (vgetq_lane_f32(total, 0) + vgetq_lane_f32(total, 1)) + (vgetq_lane_f32(total, 2) + vgetq_lane_f32(total, 3));
+#endif
+        for(; i < count; i++)
+        {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+}
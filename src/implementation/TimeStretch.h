@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CasperTech
+{
+    // Changes the tempo of packed float audio without changing its pitch (WSOLA).
+    // The input is cut into overlapping sequences which are laid end to end further
+    // apart or closer together than they were, each one shifted to where it lines
+    // up best with the end of the last so the joins don't click or beat. Sequence
+    // lengths suit speech; music with a steady beat can sound slightly rough.
+    class TimeStretch
+    {
+        public:
+            void configure(uint32_t sampleRate, uint32_t channels);
+
+            // Input consumed per frame of output, so 2 plays twice as fast
+            void setTempo(double tempo);
+
+            void put(const float* data, size_t frames);
+
+            // Appends as much output as the input so far allows to out
+            void process(std::vector<float>& out);
+
+            // Appends everything still held to out, unstretched, and starts over
+            void drain(std::vector<float>& out);
+
+            void clear();
+            [[nodiscard]] bool empty() const;
+
+            // Dot product of two float arrays. Uses SSE2 on x86 and NEON on ARM.
+            static float correlate(const float* a, const float* b, size_t count);
+
+        private:
+            size_t bestOffset() const;
+            void crossfade(std::vector<float>& out, const float* in) const;
+            void append(std::vector<float>& out, const float* in, size_t frames) const;
+            [[nodiscard]] size_t inputFrames() const;
+
+            static constexpr uint32_t sequenceMs = 40;
+            static constexpr uint32_t seekWindowMs = 15;
+            static constexpr uint32_t overlapMs = 8;
+
+            uint32_t _channels = 0;
+            size_t _sequenceFrames = 0;
+            size_t _seekFrames = 0;
+            size_t _overlapFrames = 0;
+            size_t _requiredFrames = 0;
+            double _tempo = 1.0;
+            double _nominalSkip = 0.0;
+            double _skipFraction = 0.0;
+
+            // Input not yet consumed starts _inputOffset frames in, so consuming it
+            // doesn't move the rest each time
+            std::vector<float> _input;
+            size_t _inputOffset = 0;
+            // The end of the last sequence, which the next one fades in over
+            std::vector<float> _mid;
+            bool _haveMid = false;
+            // _mid weighted towards its middle, which is what the next sequence is
+            // lined up against
+            std::vector<float> _reference;
+    };
+}
@@ -3,6 +3,12 @@
 #include "VolumeFilter.h"
 
 #include "FFSource.h"
+#include "GainKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include "PipelineStats.h"
+#include "ScopedStageTimer.h"
 
 #include <cassert>
 #include <iostream>
@@ -11,7 +17,8 @@
 
 namespace CasperTech
 {
-    VolumeFilter::VolumeFilter()
+    VolumeFilter::VolumeFilter(bool nativeGain)
+        : _nativeGainEnabled(nativeGain)
     {
         
     }
@@ -91,40 +98,101 @@ namespace CasperTech
 
     void VolumeFilter::audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
     {
-        std::unique_lock<std::mutex> lk(_pipelineMutex);
-        _frame->nb_samples = static_cast<int>(sampleCount);
-        _frame->sample_rate = _sourceSampleRate;
-        _frame->format = _avSampleFormat;
-        _frame->channel_layout = _avChannelLayout;
-        _frame->pts = _pts;
+        ScopedStageTimer timer(_stats ? &_stats->volume : nullptr);
+        applySpliceFade(buffer, planarChannel, sampleCount);
+        if (!_nativeGain)
+        {
+            filterGraphAudio(buffer, planarChannel, sampleCount);
+            return;
+        }
+
+        // The buffers are the decoder's frame, which nothing else reads, so they're
+        // scaled where they are rather than copied
+        _volume.process(sampleCount, _sourceSampleRate, [&](uint64_t offset, uint64_t frames, const GainRamp& ramp)
+        {
+            if (!ramp.isUnity())
+            {
+                applyGain(buffer, planarChannel, offset, frames, ramp);
+            }
+        });
+
+        if (_sink)
+        {
+            _sink->audio(buffer, planarChannel, sampleCount);
+        }
+    }
+
+    void VolumeFilter::applyGain(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t offset, uint64_t frames, const GainRamp& ramp)
+    {
+        if (GainKernel::isPlanar(_sourceFormat))
+        {
+            GainKernel::applyRamp(_sourceFormat, const_cast<uint8_t*>(buffer) + offset * _sampleSize, frames, 1, ramp);
+            if (planarChannel != nullptr && _sourceChannels > 1)
+            {
+                GainKernel::applyRamp(_sourceFormat, const_cast<uint8_t*>(planarChannel) + offset * _sampleSize, frames, 1, ramp);
+            }
+        }
+        else
+        {
+            GainKernel::applyRamp(_sourceFormat, const_cast<uint8_t*>(buffer) + offset * _sampleSize * _sourceChannels, frames, _sourceChannels, ramp);
+        }
+    }
+
+    void VolumeFilter::applySpliceFade(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        if (_fadePending.exchange(false, std::memory_order_acquire))
+        {
+            _fadeFrames = std::max<uint64_t>(static_cast<uint64_t>(_sourceSampleRate) * spliceFadeMs / 1000, 1);
+            _fadeFramesDone = 0;
+        }
+        if (_fadeFramesDone >= _fadeFrames || !GainKernel::supports(_sourceFormat))
+        {
+            return;
+        }
+        GainRamp ramp;
+        ramp.start = static_cast<double>(_fadeFramesDone) / static_cast<double>(_fadeFrames);
+        ramp.step = 1.0 / static_cast<double>(_fadeFrames);
+        const uint64_t frames = std::min(sampleCount, _fadeFrames - _fadeFramesDone);
+        applyGain(buffer, planarChannel, 0, frames, ramp);
+        _fadeFramesDone += frames;
+    }
+
+    void VolumeFilter::flush()
+    {
+        _fadePending.store(true, std::memory_order_release);
+        if (_sink)
+        {
+            _sink->flush();
+        }
+    }
 
-        checkError(av_frame_get_buffer(_frame, 0));
+    void VolumeFilter::filterGraphAudio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount)
+    {
+        std::unique_lock<std::mutex> lk(_pipelineMutex);
+        // The graph keeps a reference to the input until its output has been taken,
+        // after which the pool can hand the same buffers out again
+        AVFrame* input = _framePool.acquire(static_cast<int>(sampleCount));
+        input->pts = _pts;
 
-       
         int bps = av_get_bytes_per_sample(_avSampleFormat);
         if (bps != _sampleSize)
         {
             assert(false);
         }
 
-
-        _frame->extended_data[0] = const_cast<uint8_t*>(buffer);
-        _frame->extended_data[1] = const_cast<uint8_t*>(planarChannel);
-        
         if (planarChannel != nullptr)
         {
-            av_samples_copy(&_frame->extended_data[0], const_cast<uint8_t* const*>(&buffer), 0, 0, static_cast<int>(sampleCount), 1, _avSampleFormat);
-            av_samples_copy(&_frame->extended_data[1], const_cast<uint8_t* const*>(&planarChannel), 0, 0, static_cast<int>(sampleCount), 1, _avSampleFormat);
+            av_samples_copy(&input->extended_data[0], const_cast<uint8_t* const*>(&buffer), 0, 0, static_cast<int>(sampleCount), 1, _avSampleFormat);
+            av_samples_copy(&input->extended_data[1], const_cast<uint8_t* const*>(&planarChannel), 0, 0, static_cast<int>(sampleCount), 1, _avSampleFormat);
         }
         else
         {
-            av_samples_copy(&_frame->extended_data[0], const_cast<uint8_t* const*>(&buffer), 0, 0, static_cast<int>(sampleCount), _sourceChannels, _avSampleFormat);
+            av_samples_copy(&input->extended_data[0], const_cast<uint8_t* const*>(&buffer), 0, 0, static_cast<int>(sampleCount), _sourceChannels, _avSampleFormat);
         }
-        
-        
+
         _pts += _sourceSampleRate;
-        
-        checkError(av_buffersrc_add_frame(_aBufferCtx, _frame));
+
+        checkError(av_buffersrc_add_frame_flags(_aBufferCtx, input, AV_BUFFERSRC_FLAG_KEEP_REF));
         int err = 0;
         while ((err = av_buffersink_get_frame(_aBufferSinkCtx, _frame)) >= 0)
         {
@@ -196,12 +264,19 @@ namespace CasperTech
 
     void VolumeFilter::init()
     {
+        std::unique_lock<std::mutex> lk(_pipelineMutex);
         if (_filterGraph != nullptr)
         {
             avfilter_graph_free(&_filterGraph);
             av_frame_free(&_frame);
         }
 
+        _nativeGain = _nativeGainEnabled && GainKernel::supports(_sourceFormat);
+        if (_nativeGain)
+        {
+            return;
+        }
+
         _filterGraph = avfilter_graph_alloc();
         if (!_filterGraph)
         {
@@ -233,6 +308,7 @@ namespace CasperTech
 
         checkError(avfilter_init_str(_aBufferCtx, NULL));
 
+        _framePool.configure(_avSampleFormat, _sourceChannels, _sourceSampleRate);
         _frame = av_frame_alloc();
         if (!_frame)
         {
@@ -251,7 +327,7 @@ namespace CasperTech
             throw AudioException(AudioError::PipelineError, "Unable to create abuffer filter context");
         }
 
-        std::string vol = std::to_string(_volume);
+        std::string vol = std::to_string(_volume.volume());
         checkError(av_opt_set(_volumeCtx, "volume", vol.c_str(), AV_OPT_SEARCH_CHILDREN));
         switch (_avSampleFormat)
         {
@@ -361,12 +437,16 @@ namespace CasperTech
         }
     }
 
-    void VolumeFilter::setVolume(float volume)
+    void VolumeFilter::setVolume(float volume, uint32_t rampMs, VolumeCurve curve)
     {
-        std::unique_lock<std::mutex> lk(_pipelineMutex);
-        _volume = volume;
+        _volume.set(volume, rampMs, curve);
 
-        std::string vol = std::to_string(_volume);
-        checkError(avfilter_graph_send_command(_filterGraph, "volume", "volume", vol.c_str(), NULL, 0, 0));
+        // The filter graph can only step to the new volume
+        std::unique_lock<std::mutex> lk(_pipelineMutex);
+        if (_filterGraph != nullptr)
+        {
+            std::string vol = std::to_string(volume);
+            checkError(avfilter_graph_send_command(_filterGraph, "volume", "volume", vol.c_str(), NULL, 0, 0));
+        }
     }
 }
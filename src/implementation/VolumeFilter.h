@@ -1,5 +1,12 @@
 #pragma once
 
+#include "FramePool.h"
+#include "GainKernel.h"
+#include "VolumeRamp.h"
+
+#include <enums/VolumeCurve.h>
+
+#include <atomic>
 #include <interfaces/IAudioSink.h>
 #include <interfaces/IAudioSource.h>
 
@@ -12,14 +19,16 @@ extern "C" {
 #include "libavutil/samplefmt.h"
 }
 
-#include <atomic>
-
 namespace CasperTech
 {
+    // Applies the player volume. Formats GainKernel covers are scaled in place on
+    // the caller's buffer, and volume changes can ramp sample by sample. Anything
+    // else goes through a libavfilter volume graph, where changes are immediate.
     class VolumeFilter: public IAudioSink, public IAudioSource
     {
         public:
-            VolumeFilter();
+            // nativeGain = false forces the filter graph for every format
+            explicit VolumeFilter(bool nativeGain = true);
 
             ~VolumeFilter() override;
 
@@ -35,6 +44,9 @@ namespace CasperTech
             /* <IAudioSink> */
             void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) override;
             void onSourceConfigured() override;
+            // Passes the flush on, and fades in whatever follows so the jump to it
+            // doesn't click
+            void flush() override;
             /* </IAudioSink> */
 
             /* <IAudioSource> */
@@ -42,7 +54,9 @@ namespace CasperTech
             void onEos() override;
             /* </IAudioSource> */
 
-            void setVolume(float volume);
+            // Safe to call from any thread. Takes effect from the start of the next
+            // block, reaching volume rampMs later.
+            void setVolume(float volume, uint32_t rampMs = 0, VolumeCurve curve = VolumeCurve::Linear);
 
             void init();
 
@@ -51,9 +65,17 @@ namespace CasperTech
 
         private:
             bool isPlanar(int fmt);
+            void filterGraphAudio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount);
+            void applyGain(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t offset, uint64_t frames, const GainRamp& ramp);
+            void applySpliceFade(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount);
+
+            // Long enough to hide a cut, short enough not to soften the audio after it
+            static constexpr uint32_t spliceFadeMs = 5;
 
             std::mutex _pipelineMutex;
 
+            // Input frames for the filter graph, and the frame its output is read into
+            FramePool _framePool;
             AVFrame* _frame;
             AVFilterGraph* _filterGraph = nullptr;
             const AVFilter* _aBufferFilter = nullptr;
@@ -66,8 +88,14 @@ namespace CasperTech
             uint64_t _avChannelLayout;
             uint64_t _pts = 0;
             uint8_t _sampleSize = 0;
-            float _volume = 1.0;
-
+            VolumeRamp _volume;
+            // Set by flush(), picked up by the next audio() call
+            std::atomic<bool> _fadePending{ false };
+            uint64_t _fadeFrames = 0;
+            uint64_t _fadeFramesDone = 0;
+
+            bool _nativeGainEnabled;
+            bool _nativeGain = false;
 
             bool _sinkConfigured = false;
             bool _sourceConfigured = false;
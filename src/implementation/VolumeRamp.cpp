@@ -0,0 +1,66 @@
+#include "VolumeRamp.h"
+
+#include <cmath>
+
+namespace CasperTech
+{
+    void VolumeRamp::set(float volume, uint32_t rampMs, VolumeCurve curve)
+    {
+        {
+            std::unique_lock<std::mutex> lk(_requestMutex);
+            _requestSequence.store(_requestSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _volume.store(volume, std::memory_order_relaxed);
+            _rampMs.store(rampMs, std::memory_order_relaxed);
+            _curve.store(curve, std::memory_order_relaxed);
+            _requestSequence.store(_requestSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        _changed.store(true, std::memory_order_release);
+    }
+
+    float VolumeRamp::volume()
+    {
+        return _volume.load(std::memory_order_relaxed);
+    }
+
+    void VolumeRamp::start(uint32_t sampleRate)
+    {
+        float volume;
+        uint32_t rampMs;
+        VolumeCurve curve;
+        uint64_t sequence;
+        do
+        {
+            sequence = _requestSequence.load(std::memory_order_acquire);
+            volume = _volume.load(std::memory_order_relaxed);
+            rampMs = _rampMs.load(std::memory_order_relaxed);
+            curve = _curve.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while((sequence & 1) != 0 || sequence != _requestSequence.load(std::memory_order_relaxed));
+
+        _gainTarget = volume;
+        const uint64_t frames = static_cast<uint64_t>(rampMs) * sampleRate / 1000;
+        if (frames == 0 || _gain == _gainTarget)
+        {
+            _gain = _gainTarget;
+            _rampFramesLeft = 0;
+            return;
+        }
+
+        _ramp.exponential = curve == VolumeCurve::Exponential;
+        if (_ramp.exponential)
+        {
+            const double from = std::max(_gain, minRampGain);
+            const double to = std::max(_gainTarget, minRampGain);
+            _ramp.start = from;
+            _ramp.step = std::pow(to / from, 1.0 / static_cast<double>(frames));
+        }
+        else
+        {
+            _ramp.start = _gain;
+            _ramp.step = (_gainTarget - _gain) / static_cast<double>(frames);
+        }
+        _rampFramesLeft = frames;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "GainKernel.h"
+
+#include <enums/VolumeCurve.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace CasperTech
+{
+    // Turns volume requests, made from any thread, into per frame gain ramps for
+    // the thread processing the audio. A new request takes over from wherever the
+    // current ramp has got to.
+    class VolumeRamp
+    {
+        public:
+            // Takes effect from the start of the next process() call, reaching volume
+            // rampMs later
+            void set(float volume, uint32_t rampMs = 0, VolumeCurve curve = VolumeCurve::Linear);
+
+            // The most recently requested volume
+            [[nodiscard]] float volume();
+
+            // Audio thread only. Covers the next frames frames with at most two calls
+            // of apply(offset, frames, ramp), the rest of a ramp then a constant gain.
+            template<typename Apply>
+            void process(uint64_t frames, uint32_t sampleRate, Apply&& apply)
+            {
+                if (_changed.exchange(false, std::memory_order_acquire))
+                {
+                    start(sampleRate);
+                }
+
+                uint64_t done = 0;
+                if (_rampFramesLeft > 0)
+                {
+                    done = std::min(frames, _rampFramesLeft);
+                    apply(static_cast<uint64_t>(0), done, _ramp);
+                    _ramp.start = _ramp.at(done);
+                    _rampFramesLeft -= done;
+                    _gain = _rampFramesLeft == 0 ? _gainTarget : _ramp.start;
+                }
+                if (done < frames)
+                {
+                    GainRamp constant;
+                    constant.start = _gain;
+                    apply(done, frames - done, constant);
+                }
+            }
+
+        private:
+            void start(uint32_t sampleRate);
+
+            // Exponential ramps can't start or end at silence, so they run to or from
+            // -80dB and jump the rest of the way
+            static constexpr double minRampGain = 0.0001;
+
+            // Requested by set, picked up by the next process() call. Only setters
+            // take the mutex; process() reads through the sequence counter, like
+            // PlaybackClock, so the audio thread never waits on a setter.
+            std::mutex _requestMutex;
+            std::atomic<uint64_t> _requestSequence{ 0 };
+            std::atomic<float> _volume{ 1.0f };
+            std::atomic<uint32_t> _rampMs{ 0 };
+            std::atomic<VolumeCurve> _curve{ VolumeCurve::Linear };
+            std::atomic<bool> _changed{ false };
+
+            // Only touched by the thread calling process()
+            double _gain = 1.0;
+            double _gainTarget = 1.0;
+            GainRamp _ramp;
+            uint64_t _rampFramesLeft = 0;
+    };
+}
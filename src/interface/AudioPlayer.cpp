@@ -1,12 +1,22 @@
 #include "AudioPlayer.h"
 
-#include <interface/CommandWorker.h>
+#include <interface/CommandCompletions.h>
+#include <interface/InputStream.h>
+#include <interface/ProbeJob.h>
 
 #include <implementation/AudioPlayerImpl.h>
+#include <implementation/ClipCache.h>
+#include <implementation/MemoryReader.h>
+#include <implementation/StreamReader.h>
 #include <implementation/ScopedNodeRef.h>
 
+#include <exceptions/CommandException.h>
+
 #include <memory>
 #include <structs/events/PlaybackErrorEvent.h>
+#include <structs/events/SeekedEvent.h>
+#include <structs/events/TrackChangedEvent.h>
+#include <structs/events/UnderrunEvent.h>
 
 namespace CasperTech::interface
 {
@@ -14,12 +24,21 @@ namespace CasperTech::interface
     {
         Napi::Function func = DefineClass(env, "AudioPlayer", {
                 InstanceMethod("load", &AudioPlayer::load),
+                InstanceMethod("loadBuffer", &AudioPlayer::loadBuffer),
+                InstanceMethod("loadStream", &AudioPlayer::loadStream),
+                InstanceMethod("enqueue", &AudioPlayer::enqueue),
                 InstanceMethod("play", &AudioPlayer::play),
                 InstanceMethod("stop", &AudioPlayer::stop),
                 InstanceMethod("seek", &AudioPlayer::seek),
                 InstanceMethod("pause", &AudioPlayer::pause),
                 InstanceMethod("setVolume", &AudioPlayer::setVolume),
-                InstanceMethod("setEventCallback", &AudioPlayer::setEventCallback)
+                InstanceMethod("setPlaybackRate", &AudioPlayer::setPlaybackRate),
+                InstanceMethod("setEventCallback", &AudioPlayer::setEventCallback),
+                InstanceMethod("getStats", &AudioPlayer::getStats),
+                InstanceMethod("getPosition", &AudioPlayer::getPosition),
+                StaticMethod("getClipCacheStats", &AudioPlayer::getClipCacheStats),
+                StaticMethod("setClipCacheBudget", &AudioPlayer::setClipCacheBudget),
+                StaticMethod("probe", &AudioPlayer::probe)
         });
 
         auto* constructor = new Napi::FunctionReference();
@@ -32,69 +51,200 @@ namespace CasperTech::interface
 
     AudioPlayer::AudioPlayer(const Napi::CallbackInfo& info)
             : Napi::ObjectWrap<AudioPlayer>(info),
-              _audioPlayer(std::make_shared<AudioPlayerImpl>(this))
+              _audioPlayer(std::make_shared<AudioPlayerImpl>(this, parsePlayerOptions(info))),
+              _completions(std::make_shared<CommandCompletions>(info.Env()))
     {
 
     }
 
-    Napi::Value AudioPlayer::play(const Napi::CallbackInfo& info)
+    // new AudioPlayer({ renderer: 'rtaudio' | 'mixer' | 'null' | 'file', file: string, clock: 'realtime' | 'fast', readAheadMs: number, clipCacheMaxMs: number })
+    PlayerOptions AudioPlayer::parsePlayerOptions(const Napi::CallbackInfo& info)
     {
         auto env = info.Env();
+        PlayerOptions playerOptions;
+        RendererOptions& options = playerOptions.renderer;
+        if (info.Length() <= 0 || info[0].IsUndefined())
+        {
+            return playerOptions;
+        }
+        if (!info[0].IsObject())
+        {
+            throw Napi::Error::New(env, "Options must be an object");
+        }
+        auto obj = info[0].As<Napi::Object>();
+
+        if (obj.Has("renderer"))
+        {
+            auto renderer = obj.Get("renderer").ToString().Utf8Value();
+            if (renderer == "rtaudio")
+            {
+                options.type = RendererType::RtAudio;
+            }
+            else if (renderer == "mixer")
+            {
+                options.type = RendererType::Mixer;
+            }
+            else if (renderer == "null")
+            {
+                options.type = RendererType::Null;
+            }
+            else if (renderer == "file")
+            {
+                options.type = RendererType::File;
+            }
+            else
+            {
+                throw Napi::Error::New(env, "Unknown renderer '" + renderer + "'");
+            }
+        }
+
+        if (obj.Has("clock"))
+        {
+            auto clock = obj.Get("clock").ToString().Utf8Value();
+            if (clock == "realtime")
+            {
+                options.clockMode = ClockMode::RealTime;
+            }
+            else if (clock == "fast")
+            {
+                options.clockMode = ClockMode::Unpaced;
+            }
+            else
+            {
+                throw Napi::Error::New(env, "Unknown clock mode '" + clock + "'");
+            }
+        }
+
+        if (obj.Has("file"))
+        {
+            options.fileName = obj.Get("file").ToString().Utf8Value();
+        }
+        if (options.type == RendererType::File && options.fileName.empty())
+        {
+            throw Napi::Error::New(env, "The file renderer requires a file option");
+        }
+        if (obj.Has("readAheadMs"))
+        {
+            auto readAhead = obj.Get("readAheadMs");
+            if (!readAhead.IsNumber() || readAhead.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "readAheadMs must be a positive number");
+            }
+            playerOptions.readAheadMs = readAhead.As<Napi::Number>().Uint32Value();
+        }
+        if (obj.Has("clipCacheMaxMs"))
+        {
+            auto clipCacheMaxMs = obj.Get("clipCacheMaxMs");
+            if (!clipCacheMaxMs.IsNumber() || clipCacheMaxMs.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "clipCacheMaxMs must be a positive number");
+            }
+            playerOptions.clipCacheMaxMs = clipCacheMaxMs.As<Napi::Number>().Uint32Value();
+        }
+        if (obj.Has("openTimeoutMs"))
+        {
+            auto openTimeoutMs = obj.Get("openTimeoutMs");
+            if (!openTimeoutMs.IsNumber() || openTimeoutMs.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "openTimeoutMs must be a positive number");
+            }
+            playerOptions.open.openTimeoutMs = openTimeoutMs.As<Napi::Number>().Uint32Value();
+        }
+        if (obj.Has("probeTimeoutMs"))
+        {
+            auto probeTimeoutMs = obj.Get("probeTimeoutMs");
+            if (!probeTimeoutMs.IsNumber() || probeTimeoutMs.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "probeTimeoutMs must be a positive number");
+            }
+            playerOptions.open.probeTimeoutMs = probeTimeoutMs.As<Napi::Number>().Uint32Value();
+        }
+        if (obj.Has("probeSize"))
+        {
+            auto probeSize = obj.Get("probeSize");
+            if (!probeSize.IsNumber() || probeSize.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "probeSize must be a positive number");
+            }
+            playerOptions.open.probeSize = probeSize.As<Napi::Number>().Int64Value();
+        }
+        if (obj.Has("analyzeDurationMs"))
+        {
+            auto analyzeDurationMs = obj.Get("analyzeDurationMs");
+            if (!analyzeDurationMs.IsNumber() || analyzeDurationMs.As<Napi::Number>().DoubleValue() < 0)
+            {
+                throw Napi::Error::New(env, "analyzeDurationMs must be a positive number");
+            }
+            playerOptions.open.analyzeDurationMs = analyzeDurationMs.As<Napi::Number>().Uint32Value();
+        }
+        if (obj.Has("skipStreamInfo"))
+        {
+            playerOptions.open.skipStreamInfo = obj.Get("skipStreamInfo").ToBoolean().Value();
+        }
+        if (obj.Has("formatFromExtension"))
+        {
+            playerOptions.open.formatFromExtension = obj.Get("formatFromExtension").ToBoolean().Value();
+        }
+        return playerOptions;
+    }
+
+    Napi::Value AudioPlayer::queueCommand(Napi::Env env, const std::function<void(const ResultCallback& callback)>& command)
+    {
+        // Queuing only takes the player's event lock, so it's done here on the JS
+        // thread, and the promise is settled from the control thread when the
+        // command has been carried out
         Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        ResultCallback callback = _completions->add(deferred);
+        try
+        {
+            command(callback);
+        }
+        catch(const CommandException& e)
+        {
+            callback(e.result(), e.message());
+        }
+        return deferred.Promise();
+    }
 
-        auto worker = new CommandWorker(info.Env(), deferred, [this](const ResultCallback& callback)
+    Napi::Value AudioPlayer::play(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        return queueCommand(env, [this](const ResultCallback& callback)
         {
             _audioPlayer->play(callback);
         });
-
-        worker->Queue();
-        return deferred.Promise();
     }
 
     Napi::Value AudioPlayer::stop(const Napi::CallbackInfo& info)
     {
         auto env = info.Env();
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
-
-        auto worker = new CommandWorker(info.Env(), deferred, [this](const ResultCallback& callback)
+        return queueCommand(env, [this](const ResultCallback& callback)
         {
             _audioPlayer->stop(callback);
         });
-
-        worker->Queue();
-        return deferred.Promise();
     }
 
     Napi::Value AudioPlayer::seek(const Napi::CallbackInfo& info)
     {
         auto env = info.Env();
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
         if(info.Length() <= 0 || !info[0].IsNumber())
         {
             throw Napi::Error::New(env, "Must supply a seek time in milliseconds");
         }
         int64_t ms = info[0].As<Napi::Number>().Int64Value();
-        auto worker = new CommandWorker(info.Env(), deferred, [this, ms](const ResultCallback& callback)
+        return queueCommand(env, [this, ms](const ResultCallback& callback)
         {
             _audioPlayer->seek(ms, callback);
         });
-
-        worker->Queue();
-        return deferred.Promise();
     }
 
     Napi::Value AudioPlayer::pause(const Napi::CallbackInfo& info)
     {
         auto env = info.Env();
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
-
-        auto worker = new CommandWorker(info.Env(), deferred, [this](const ResultCallback& callback)
+        return queueCommand(env, [this](const ResultCallback& callback)
         {
             _audioPlayer->pause(callback);
         });
-
-        worker->Queue();
-        return deferred.Promise();
     }
 
     Napi::Value AudioPlayer::load(const Napi::CallbackInfo& info)
@@ -106,16 +256,106 @@ namespace CasperTech::interface
         }
 
         auto fileName = info[0].As<Napi::String>().Utf8Value();
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
 
-        auto worker = new CommandWorker(info.Env(), deferred, [this, fileName](const ResultCallback& callback)
+        return queueCommand(env, [this, fileName](const ResultCallback& callback)
         {
             _audioPlayer->load(fileName, callback);
             sendStatus(PlaybackEvent::Loaded, "");
         });
+    }
 
-        worker->Queue();
-        return deferred.Promise();
+    // loadBuffer(buffer: Buffer, name?: string)
+    Napi::Value AudioPlayer::loadBuffer(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if(info.Length() <= 0 || !info[0].IsBuffer())
+        {
+            throw Napi::Error::New(env, "Must supply a Buffer parameter");
+        }
+        auto buffer = info[0].As<Napi::Buffer<uint8_t>>();
+        if (buffer.Length() == 0)
+        {
+            throw Napi::Error::New(env, "Buffer is empty");
+        }
+        std::string name;
+        if (info.Length() > 1 && info[1].IsString())
+        {
+            name = info[1].As<Napi::String>().Utf8Value();
+        }
+
+        auto reader = std::make_shared<MemoryReader>(pinBuffer(env, buffer), buffer.Length());
+
+        return queueCommand(env, [this, reader, name](const ResultCallback& callback)
+        {
+            _audioPlayer->load(reader, name, callback);
+            sendStatus(PlaybackEvent::Loaded, "");
+        });
+    }
+
+    // loadStream(stream: InputStream, name?: string)
+    Napi::Value AudioPlayer::loadStream(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if(info.Length() <= 0 || !info[0].IsObject())
+        {
+            throw Napi::Error::New(env, "Must supply an InputStream parameter");
+        }
+        std::shared_ptr<IByteReader> reader = InputStream::Unwrap(info[0].As<Napi::Object>())->getReader();
+        std::string name;
+        if (info.Length() > 1 && info[1].IsString())
+        {
+            name = info[1].As<Napi::String>().Utf8Value();
+        }
+
+        // Resolves once the demuxer has read enough of the stream to open it, which
+        // needs JS to keep writing in the meantime
+        return queueCommand(env, [this, reader, name](const ResultCallback& callback)
+        {
+            _audioPlayer->load(reader, name, callback);
+            sendStatus(PlaybackEvent::Loaded, "");
+        });
+    }
+
+    std::shared_ptr<const uint8_t> AudioPlayer::pinBuffer(Napi::Env env, const Napi::Buffer<uint8_t>& buffer)
+    {
+        // The decoder reads the Buffer's memory where it is, so the Buffer is held
+        // until the last reader lets go. That can happen on any thread, but the
+        // reference can only be dropped on this one, so the release comes back
+        // through a thread safe function.
+        auto* ref = new Napi::Reference<Napi::Buffer<uint8_t>>(Napi::Persistent(buffer));
+        auto release = Napi::ThreadSafeFunction::New(
+                env,
+                Napi::Function::New(env, [](const Napi::CallbackInfo&){}),
+                "loadBuffer",
+                0,
+                1,
+                [ref](Napi::Env)
+                {
+                    delete ref;
+                }
+        );
+        // Holding a Buffer shouldn't keep the process alive
+        release.Unref(env);
+        return std::shared_ptr<const uint8_t>(buffer.Data(), [release](const uint8_t*)
+        {
+            release.Release();
+        });
+    }
+
+    Napi::Value AudioPlayer::enqueue(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if(info.Length() <= 0 || !info[0].IsString())
+        {
+            throw Napi::Error::New(env, "Must supply a filename parameter");
+        }
+
+        auto fileName = info[0].As<Napi::String>().Utf8Value();
+
+        return queueCommand(env, [this, fileName](const ResultCallback& callback)
+        {
+            _audioPlayer->enqueue(fileName, callback);
+        });
     }
 
     Napi::Value AudioPlayer::setEventCallback(const Napi::CallbackInfo& info)
@@ -169,21 +409,202 @@ namespace CasperTech::interface
         {
             throw Napi::Error::New(env, "Volume must be <= 1.0");
         }
+        uint32_t rampMs = 0;
+        if (info.Length() > 1 && !info[1].IsUndefined())
+        {
+            if (!info[1].IsNumber() || info[1].As<Napi::Number>().DoubleValue() < 0.0)
+            {
+                throw Napi::Error::New(env, "Ramp duration must be a number of milliseconds >= 0");
+            }
+            rampMs = info[1].As<Napi::Number>().Uint32Value();
+        }
+        VolumeCurve curve = VolumeCurve::Linear;
+        if (info.Length() > 2 && !info[2].IsUndefined())
+        {
+            auto curveName = info[2].ToString().Utf8Value();
+            if (curveName == "exponential")
+            {
+                curve = VolumeCurve::Exponential;
+            }
+            else if (curveName != "linear")
+            {
+                throw Napi::Error::New(env, "Curve must be 'linear' or 'exponential'");
+            }
+        }
 
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
 
-        auto worker = new CommandWorker(info.Env(), deferred, [this, volume](const ResultCallback& callback)
+        return queueCommand(env, [this, volume, rampMs, curve](const ResultCallback& callback)
         {
-            _audioPlayer->setVolume(volume, callback);
+            _audioPlayer->setVolume(volume, rampMs, curve, callback);
         });
+    }
 
-        worker->Queue();
-        return deferred.Promise();
+    Napi::Value AudioPlayer::setPlaybackRate(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if(info.Length() <= 0 || !info[0].IsNumber())
+        {
+            throw Napi::Error::New(env, "Must supply a rate parameter");
+        }
+        double rate = info[0].As<Napi::Number>().DoubleValue();
+        if (!(rate >= RateFilter::minRate && rate <= RateFilter::maxRate))
+        {
+            throw Napi::Error::New(env, "Rate must be between 0.5 and 2.0");
+        }
+        PlaybackRateMode mode = PlaybackRateMode::TimeStretch;
+        if (info.Length() > 1 && !info[1].IsUndefined())
+        {
+            auto modeName = info[1].ToString().Utf8Value();
+            if (modeName == "varispeed")
+            {
+                mode = PlaybackRateMode::Varispeed;
+            }
+            else if (modeName != "timestretch")
+            {
+                throw Napi::Error::New(env, "Mode must be 'varispeed' or 'timestretch'");
+            }
+        }
+
+
+        return queueCommand(env, [this, rate, mode](const ResultCallback& callback)
+        {
+            _audioPlayer->setPlaybackRate(rate, mode, callback);
+        });
     }
 
-    AudioPlayer::~AudioPlayer()
+    Napi::Object AudioPlayer::histogramToObject(Napi::Env env, const HistogramSnapshot& histogram)
+    {
+        auto obj = Napi::Object::New(env);
+        obj.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count)));
+        obj.Set("minNs", Napi::Number::New(env, static_cast<double>(histogram.minNs)));
+        obj.Set("maxNs", Napi::Number::New(env, static_cast<double>(histogram.maxNs)));
+        obj.Set("meanNs", Napi::Number::New(env, histogram.meanNs));
+        obj.Set("p50Ns", Napi::Number::New(env, static_cast<double>(histogram.p50Ns)));
+        obj.Set("p90Ns", Napi::Number::New(env, static_cast<double>(histogram.p90Ns)));
+        obj.Set("p99Ns", Napi::Number::New(env, static_cast<double>(histogram.p99Ns)));
+        obj.Set("p999Ns", Napi::Number::New(env, static_cast<double>(histogram.p999Ns)));
+        return obj;
+    }
+
+    Napi::Value AudioPlayer::getStats(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+
+        // Reads a handful of atomics, so this is answered synchronously rather than
+        // queued behind other commands on the control thread
+        PipelineStatsSnapshot stats = _audioPlayer->getStats();
+
+        auto stages = Napi::Object::New(env);
+        stages.Set("decode", histogramToObject(env, stats.decode));
+        stages.Set("readAhead", histogramToObject(env, stats.readAhead));
+        stages.Set("volume", histogramToObject(env, stats.volume));
+        stages.Set("resample", histogramToObject(env, stats.resample));
+        stages.Set("rate", histogramToObject(env, stats.rate));
+        stages.Set("render", histogramToObject(env, stats.render));
+        stages.Set("callback", histogramToObject(env, stats.callback));
+
+        auto result = Napi::Object::New(env);
+        result.Set("stages", stages);
+        result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+        result.Set("samples", Napi::Number::New(env, static_cast<double>(stats.samples)));
+        result.Set("callbacks", Napi::Number::New(env, static_cast<double>(stats.callbacks)));
+        result.Set("underruns", Napi::Number::New(env, static_cast<double>(stats.underruns)));
+        result.Set("ringFillBytes", Napi::Number::New(env, static_cast<double>(stats.ringFillBytes)));
+        result.Set("ringCapacityBytes", Napi::Number::New(env, static_cast<double>(stats.ringCapacityBytes)));
+        result.Set("lastUnderrunMs", Napi::Number::New(env, static_cast<double>(stats.lastUnderrunMs)));
+        result.Set("readAheadFrames", Napi::Number::New(env, static_cast<double>(stats.readAheadFrames)));
+        result.Set("readAheadMs", Napi::Number::New(env, static_cast<double>(stats.readAheadMs)));
+        result.Set("readAheadCapacityMs", Napi::Number::New(env, static_cast<double>(stats.readAheadCapacityMs)));
+        return result;
+    }
+
+    Napi::Value AudioPlayer::getPosition(const Napi::CallbackInfo& info)
     {
+        // Read straight from the playback clock, like getStats, so polling it
+        // every frame doesn't queue anything
+        return Napi::Number::New(info.Env(), _audioPlayer->getPositionMs());
+    }
 
+    Napi::Value AudioPlayer::getClipCacheStats(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        ClipCacheStats stats = ClipCache::shared().getStats();
+
+        auto result = Napi::Object::New(env);
+        result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+        result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+        result.Set("evictions", Napi::Number::New(env, static_cast<double>(stats.evictions)));
+        result.Set("entries", Napi::Number::New(env, static_cast<double>(stats.entries)));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+        result.Set("budgetBytes", Napi::Number::New(env, static_cast<double>(stats.budgetBytes)));
+        return result;
+    }
+
+    Napi::Value AudioPlayer::setClipCacheBudget(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0)
+        {
+            throw Napi::Error::New(env, "Budget must be a positive number of bytes");
+        }
+        ClipCache::shared().setBudget(static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue()));
+        return env.Undefined();
+    }
+
+    // AudioPlayer.probe(paths: string[], { threads: number, cacheFile: string })
+    Napi::Value AudioPlayer::probe(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if (info.Length() < 1 || !info[0].IsArray())
+        {
+            throw Napi::Error::New(env, "Paths must be an array of strings");
+        }
+        auto array = info[0].As<Napi::Array>();
+        std::vector<std::string> paths;
+        paths.reserve(array.Length());
+        for(uint32_t i = 0; i < array.Length(); i++)
+        {
+            auto path = array.Get(i);
+            if (!path.IsString())
+            {
+                throw Napi::Error::New(env, "Paths must be an array of strings");
+            }
+            paths.push_back(path.As<Napi::String>().Utf8Value());
+        }
+
+        ProbeOptions options;
+        if (info.Length() > 1 && !info[1].IsUndefined())
+        {
+            if (!info[1].IsObject())
+            {
+                throw Napi::Error::New(env, "Options must be an object");
+            }
+            auto obj = info[1].As<Napi::Object>();
+            if (obj.Has("threads"))
+            {
+                auto threads = obj.Get("threads");
+                if (!threads.IsNumber() || threads.As<Napi::Number>().DoubleValue() < 0)
+                {
+                    throw Napi::Error::New(env, "threads must be a positive number");
+                }
+                options.threads = threads.As<Napi::Number>().Uint32Value();
+            }
+            if (obj.Has("cacheFile"))
+            {
+                auto cacheFile = obj.Get("cacheFile");
+                if (!cacheFile.IsString())
+                {
+                    throw Napi::Error::New(env, "cacheFile must be a string");
+                }
+                options.cacheFile = cacheFile.As<Napi::String>().Utf8Value();
+            }
+        }
+        return ProbeJob::start(env, std::move(paths), std::move(options));
+    }
+
+    AudioPlayer::~AudioPlayer()
+    {
+        _completions->close();
     }
 
     void AudioPlayer::sendStatus(PlaybackEvent status, const std::string& message)
@@ -235,6 +656,24 @@ namespace CasperTech::interface
                 sendStatus(PlaybackEvent::Playing, "");
                 break;
             }
+            case EventType::Underrun:
+            {
+                auto evt = std::static_pointer_cast<UnderrunEvent>(event);
+                sendStatus(PlaybackEvent::Underrun, std::to_string(evt->count) + " underrun(s), " + std::to_string(evt->total) + " total, last at " + std::to_string(evt->lastUnderrunMs));
+                break;
+            }
+            case EventType::TrackChanged:
+            {
+                auto evt = std::static_pointer_cast<TrackChangedEvent>(event);
+                sendStatus(PlaybackEvent::TrackChanged, evt->fileName);
+                break;
+            }
+            case EventType::Seeked:
+            {
+                auto evt = std::static_pointer_cast<SeekedEvent>(event);
+                sendStatus(PlaybackEvent::Seeked, std::to_string(evt->positionMs));
+                break;
+            }
         }
     }
 }
\ No newline at end of file
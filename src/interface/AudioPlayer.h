@@ -5,7 +5,11 @@
 #include <enums/PlaybackEvent.h>
 #include <interfaces/IAudioPlayerEventReceiver.h>
 #include <structs/events/CommandEvent.h>
+#include <structs/PlayerOptions.h>
+#include <structs/PipelineStatsSnapshot.h>
 
+#include <functional>
+#include <memory>
 #include <mutex>
 
 namespace CasperTech
@@ -14,6 +18,8 @@ namespace CasperTech
 }
 namespace CasperTech::interface
 {
+    class CommandCompletions;
+
     class AudioPlayer: public Napi::ObjectWrap<AudioPlayer>, public IAudioPlayerEventReceiver
     {
         public:
@@ -24,15 +30,30 @@ namespace CasperTech::interface
             ~AudioPlayer() override;
 
         private:
+            static PlayerOptions parsePlayerOptions(const Napi::CallbackInfo& info);
+            static std::shared_ptr<const uint8_t> pinBuffer(Napi::Env env, const Napi::Buffer<uint8_t>& buffer);
+            static Napi::Object histogramToObject(Napi::Env env, const HistogramSnapshot& histogram);
             void sendStatus(PlaybackEvent status, const std::string& message);
+            // Returns a promise for command, which is given the callback to complete
+            Napi::Value queueCommand(Napi::Env env, const std::function<void(const ResultCallback& callback)>& command);
             Napi::Value load(const Napi::CallbackInfo& info);
+            Napi::Value loadBuffer(const Napi::CallbackInfo& info);
+            Napi::Value loadStream(const Napi::CallbackInfo& info);
+            Napi::Value enqueue(const Napi::CallbackInfo& info);
             Napi::Value play(const Napi::CallbackInfo& info);
             Napi::Value stop(const Napi::CallbackInfo& info);
             Napi::Value seek(const Napi::CallbackInfo& info);
             Napi::Value pause(const Napi::CallbackInfo& info);
             Napi::Value setVolume(const Napi::CallbackInfo& info);
+            Napi::Value setPlaybackRate(const Napi::CallbackInfo& info);
             Napi::Value setEventCallback(const Napi::CallbackInfo& info);
+            Napi::Value getStats(const Napi::CallbackInfo& info);
+            Napi::Value getPosition(const Napi::CallbackInfo& info);
+            static Napi::Value getClipCacheStats(const Napi::CallbackInfo& info);
+            static Napi::Value setClipCacheBudget(const Napi::CallbackInfo& info);
+            static Napi::Value probe(const Napi::CallbackInfo& info);
             std::shared_ptr<CasperTech::AudioPlayerImpl> _audioPlayer;
+            std::shared_ptr<CommandCompletions> _completions;
             std::mutex _statusCallbackMutex;
             Napi::ThreadSafeFunction _statusCallback;
             Napi::FunctionReference _statusCallbackRef;
@@ -0,0 +1,92 @@
+#include "CommandCompletions.h"
+
+namespace CasperTech::interface
+{
+    CommandCompletions::CommandCompletions(Napi::Env env)
+        : _settle(Napi::ThreadSafeFunction::New(
+                env,
+                Napi::Function::New(env, [](const Napi::CallbackInfo&){}),
+                "AudioPlayer command",
+                0,
+                1))
+    {
+        // Only referenced while a command is outstanding, as a pending fs call is
+        _settle.Unref(env);
+    }
+
+    ResultCallback CommandCompletions::add(const Napi::Promise::Deferred& deferred)
+    {
+        if (_pending.empty())
+        {
+            _settle.Ref(deferred.Env());
+        }
+        const uint64_t id = _nextId++;
+        _pending.emplace(id, deferred);
+        auto self = shared_from_this();
+        return [self, id](CommandResult result, const std::string& errorMessage)
+        {
+            self->complete(id, result, errorMessage);
+        };
+    }
+
+    void CommandCompletions::complete(uint64_t id, CommandResult result, const std::string& errorMessage)
+    {
+        std::unique_lock<std::mutex> lk(_completedMutex);
+        if (!_open)
+        {
+            return;
+        }
+        _completed.push_back(Completion{ id, result, errorMessage });
+        if (_signalled)
+        {
+            return;
+        }
+        _signalled = true;
+        auto self = shared_from_this();
+        _settle.NonBlockingCall([self](Napi::Env env, Napi::Function)
+        {
+            self->settle(env);
+        });
+    }
+
+    void CommandCompletions::settle(Napi::Env env)
+    {
+        {
+            std::unique_lock<std::mutex> lk(_completedMutex);
+            std::swap(_completed, _settling);
+            _signalled = false;
+        }
+        for(const Completion& completion: _settling)
+        {
+            auto it = _pending.find(completion.id);
+            if (it == _pending.end())
+            {
+                continue;
+            }
+            if (completion.result == CommandResult::Success || completion.result == CommandResult::Superseded)
+            {
+                it->second.Resolve(env.Undefined());
+            }
+            else
+            {
+                it->second.Reject(Napi::Error::New(env, completion.errorMessage).Value());
+            }
+            _pending.erase(it);
+        }
+        _settling.clear();
+        if (_pending.empty() && _open)
+        {
+            _settle.Unref(env);
+        }
+    }
+
+    void CommandCompletions::close()
+    {
+        std::unique_lock<std::mutex> lk(_completedMutex);
+        if (_open)
+        {
+            _open = false;
+            _settle.Release();
+        }
+    }
+}
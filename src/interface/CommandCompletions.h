@@ -0,0 +1,56 @@
+#pragma once
+
+#include <napi.h>
+
+#include <structs/events/CommandEvent.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CasperTech::interface
+{
+    // Settles the promises a player's commands return. Commands are queued from
+    // the JS thread and carried out on the player's control thread, which hands
+    // the result back here. A thread safe function then settles everything
+    // completed since its last call, so no threadpool thread waits on a command
+    // and a burst of completions wakes the JS thread once.
+    class CommandCompletions: public std::enable_shared_from_this<CommandCompletions>
+    {
+        public:
+            explicit CommandCompletions(Napi::Env env);
+
+            // JS thread. Returns the callback to give the player, which calls it
+            // once, from any thread. Keeps the process alive until it has been.
+            ResultCallback add(const Napi::Promise::Deferred& deferred);
+
+            // JS thread. Commands completing afterwards are never settled.
+            void close();
+
+        private:
+            struct Completion
+            {
+                uint64_t id;
+                CommandResult result;
+                std::string errorMessage;
+            };
+
+            void complete(uint64_t id, CommandResult result, const std::string& errorMessage);
+            void settle(Napi::Env env);
+
+            Napi::ThreadSafeFunction _settle;
+
+            std::mutex _completedMutex;
+            std::vector<Completion> _completed;
+            // A call to settle() is on its way and will pick up anything added
+            bool _signalled = false;
+            bool _open = true;
+
+            // JS thread only
+            std::vector<Completion> _settling;
+            std::unordered_map<uint64_t, Napi::Promise::Deferred> _pending;
+            uint64_t _nextId = 0;
+    };
+}
@@ -0,0 +1,117 @@
+#include "InputStream.h"
+
+#include <implementation/StreamReader.h>
+
+namespace CasperTech::interface
+{
+    void InputStream::Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "InputStream", {
+                InstanceMethod("write", &InputStream::write),
+                InstanceMethod("end", &InputStream::end),
+                InstanceMethod("abort", &InputStream::abort),
+                InstanceMethod("getBuffered", &InputStream::getBuffered)
+        });
+
+        exports.Set("InputStream", func);
+    }
+
+    InputStream::InputStream(const Napi::CallbackInfo& info)
+            : Napi::ObjectWrap<InputStream>(info)
+            , _drain(std::make_shared<DrainSignal>())
+    {
+        auto env = info.Env();
+        size_t bufferBytes = defaultBufferBytes;
+        if (info.Length() > 0 && !info[0].IsUndefined())
+        {
+            if (!info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 1)
+            {
+                throw Napi::Error::New(env, "bufferBytes must be a positive number");
+            }
+            bufferBytes = static_cast<size_t>(info[0].As<Napi::Number>().DoubleValue());
+        }
+        if (info.Length() < 2 || !info[1].IsFunction())
+        {
+            throw Napi::Error::New(env, "Must supply a drain callback");
+        }
+
+        // Stays referenced while the stream is open, as an open socket would
+        _drain->callback = Napi::ThreadSafeFunction::New(
+                env,
+                info[1].As<Napi::Function>(),
+                "InputStream drain",
+                0,
+                1
+        );
+        auto drain = _drain;
+        _reader = std::make_shared<StreamReader>(bufferBytes, [drain]
+        {
+            drain->call();
+        });
+    }
+
+    InputStream::~InputStream()
+    {
+        // A player may still be reading, but nobody is left to write
+        _reader->end();
+        _drain->close();
+    }
+
+    void InputStream::DrainSignal::call()
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        if (open)
+        {
+            callback.NonBlockingCall();
+        }
+    }
+
+    void InputStream::DrainSignal::close()
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        if (open)
+        {
+            open = false;
+            callback.Release();
+        }
+    }
+
+    const std::shared_ptr<StreamReader>& InputStream::getReader() const
+    {
+        return _reader;
+    }
+
+    // Returns how many bytes were taken. Fewer than offered means the buffer is
+    // full; the drain callback fires once there's room for the rest.
+    Napi::Value InputStream::write(const Napi::CallbackInfo& info)
+    {
+        auto env = info.Env();
+        if (info.Length() <= 0 || !info[0].IsBuffer())
+        {
+            throw Napi::Error::New(env, "Must supply a Buffer parameter");
+        }
+        auto buffer = info[0].As<Napi::Buffer<uint8_t>>();
+        const size_t written = _reader->write(buffer.Data(), buffer.Length());
+        return Napi::Number::New(env, static_cast<double>(written));
+    }
+
+    Napi::Value InputStream::end(const Napi::CallbackInfo& info)
+    {
+        _reader->end();
+        _drain->close();
+        return info.Env().Undefined();
+    }
+
+    // Fails the load or playback reading from this stream
+    Napi::Value InputStream::abort(const Napi::CallbackInfo& info)
+    {
+        _reader->interrupt();
+        _drain->close();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value InputStream::getBuffered(const Napi::CallbackInfo& info)
+    {
+        return Napi::Number::New(info.Env(), static_cast<double>(_reader->buffered()));
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <napi.h>
+
+#include <memory>
+#include <mutex>
+
+namespace CasperTech
+{
+    class StreamReader;
+}
+namespace CasperTech::interface
+{
+    // The native end of an AudioInputStream: JS writes a file into it as it
+    // arrives, and a player loads it with loadStream()
+    class InputStream: public Napi::ObjectWrap<InputStream>
+    {
+        public:
+            static void Init(Napi::Env env, Napi::Object exports);
+
+            // new InputStream(bufferBytes: number, onDrain: () => void)
+            explicit InputStream(const Napi::CallbackInfo& info);
+            ~InputStream() override;
+
+            [[nodiscard]] const std::shared_ptr<StreamReader>& getReader() const;
+
+        private:
+            // Drain is signalled from the decoding thread, and can arrive after JS
+            // has closed the stream, so the call and the release are serialised
+            struct DrainSignal
+            {
+                std::mutex mutex;
+                Napi::ThreadSafeFunction callback;
+                bool open = true;
+
+                void call();
+                void close();
+            };
+
+            static constexpr size_t defaultBufferBytes = 256 * 1024;
+
+            Napi::Value write(const Napi::CallbackInfo& info);
+            Napi::Value end(const Napi::CallbackInfo& info);
+            Napi::Value abort(const Napi::CallbackInfo& info);
+            Napi::Value getBuffered(const Napi::CallbackInfo& info);
+
+            std::shared_ptr<DrainSignal> _drain;
+            std::shared_ptr<StreamReader> _reader;
+    };
+}
@@ -0,0 +1,89 @@
+#include "ProbeJob.h"
+
+#include <implementation/MediaProbe.h>
+
+#include <exception>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace CasperTech::interface
+{
+    Napi::Promise ProbeJob::start(Napi::Env env, std::vector<std::string> paths, ProbeOptions options)
+    {
+        struct Job
+        {
+            explicit Job(Napi::Env env)
+                : deferred(Napi::Promise::Deferred::New(env))
+            {
+
+            }
+
+            Napi::Promise::Deferred deferred;
+            std::vector<MediaInfo> results;
+            std::string error;
+        };
+        auto job = std::make_shared<Job>(env);
+
+        // Referenced until the batch is done, so the process waits for it as it
+        // would for a pending fs call
+        Napi::ThreadSafeFunction settle = Napi::ThreadSafeFunction::New(
+                env,
+                Napi::Function::New(env, [](const Napi::CallbackInfo&){}),
+                "AudioPlayer probe",
+                0,
+                1);
+
+        std::thread([job, settle, paths = std::move(paths), options = std::move(options)]() mutable
+        {
+            try
+            {
+                job->results = MediaProbe::probe(paths, options);
+            }
+            catch(const std::exception& e)
+            {
+                job->error = e.what();
+            }
+            settle.BlockingCall([job](Napi::Env env, Napi::Function)
+            {
+                if (!job->error.empty())
+                {
+                    job->deferred.Reject(Napi::Error::New(env, job->error).Value());
+                    return;
+                }
+                auto results = Napi::Array::New(env, job->results.size());
+                for(uint32_t i = 0; i < job->results.size(); i++)
+                {
+                    results.Set(i, infoToObject(env, job->results[i]));
+                }
+                job->deferred.Resolve(results);
+            });
+            settle.Release();
+        }).detach();
+
+        return job->deferred.Promise();
+    }
+
+    Napi::Object ProbeJob::infoToObject(Napi::Env env, const MediaInfo& info)
+    {
+        auto result = Napi::Object::New(env);
+        result.Set("path", Napi::String::New(env, info.path));
+        if (!info.error.empty())
+        {
+            result.Set("error", Napi::String::New(env, info.error));
+            return result;
+        }
+        result.Set("durationMs", Napi::Number::New(env, static_cast<double>(info.durationMs)));
+        result.Set("codec", Napi::String::New(env, info.codec));
+        result.Set("sampleRate", Napi::Number::New(env, info.sampleRate));
+        result.Set("channels", Napi::Number::New(env, info.channels));
+        result.Set("bitRate", Napi::Number::New(env, static_cast<double>(info.bitRate)));
+        auto tags = Napi::Object::New(env);
+        for(const auto& [name, value]: info.tags)
+        {
+            tags.Set(name, Napi::String::New(env, value));
+        }
+        result.Set("tags", tags);
+        return result;
+    }
+}
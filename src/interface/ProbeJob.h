@@ -0,0 +1,26 @@
+#pragma once
+
+#include <napi.h>
+
+#include <structs/MediaInfo.h>
+#include <structs/ProbeOptions.h>
+
+#include <string>
+#include <vector>
+
+namespace CasperTech::interface
+{
+    // Runs a MediaProbe batch for AudioPlayer.probe(). The batch gets a thread of
+    // its own rather than a threadpool one, since a large library keeps it busy
+    // for minutes and fs calls share the threadpool, and its results are handed
+    // back through a thread safe function.
+    class ProbeJob
+    {
+        public:
+            // JS thread. Returns a promise for the MediaInfo of each path, in order.
+            static Napi::Promise start(Napi::Env env, std::vector<std::string> paths, ProbeOptions options);
+
+        private:
+            static Napi::Object infoToObject(Napi::Env env, const MediaInfo& info);
+    };
+}
@@ -19,4 +19,14 @@ namespace CasperTech
     {
         _source.reset();
     }
+
+    void IAudioSink::replaceSource(const std::shared_ptr<IAudioSource>& source)
+    {
+        _source = source;
+    }
+
+    void IAudioSink::setStats(const std::shared_ptr<PipelineStats>& stats)
+    {
+        _stats = stats;
+    }
 }
@@ -2,21 +2,43 @@
 
 #include "IAudioNode.h"
 
+#include <structs/RingSpans.h>
+
 namespace CasperTech
 {
     class IAudioSource;
+    struct PipelineStats;
     class IAudioSink: public IAudioNode
     {
         public:
             virtual ~IAudioSink() = default;
             virtual void setSource(const std::shared_ptr<IAudioSource>& source, SampleFormatFlags fmt, uint32_t sampleRate, uint8_t channels);
+            // The buffers belong to the caller for the duration of the call. Filters
+            // may modify them in place before passing them on; sinks must not keep them.
             virtual void audio(const uint8_t* buffer, const uint8_t* planarChannel, uint64_t sampleCount) = 0;
+
+            // Optional zero-copy path for packed formats. A sink that owns its output
+            // memory can hand up to sampleCount samples of it to the upstream node, which
+            // writes into the spans and then commits what it wrote. Returns false if the
+            // sink doesn't support it, in which case audio() must be used instead.
+            virtual bool reserve(uint64_t sampleCount, RingSpans& spans){ return false; }
+            virtual void commit(uint64_t sampleCount){}
+
             virtual void onSourceConfigured(){}
             virtual void onEos() = 0;
+
+            // Drops audio accepted but not yet played, so a renderer that outlives its
+            // source goes quiet straight away instead of finishing the old track
+            virtual void flush(){}
             virtual void disconnectSource();
+            // Swaps in a source producing the format already negotiated, without
+            // reconfiguring. See IAudioSource::handOver.
+            void replaceSource(const std::shared_ptr<IAudioSource>& source);
+            virtual void setStats(const std::shared_ptr<PipelineStats>& stats);
 
         protected:
             std::shared_ptr<IAudioSource> _source;
+            std::shared_ptr<PipelineStats> _stats;
             SampleFormatFlags _sourceFormat = SampleFormatFlags::None;
             uint32_t _sourceSampleRate = 0;
             uint8_t _sourceChannels = 0;
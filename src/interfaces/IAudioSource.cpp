@@ -96,6 +96,29 @@ namespace CasperTech
         }
     }
 
+    bool IAudioSource::handOver(const std::shared_ptr<IAudioSource>& next)
+    {
+        std::unique_lock<std::mutex> sinkLock(_sinkMutex);
+        if (!_sink || (next->getSupportedSampleFormats() & _sinkFormat) != _sinkFormat)
+        {
+            return false;
+        }
+        const auto rates = next->getSupportedSampleRates();
+        if (std::find(rates.begin(), rates.end(), _sinkSampleRate) == rates.end()
+            || next->getSupportedChannels() != _sinkChannels)
+        {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> nextLock(next->_sinkMutex);
+        next->_sinkFormat = _sinkFormat;
+        next->_sinkSampleRate = _sinkSampleRate;
+        next->_sinkChannels = _sinkChannels;
+        next->_sink = std::move(_sink);
+        next->_sink->replaceSource(next);
+        return true;
+    }
+
     void IAudioSource::eos()
     {
         if (_sink)
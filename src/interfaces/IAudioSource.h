@@ -15,6 +15,12 @@ namespace CasperTech
             virtual ~IAudioSource() = default;
             virtual void connectSink(const std::shared_ptr<IAudioSink>& sink);
             virtual void disconnectSink();
+
+            // Passes this source's sink to next, which carries on the same stream
+            // without renegotiating, so nothing downstream is reset or drained. Only
+            // possible when next produces exactly the negotiated format, rate and
+            // channels; returns false, changing nothing, otherwise.
+            bool handOver(const std::shared_ptr<IAudioSource>& next);
             virtual void onSinkConfigured(){};
             virtual void eos();
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    // Supplies a file's bytes to FFSource when they aren't on disk. Called on
+    // whichever thread is opening or decoding the source.
+    class IByteReader
+    {
+        public:
+            virtual ~IByteReader() = default;
+
+            // Copies up to size bytes into buffer. Returns the number copied, or
+            // AVERROR_EOF at the end of the input.
+            virtual int read(uint8_t* buffer, int size) = 0;
+
+            // As AVIOContext's seek callback: whence is SEEK_SET, SEEK_CUR or SEEK_END,
+            // or AVSEEK_SIZE to ask for the total length. Returns the new position,
+            // or a negative AVERROR. Only called when isSeekable().
+            virtual int64_t seek(int64_t offset, int whence) = 0;
+
+            [[nodiscard]] virtual bool isSeekable() const = 0;
+
+            // Makes a read waiting for input return AVERROR_EXIT, and every read
+            // after it, so the thread decoding can be stopped. Called from any thread.
+            virtual void interrupt(){}
+    };
+}
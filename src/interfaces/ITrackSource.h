@@ -0,0 +1,31 @@
+#pragma once
+
+#include "IAudioSource.h"
+
+#include <memory>
+#include <string>
+
+namespace CasperTech
+{
+    struct FFFrame;
+    struct PipelineStats;
+
+    // A whole track the play thread pulls through the chain a packet at a time
+    class ITrackSource: public IAudioSource
+    {
+        public:
+            // Passes the next packet's audio to the sink. Returns 0 at the end of the
+            // track, having rewound to the start, or a negative AVERROR. frame is
+            // scratch space for sources that decode.
+            virtual int getPacket(FFFrame* frame) = 0;
+            // Returns the position playback carries on from, in ms, which is short of
+            // timeMs past the end of the track. A negative AVERROR if the source
+            // can't seek, in which case it carries on from where it was.
+            virtual int64_t seek(uint64_t timeMs) = 0;
+            virtual void setStats(const std::shared_ptr<PipelineStats>& stats) = 0;
+            [[nodiscard]] virtual const std::string& getFileName() const = 0;
+            // Stops a getPacket() waiting on slow input, which then fails. The source
+            // is finished with afterwards. Called from any thread.
+            virtual void interrupt(){}
+    };
+}
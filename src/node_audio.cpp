@@ -1,9 +1,11 @@
 #include <napi.h>
 #include "interface/AudioPlayer.h"
+#include "interface/InputStream.h"
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports)
 {
     CasperTech::interface::AudioPlayer::Init(env, exports);
+    CasperTech::interface::InputStream::Init(env, exports);
     return exports;
 }
 
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct ClipCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t budgetBytes = 0;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CasperTech
+{
+    // What MediaProbe learned about a file, without opening a decoder for it
+    struct MediaInfo
+    {
+        std::string path;
+        // Why the file couldn't be probed, in which case the rest is empty
+        std::string error;
+        uint64_t durationMs = 0;
+        // FFmpeg's name for the audio codec, e.g. "mp3" or "flac"
+        std::string codec;
+        uint32_t sampleRate = 0;
+        uint32_t channels = 0;
+        // Bits per second, 0 if the container doesn't say
+        int64_t bitRate = 0;
+        // The container's tags, then any the audio stream adds, which is where
+        // Ogg keeps them
+        std::vector<std::pair<std::string, std::string>> tags;
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    // How a player's loads open their input. The defaults are FFmpeg's own, which
+    // for some containers read and decode megabytes before playback can start.
+    struct OpenOptions
+    {
+        // How long opening the input and reading its header may take, then probing
+        // its streams, before the load fails with a LoadError. 0 waits as long as
+        // it takes.
+        uint32_t openTimeoutMs = 0;
+        uint32_t probeTimeoutMs = 0;
+
+        // Most bytes probing the streams reads, 0 for FFmpeg's default (5MB)
+        int64_t probeSize = 0;
+        // Most of the stream probing decodes, 0 for FFmpeg's default (5s)
+        uint32_t analyzeDurationMs = 0;
+        // Skips probing the streams for containers whose header says everything
+        // playback needs (WAV, FLAC, Ogg, MP4/M4A), falling back to it when it
+        // doesn't. A load also leaves opening the decoder to the start of
+        // playback, so a codec that can't be opened is a playback error rather
+        // than a failed load.
+        bool skipStreamInfo = false;
+        // Files are opened as the container their extension names rather than
+        // probed, and probed after all if that fails
+        bool formatFromExtension = false;
+    };
+}
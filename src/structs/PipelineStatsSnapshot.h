@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct HistogramSnapshot
+    {
+        uint64_t count = 0;
+        uint64_t minNs = 0;
+        uint64_t maxNs = 0;
+        double meanNs = 0.0;
+        uint64_t p50Ns = 0;
+        uint64_t p90Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t p999Ns = 0;
+    };
+
+    struct PipelineStatsSnapshot
+    {
+        // Time spent in each stage itself, excluding the downstream stages it calls
+        HistogramSnapshot decode;
+        // Handing decoded frames to the read-ahead queue, including waiting for room
+        HistogramSnapshot readAhead;
+        HistogramSnapshot volume;
+        HistogramSnapshot resample;
+        HistogramSnapshot rate;
+        HistogramSnapshot render;
+        HistogramSnapshot callback;
+
+        uint64_t frames = 0;
+        uint64_t samples = 0;
+        uint64_t callbacks = 0;
+        uint64_t underruns = 0;
+        uint64_t ringFillBytes = 0;
+        uint64_t ringCapacityBytes = 0;
+        // Wall clock time of the most recent underrun in ms since the unix epoch, 0 if none
+        uint64_t lastUnderrunMs = 0;
+        // Decoded audio queued ahead of the rest of the pipeline, 0 capacity if disabled
+        uint64_t readAheadFrames = 0;
+        uint64_t readAheadMs = 0;
+        uint64_t readAheadCapacityMs = 0;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "OpenOptions.h"
+#include "RendererOptions.h"
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct PlayerOptions
+    {
+        RendererOptions renderer;
+
+        // How far ahead of the output the decoder may run, on a thread of its own.
+        // 0 decodes on the play thread, in step with the output.
+        uint32_t readAheadMs = 500;
+
+        // Files no longer than this are decoded in full on first load and kept in
+        // the process wide ClipCache in the output's format, so loading them again
+        // skips opening, decoding and resampling. 0 disables.
+        uint32_t clipCacheMaxMs = 0;
+
+        // Loads open on a thread of their own, so stop() or another load cancels
+        // them whatever the timeouts
+        OpenOptions open;
+    };
+}
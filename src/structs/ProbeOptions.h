@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace CasperTech
+{
+    struct ProbeOptions
+    {
+        // Files probed at once. 0 for one per core.
+        uint32_t threads = 0;
+        // Results are kept here between runs, and a file unchanged since it was
+        // last probed isn't opened again. Empty keeps nothing.
+        std::string cacheFile;
+    };
+}
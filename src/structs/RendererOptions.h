@@ -0,0 +1,21 @@
+#pragma once
+
+#include <enums/ClockMode.h>
+#include <enums/RendererType.h>
+
+#include <string>
+
+namespace CasperTech
+{
+    struct RendererOptions
+    {
+        RendererType type = RendererType::RtAudio;
+
+        // Only used by the headless renderers
+        ClockMode clockMode = ClockMode::RealTime;
+
+        // Output path for RendererType::File. A .wav extension writes a WAV file,
+        // anything else writes raw interleaved PCM.
+        std::string fileName;
+    };
+}
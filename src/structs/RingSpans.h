@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct RingSpan
+    {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // A region of a ring buffer. It wraps at most once, so it is described by at most
+    // two contiguous spans; second is empty when the region doesn't wrap.
+    struct RingSpans
+    {
+        RingSpan first;
+        RingSpan second;
+
+        [[nodiscard]] size_t size() const
+        {
+            return first.size + second.size;
+        }
+    };
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <structs/events/CommandEvent.h>
+
+namespace CasperTech
+{
+    struct EnqueueCommand: public CommandEvent
+    {
+        EnqueueCommand()
+            : CommandEvent(Command::Enqueue)
+        {
+
+        }
+
+        std::string fileName;
+    };
+}
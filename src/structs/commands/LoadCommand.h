@@ -1,6 +1,9 @@
 #pragma once
 
 #include <structs/events/CommandEvent.h>
+#include <interfaces/IByteReader.h>
+
+#include <memory>
 
 namespace CasperTech
 {
@@ -13,5 +16,7 @@ namespace CasperTech
         }
 
         std::string fileName;
+        // Read from in place of the file when set, leaving fileName only to name it
+        std::shared_ptr<IByteReader> reader;
     };
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <structs/events/CommandEvent.h>
+
+#include <enums/PlaybackRateMode.h>
+
+namespace CasperTech
+{
+    struct SetPlaybackRateCommand: public CommandEvent
+    {
+        SetPlaybackRateCommand()
+                : CommandEvent(Command::SetPlaybackRate)
+        {
+
+        }
+
+        double rate = 1.0;
+        PlaybackRateMode mode = PlaybackRateMode::TimeStretch;
+    };
+}
\ No newline at end of file
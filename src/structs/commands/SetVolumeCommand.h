@@ -2,6 +2,8 @@
 
 #include <structs/events/CommandEvent.h>
 
+#include <enums/VolumeCurve.h>
+
 namespace CasperTech
 {
     struct SetVolumeCommand: public CommandEvent
@@ -13,5 +15,7 @@ namespace CasperTech
         }
 
         float volume = 1.0;
+        uint32_t rampMs = 0;
+        VolumeCurve curve = VolumeCurve::Linear;
     };
 }
\ No newline at end of file
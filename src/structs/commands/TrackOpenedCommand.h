@@ -0,0 +1,34 @@
+#pragma once
+
+#include <structs/events/CommandEvent.h>
+#include <structs/commands/EnqueueCommand.h>
+#include <structs/commands/LoadCommand.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace CasperTech
+{
+    class ITrackSource;
+
+    // Posted back to the control thread by the thread that opened a load's or an
+    // enqueue's file. One of load and enqueue is set.
+    struct TrackOpenedCommand: public CommandEvent
+    {
+        TrackOpenedCommand()
+                : CommandEvent(Command::TrackOpened)
+        {
+
+        }
+
+        std::shared_ptr<LoadCommand> load;
+        std::shared_ptr<EnqueueCommand> enqueue;
+        // Set when the open succeeded
+        std::shared_ptr<ITrackSource> source;
+        bool converterBypassed = false;
+        CommandResult result = CommandResult::Success;
+        std::string errorMessage;
+        std::thread::id openThread;
+    };
+}
@@ -22,5 +22,7 @@ namespace CasperTech
 
         Command commandType;
         ResultCallback completionEvent;
+        // Set under the player's event lock when a newer command takes its place
+        bool superseded = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <structs/PlayerEvent.h>
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct SeekedEvent: public PlayerEvent
+    {
+        explicit SeekedEvent(uint64_t requestedMs, uint64_t positionMs)
+                : PlayerEvent(EventType::Seeked)
+                , requestedMs(requestedMs)
+                , positionMs(positionMs)
+        {
+
+        }
+
+        uint64_t requestedMs;
+        // Where playback carries on from, which is short of requestedMs when that
+        // was past the end
+        uint64_t positionMs;
+    };
+}
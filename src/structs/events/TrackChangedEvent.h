@@ -0,0 +1,22 @@
+#pragma once
+
+#include <structs/PlayerEvent.h>
+
+#include <string>
+#include <utility>
+
+namespace CasperTech
+{
+    struct TrackChangedEvent: public PlayerEvent
+    {
+        explicit TrackChangedEvent(std::string fileName)
+                : PlayerEvent(EventType::TrackChanged)
+                , fileName(std::move(fileName))
+        {
+
+        }
+
+        // The enqueued track that has just taken over
+        std::string fileName;
+    };
+}
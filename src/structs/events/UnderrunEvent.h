@@ -0,0 +1,25 @@
+#pragma once
+
+#include <structs/PlayerEvent.h>
+
+#include <cstdint>
+
+namespace CasperTech
+{
+    struct UnderrunEvent: public PlayerEvent
+    {
+        explicit UnderrunEvent(uint64_t count, uint64_t total, uint64_t lastUnderrunMs)
+                : PlayerEvent(EventType::Underrun)
+                , count(count)
+                , total(total)
+                , lastUnderrunMs(lastUnderrunMs)
+        {
+
+        }
+
+        // Underruns since the previous UnderrunEvent, and since the player was created
+        uint64_t count;
+        uint64_t total;
+        uint64_t lastUnderrunMs;
+    };
+}